@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+Fork-server for text analyzer workers
+
+Usage: analyzer_server.py SOCKET_PATH
+
+The zygote imports textstat and spaCy and loads the model once, then
+listens on a Unix socket. Every accepted connection is served by a child
+forked from the zygote, so a new worker starts in milliseconds and shares
+the loaded model pages copy-on-write. A worker greets its connection with
+"ready", then reads one JSON request per line and writes one JSON response
+per line until the connection closes.
+
+The zygote prints "ready" once it accepts connections and exits when its
+stdin is closed (the owning process stopped or died).
+"""
+
+import gc
+import json
+import os
+import select
+import signal
+import socket
+import sys
+
+from text_analyzer import TextAnalyzer
+
+
+def handle_request(analyzer: TextAnalyzer, data) -> dict:
+    """Same dispatch as the one-shot subprocess call of the C++ TextAnalyzer"""
+    text = data.get('text', '') if isinstance(data, dict) else ''
+    if not text:
+        return {'error': 'No text provided in JSON'}
+    try:
+        if data.get('mode') == 'aggregate':
+            return analyzer.partial_aggregates(text, data.get('metrics'))
+        return analyzer.analyze(text, data.get('metrics'))
+    except Exception as e:
+        return {'error': 'Python analysis failed: ' + str(e)}
+
+
+def serve_connection(analyzer: TextAnalyzer, conn: socket.socket) -> None:
+    """Worker loop: one request line in, one response line out"""
+    with conn, conn.makefile('rb') as reader:
+        conn.sendall(b'ready\n')
+        for line in reader:
+            try:
+                result = handle_request(analyzer, json.loads(line))
+            except ValueError as e:
+                result = {'error': 'Invalid request: ' + str(e)}
+            try:
+                response = json.dumps(result, ensure_ascii=False, separators=(',', ':'))
+            except Exception:
+                response = '{"error": "JSON serialization failed"}'
+            conn.sendall(response.encode('utf-8') + b'\n')
+
+
+def main() -> None:
+    if len(sys.argv) != 2:
+        sys.stdout.write('usage: analyzer_server.py SOCKET_PATH\n')
+        sys.exit(2)
+    socket_path = sys.argv[1]
+
+    analyzer = TextAnalyzer()
+    # Keep the collector from writing to the inherited objects, so their pages stay shared
+    gc.collect()
+    if hasattr(gc, 'freeze'):
+        gc.freeze()
+
+    if os.path.exists(socket_path):
+        os.unlink(socket_path)
+    listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    listener.bind(socket_path)
+    listener.listen(64)
+
+    # Exited workers are reaped by the kernel
+    signal.signal(signal.SIGCHLD, signal.SIG_IGN)
+
+    sys.stdout.write('ready\n')
+    sys.stdout.flush()
+    devnull = os.open(os.devnull, os.O_WRONLY)
+    os.dup2(devnull, 1)
+
+    try:
+        while True:
+            readable, _, _ = select.select([listener, sys.stdin], [], [])
+            if sys.stdin in readable and not os.read(sys.stdin.fileno(), 1):
+                break
+            if listener not in readable:
+                continue
+            conn, _ = listener.accept()
+            if os.fork() == 0:
+                listener.close()
+                signal.signal(signal.SIGCHLD, signal.SIG_DFL)
+                try:
+                    serve_connection(analyzer, conn)
+                finally:
+                    os._exit(0)
+            conn.close()
+    finally:
+        listener.close()
+        if os.path.exists(socket_path):
+            os.unlink(socket_path)
+
+
+if __name__ == '__main__':
+    main()
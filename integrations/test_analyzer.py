@@ -146,6 +146,26 @@ class TestTextAnalyzer:
         assert metadata["processing_time_seconds"] >= 0
         assert metadata["text_length_characters"] > 0
     
+    def test_metric_projection(self, analyzer):
+        """Test that only the requested metrics are computed"""
+        result = analyzer.analyze(QUANTUM_TEXT, ["gunning_fog_index", "word_count"])
+        
+        assert "error" not in result
+        assert set(result) == {"gunning_fog_index", "word_count", "metadata"}
+        assert result["metadata"]["metrics"] == ["gunning_fog_index", "word_count"]
+        # The spaCy parse is not needed for these metrics
+        assert "spacy_doc" not in result["metadata"]["intermediates"]
+        
+        # Projected values match the full analysis
+        full = analyzer.analyze(QUANTUM_TEXT)
+        assert result["gunning_fog_index"] == full["gunning_fog_index"]
+        assert result["word_count"] == full["word_count"]
+    
+    def test_unknown_metric(self, analyzer):
+        """Test that an unknown metric name is reported"""
+        result = analyzer.analyze(SIMPLE_TEXT, ["reading_time"])
+        assert "error" in result
+    
     def test_json_serializable(self, analyzer):
         """Test that result is JSON serializable"""
         result = analyzer.analyze(QUANTUM_TEXT)
@@ -14,7 +14,7 @@ import time
 import tomli
 import os
 import warnings
-from typing import Dict, Any, Optional
+from typing import Dict, Any, Iterable, List, Optional
 from pathlib import Path
 
 # ====== CRITICAL: Suppress ALL warnings before anything else ======
@@ -127,15 +127,18 @@ class TextAnalyzer:
         else:
             self.nlp = None
     
-    def analyze(self, text: str) -> Dict[str, Any]:
+    def analyze(self, text: str, metrics: Optional[Iterable[str]] = None) -> Dict[str, Any]:
         """
-        Analyze text and return all computed metrics
+        Analyze text and return the computed metrics
         
         Args:
             text: Input text for analysis
+            metrics: Names of the metrics to compute (see METRICS); None computes all.
+                Only the intermediates the requested metrics depend on are computed,
+                each once.
             
         Returns:
-            Dictionary with all computed metrics
+            Dictionary with the computed metrics
         """
         if not text or not text.strip():
             return {"error": "Empty text provided"}
@@ -145,31 +148,20 @@ class TextAnalyzer:
         if len(text) > max_length:
             text = text[:max_length]
         
+        try:
+            selected = select_metrics(metrics)
+        except ValueError as e:
+            return {"error": str(e)}
+        
         try:
             start_time = time.time()
+            features = TextFeatures(text, self.nlp)
             
-            # Create spaCy document if model is loaded
-            spacy_doc = self.nlp(text) if self.nlp else None
-            
-            # Compute all metrics
             result = {}
-            
-            # 1. Readability metrics using textstat (always works)
-            if textstat:
-                result.update(self._compute_readability_metrics(text))
-            
-            # 2. Basic text statistics
-            result.update(self._compute_basic_stats(text))
-            
-            # 3. Structural metrics
-            result.update(self._compute_structural_metrics(text))
-            
-            # 4. Lexical metrics
-            result.update(self._compute_lexical_metrics(text))
-            
-            # 5. Autism support metrics (requires spaCy)
-            if spacy_doc:
-                result.update(self._compute_autism_metrics(spacy_doc))
+            for name in selected:
+                value = compute_metric(name, features)
+                if value is not None:
+                    result[name] = value
             
             # Add metadata
             result["metadata"] = {
@@ -177,168 +169,285 @@ class TextAnalyzer:
                 "text_length_characters": len(text),
                 "text_length_words": len(text.split()),
                 "language": self.config['system']['default_language'],
-                "spacy_available": spacy_doc is not None
+                "spacy_available": self.nlp is not None,
             }
-            
-            # Remove any empty/None values
-            result = {k: v for k, v in result.items() if v is not None and v != {}}
+            if metrics is not None:
+                result["metadata"]["metrics"] = selected
+                result["metadata"]["intermediates"] = features.computed()
             
             return result
             
         except Exception as e:
             return {"error": f"Analysis failed: {str(e)}"}
     
-    def _compute_readability_metrics(self, text: str) -> Dict[str, Any]:
-        """Compute readability metrics using textstat"""
+    def partial_aggregates(self, text: str, metrics: Optional[Iterable[str]] = None) -> Dict[str, Any]:
+        """
+        Additive statistics of one chunk of a larger document
+
+        The C++ TextAnalyzer splits large documents at paragraph breaks that
+        follow a sentence end, collects these aggregates per chunk and applies
+        textstat's formulas, with textstat's rounding, to the merged counts
+        (see src/core/TextAggregates.hpp). Every count is the exact input of a
+        textstat formula, so the merged result equals analyze() on the whole
+        text. No length limit is applied: the C++ side truncates the document
+        to max_text_length before splitting it.
+
+        Args:
+            text: One chunk (whole paragraphs)
+            metrics: Metrics the merged result needs; None collects everything.
+                Difficult words, Linsear Write and spaCy counts are skipped
+                when no requested metric uses them.
+
+        Returns:
+            Dictionary of counts, word and sentence-length sequences
+        """
+        if not text or not text.strip():
+            return {"error": "Empty text provided"}
+
         try:
-            if not textstat:
-                return {}
-            return {
-                # Core readability metrics
-                "flesch_kincaid_grade": textstat.flesch_kincaid_grade(text),
-                "flesch_reading_ease": textstat.flesch_reading_ease(text),
-                "gunning_fog_index": textstat.gunning_fog(text),
-                "smog_index": textstat.smog_index(text),
-                "automated_readability_index": textstat.automated_readability_index(text),
-                "coleman_liau_index": textstat.coleman_liau_index(text),
-                "dale_chall_score": textstat.dale_chall_readability_score(text),
-                "linsear_write_score": textstat.linsear_write_formula(text),
-                
-                # Additional readability metrics
-                "difficult_word_count": textstat.difficult_words(text),
-                "text_standard": textstat.text_standard(text),
-            }
-        except Exception:
-            return {}
-    
-    def _compute_basic_stats(self, text: str) -> Dict[str, Any]:
-        """Compute basic text statistics"""
+            selected = set(select_metrics(metrics))
+        except ValueError as e:
+            return {"error": str(e)}
+
         try:
+            features = TextFeatures(text, self.nlp)
+            words = features.get("lower_words")
+            sentences = features.get("sentences")
+
+            result = {
+                "words": words,
+                "sentence_lengths": [len(s.split()) for s in sentences],
+                "paragraph_count": len(features.get("paragraphs")),
+                "list_item_count": len(features.get("list_items")),
+                "has_headings": bool(HEADING_PATTERN.search(text)),
+                "has_lists": bool(features.get("list_items")),
+            }
+
             if textstat:
-                return {
-                    "character_count": textstat.char_count(text),
-                    "letter_count": textstat.letter_count(text),
-                    "syllable_count": textstat.syllable_count(text),
-                    "word_count": textstat.lexicon_count(text),
-                    "sentence_count": textstat.sentence_count(text),
-                    "polysyllable_count": textstat.polysyllabcount(text),
-                }
+                result.update({
+                    "character_count": features.get("character_count"),
+                    "letter_count": features.get("letter_count"),
+                    "syllable_count": features.get("syllable_count"),
+                    "word_count": features.get("lexicon_count"),
+                    # Without textstat's floor of 1, which applies to the whole document
+                    "sentence_count": textstat_sentence_matches(text),
+                    "polysyllable_count": features.get("polysyllable_count"),
+                })
+                if selected & DIFFICULT_WORD_METRICS:
+                    # Every word outside the easy-word list with its syllables: the formulas
+                    # count them against different syllable thresholds
+                    result["difficult_words"] = {
+                        word: textstat.syllable_count(word)
+                        for word in textstat.difficult_words_list(text, syllable_threshold=0)
+                    }
+                if selected & {"linsear_write_score", "text_standard"}:
+                    # Only meaningful for the first chunk: the formula reads the first 100 words
+                    result["linsear_write_score"] = textstat.linsear_write_formula(text)
             else:
-                # Fallback to simple calculations
-                words = text.split()
-                sentences = [s.strip() for s in re.split(r'[.!?]+', text) if s.strip()]
-                return {
+                result.update({
                     "character_count": len(text),
                     "word_count": len(words),
                     "sentence_count": len(sentences),
-                }
-        except Exception:
-            # Fallback to simple calculations
-            words = text.split()
-            sentences = [s.strip() for s in re.split(r'[.!?]+', text) if s.strip()]
-            return {
-                "character_count": len(text),
-                "word_count": len(words),
-                "sentence_count": len(sentences),
-            }
-    
-    def _compute_structural_metrics(self, text: str) -> Dict[str, Any]:
-        """Compute structural complexity metrics"""
-        try:
-            paragraphs = [p for p in text.split('\n\n') if p.strip()]
-            sentences = [s.strip() for s in re.split(r'[.!?]+', text) if s.strip()]
-            
-            if not sentences:
-                return {}
-            
-            # Detect structural elements
-            heading_pattern = re.compile(r'^#{1,3}\s+', re.MULTILINE)
-            list_pattern = re.compile(r'^[\s]*[-*•]\s|^\d+[\.\)]\s', re.MULTILINE)
-            
-            avg_paragraph_words = len(text.split()) / len(paragraphs) if paragraphs else 0
-            
-            return {
-                "paragraph_count": len(paragraphs),
-                "paragraph_sentence_ratio": len(paragraphs) / len(sentences) if sentences else 0,
-                "has_headings": bool(heading_pattern.search(text)),
-                "has_lists": bool(list_pattern.search(text)),
-                "list_item_count": len(list_pattern.findall(text)),
-                "average_paragraph_length_words": avg_paragraph_words,
-            }
-        except Exception:
-            return {}
-    
-    def _compute_lexical_metrics(self, text: str) -> Dict[str, Any]:
-        """Compute lexical diversity metrics"""
-        try:
-            words = [w.lower() for w in text.split() if w.strip()]
-            if not words:
-                return {}
-            
-            unique_words = len(set(words))
-            total_words = len(words)
-            
-            result = {
-                "type_token_ratio": unique_words / total_words,
-                "unique_word_count": unique_words,
-                "unique_word_ratio": unique_words / total_words,
-            }
-            
-            # Approximate lexical diversity metrics for long texts
-            if total_words >= 50:  # Minimum for meaningful MTLD-like calculation
-                # Simple approximation of lexical diversity
-                segments = []
-                segment_size = 10
-                for i in range(0, total_words, segment_size):
-                    segment = words[i:i + segment_size]
-                    if segment:
-                        segments.append(len(set(segment)) / len(segment))
-                
-                if segments:
-                    result["lexical_diversity_score"] = sum(segments) / len(segments)
-            
+                })
+
+            # The spaCy sentence count also replaces sentence_count, as in analyze()
+            if selected & (AUTISM_METRICS | {"sentence_count"}) and features.get("spacy_doc") is not None:
+                result.update(features.get("autism_counts"))
+
             return result
-        except Exception:
-            return {}
-    
-    def _compute_autism_metrics(self, spacy_doc) -> Dict[str, Any]:
-        """Compute autism-relevant linguistic metrics"""
-        try:
-            # Count pronouns and determiners
-            pronouns = sum(1 for token in spacy_doc if token.pos_ == "PRON")
-            determiners = sum(1 for token in spacy_doc if token.pos_ == "DET")
-            
-            # Content tokens (exclude punctuation, spaces, symbols)
-            content_tokens = [
-                token for token in spacy_doc 
-                if token.pos_ not in ("PUNCT", "SPACE", "SYM")
-            ]
-            token_count = len(content_tokens)
-            
-            if token_count == 0:
-                return {}
-            
-            # Count anaphora (pronouns with morphological features)
-            anaphora_count = 0
-            for token in spacy_doc:
-                if token.pos_ == "PRON":
-                    morph = token.morph.to_dict()
-                    if any(key in morph for key in ['Person', 'Number', 'Case']):
-                        anaphora_count += 1
-                elif token.pos_ == "DET" and token.dep_ != "det":
-                    morph = token.morph.to_dict()
-                    if morph.get('PronType') == 'Dem':
-                        anaphora_count += 1
-            
-            return {
-                "pronoun_density": pronouns / token_count,
-                "determiner_density": determiners / token_count,
-                "anaphora_density": anaphora_count / token_count,
-                "content_token_count": token_count,
-                "sentence_count": len(list(spacy_doc.sents)),
-            }
-        except Exception:
-            return {}
+
+        except Exception as e:
+            return {"error": f"Analysis failed: {str(e)}"}
+
+
+# ====== METRIC DEPENDENCY GRAPH ======
+#
+# Every metric reads named intermediates from TextFeatures, which computes each
+# intermediate on first use and caches it, so shared inputs (word list,
+# sentences, syllables, the spaCy parse) are computed once per text and
+# intermediates no requested metric reaches are never computed. textstat caches
+# its own counts per text as well, so formulas share syllable and word counts.
+
+HEADING_PATTERN = re.compile(r'^#{1,3}\s+', re.MULTILINE)
+LIST_PATTERN = re.compile(r'^[\s]*[-*•]\s|^\d+[\.\)]\s', re.MULTILINE)
+
+
+def count_autism_tokens(spacy_doc) -> Dict[str, Any]:
+    """Raw token counts behind the autism metrics (additive across chunks)"""
+    pronouns = sum(1 for token in spacy_doc if token.pos_ == "PRON")
+    determiners = sum(1 for token in spacy_doc if token.pos_ == "DET")
+    content_tokens = sum(
+        1 for token in spacy_doc
+        if token.pos_ not in ("PUNCT", "SPACE", "SYM")
+    )
+
+    anaphora_count = 0
+    for token in spacy_doc:
+        if token.pos_ == "PRON":
+            morph = token.morph.to_dict()
+            if any(key in morph for key in ['Person', 'Number', 'Case']):
+                anaphora_count += 1
+        elif token.pos_ == "DET" and token.dep_ != "det":
+            morph = token.morph.to_dict()
+            if morph.get('PronType') == 'Dem':
+                anaphora_count += 1
+
+    return {
+        "pronoun_count": pronouns,
+        "determiner_count": determiners,
+        "anaphora_count": anaphora_count,
+        "content_token_count": content_tokens,
+        "spacy_sentence_count": len(list(spacy_doc.sents)),
+    }
+
+
+def textstat_sentence_matches(text: str) -> int:
+    """textstat.sentence_count without max(1, ...): sentences of more than two words"""
+    sentences = re.findall(r'\b[^.!?]+[.!?]*', text, re.UNICODE)
+    return sum(1 for sentence in sentences if textstat.lexicon_count(sentence) > 2)
+
+
+# name -> function of the TextFeatures; dependencies are the other intermediates it reads
+INTERMEDIATES = {
+    "words": lambda f: f.text.split(),
+    "lower_words": lambda f: [w.lower() for w in f.get("words") if w.strip()],
+    "unique_word_count": lambda f: len(set(f.get("lower_words"))),
+    "sentences": lambda f: [s.strip() for s in re.split(r'[.!?]+', f.text) if s.strip()],
+    "paragraphs": lambda f: [p for p in f.text.split('\n\n') if p.strip()],
+    "list_items": lambda f: LIST_PATTERN.findall(f.text),
+    # textstat counts
+    "character_count": lambda f: textstat.char_count(f.text),
+    "letter_count": lambda f: textstat.letter_count(f.text),
+    "syllable_count": lambda f: textstat.syllable_count(f.text),
+    "lexicon_count": lambda f: textstat.lexicon_count(f.text),
+    "textstat_sentence_count": lambda f: textstat.sentence_count(f.text),
+    "polysyllable_count": lambda f: textstat.polysyllabcount(f.text),
+    # spaCy
+    "spacy_doc": lambda f: f.nlp(f.text) if f.nlp else None,
+    "autism_counts": lambda f: count_autism_tokens(f.get("spacy_doc")),
+    "spacy_sentence_count": lambda f: f.get("autism_counts")["spacy_sentence_count"],
+}
+
+
+class TextFeatures:
+    """Lazily computed, cached intermediates of one text"""
+
+    def __init__(self, text: str, nlp=None):
+        self.text = text
+        self.nlp = nlp
+        self._values: Dict[str, Any] = {}
+
+    def get(self, name: str) -> Any:
+        if name not in self._values:
+            self._values[name] = INTERMEDIATES[name](self)
+        return self._values[name]
+
+    def computed(self) -> List[str]:
+        return sorted(self._values)
+
+
+def _structural(f: TextFeatures, compute):
+    # The structural metrics are only reported for texts with at least one sentence
+    return compute(f) if f.get("sentences") else None
+
+
+def _lexical(f: TextFeatures, compute):
+    words = f.get("lower_words")
+    return compute(f, words) if words else None
+
+
+def _autism_density(f: TextFeatures, key: str):
+    if f.get("spacy_doc") is None:
+        return None
+    counts = f.get("autism_counts")
+    tokens = counts["content_token_count"]
+    return counts[key] / tokens if tokens else None
+
+
+def _lexical_diversity(f: TextFeatures, words: List[str]):
+    # Mean type-token ratio of 10-word segments; needs 50 words to be meaningful
+    if len(words) < 50:
+        return None
+    segments = [words[i:i + 10] for i in range(0, len(words), 10)]
+    return sum(len(set(s)) / len(s) for s in segments) / len(segments)
+
+
+def _basic(textstat_key: str, fallback):
+    return lambda f: f.get(textstat_key) if textstat else fallback(f)
+
+
+def _readability(formula: str):
+    return lambda f: getattr(textstat, formula)(f.text) if textstat else None
+
+
+# Output order of the full analysis follows this table
+METRICS = {
+    # Readability (textstat)
+    "flesch_kincaid_grade": _readability("flesch_kincaid_grade"),
+    "flesch_reading_ease": _readability("flesch_reading_ease"),
+    "gunning_fog_index": _readability("gunning_fog"),
+    "smog_index": _readability("smog_index"),
+    "automated_readability_index": _readability("automated_readability_index"),
+    "coleman_liau_index": _readability("coleman_liau_index"),
+    "dale_chall_score": _readability("dale_chall_readability_score"),
+    "linsear_write_score": _readability("linsear_write_formula"),
+    "difficult_word_count": _readability("difficult_words"),
+    # Recomputes most of the formulas above; leave it out of `metrics` when not needed
+    "text_standard": _readability("text_standard"),
+    # Basic statistics
+    "character_count": _basic("character_count", lambda f: len(f.text)),
+    "letter_count": _basic("letter_count", lambda f: None),
+    "syllable_count": _basic("syllable_count", lambda f: None),
+    "word_count": _basic("lexicon_count", lambda f: len(f.get("words"))),
+    # spaCy's segmentation whenever the model is loaded, whatever else is selected
+    "sentence_count": lambda f: (
+        f.get("spacy_sentence_count") if f.get("spacy_doc") is not None
+        else _basic("textstat_sentence_count", lambda f: len(f.get("sentences")))(f)),
+    "polysyllable_count": _basic("polysyllable_count", lambda f: None),
+    # Structure
+    "paragraph_count": lambda f: _structural(f, lambda f: len(f.get("paragraphs"))),
+    "paragraph_sentence_ratio": lambda f: _structural(
+        f, lambda f: len(f.get("paragraphs")) / len(f.get("sentences"))),
+    "has_headings": lambda f: _structural(f, lambda f: bool(HEADING_PATTERN.search(f.text))),
+    "has_lists": lambda f: _structural(f, lambda f: bool(f.get("list_items"))),
+    "list_item_count": lambda f: _structural(f, lambda f: len(f.get("list_items"))),
+    "average_paragraph_length_words": lambda f: _structural(
+        f, lambda f: len(f.get("words")) / len(f.get("paragraphs")) if f.get("paragraphs") else 0),
+    # Lexical diversity
+    "type_token_ratio": lambda f: _lexical(f, lambda f, w: f.get("unique_word_count") / len(w)),
+    "unique_word_count": lambda f: _lexical(f, lambda f, w: f.get("unique_word_count")),
+    "unique_word_ratio": lambda f: _lexical(f, lambda f, w: f.get("unique_word_count") / len(w)),
+    "lexical_diversity_score": lambda f: _lexical(f, _lexical_diversity),
+    # Autism support (spaCy)
+    "pronoun_density": lambda f: _autism_density(f, "pronoun_count"),
+    "determiner_density": lambda f: _autism_density(f, "determiner_count"),
+    "anaphora_density": lambda f: _autism_density(f, "anaphora_count"),
+    "content_token_count": lambda f: (
+        f.get("autism_counts")["content_token_count"] or None
+        if f.get("spacy_doc") is not None else None),
+}
+
+AUTISM_METRICS = {"pronoun_density", "determiner_density", "anaphora_density", "content_token_count"}
+DIFFICULT_WORD_METRICS = {"gunning_fog_index", "dale_chall_score", "difficult_word_count", "text_standard"}
+
+
+def select_metrics(metrics: Optional[Iterable[str]]) -> List[str]:
+    """Requested metric names in table order; None selects all. Raises ValueError on unknown names"""
+    if metrics is None:
+        return list(METRICS)
+    requested = set(metrics)
+    unknown = sorted(requested - set(METRICS))
+    if unknown:
+        raise ValueError("Unknown metrics: " + ", ".join(unknown))
+    return [name for name in METRICS if name in requested]
+
+
+def compute_metric(name: str, features: TextFeatures) -> Any:
+    """One metric, or None if it cannot be computed for this text"""
+    try:
+        return METRICS[name](features)
+    except Exception:
+        return None
 
 
 # ====== MAIN ENTRY POINT - GUARANTEED CLEAN EXIT ======
@@ -347,9 +456,11 @@ def main():
     import json
     
     # Read JSON from stdin
+    metrics = None
     try:
         input_json = json.loads(sys.stdin.read())
         text = input_json.get("text", "")
+        metrics = input_json.get("metrics")
     except:
         # Fallback: treat input as raw text
         if not sys.stdin.isatty():
@@ -369,7 +480,7 @@ def main():
         if text:
             # Initialize and analyze
             analyzer = TextAnalyzer()
-            result = analyzer.analyze(text)
+            result = analyzer.analyze(text, metrics)
         else:
             result = {"error": "No text provided"}
         
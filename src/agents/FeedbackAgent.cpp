@@ -4,6 +4,8 @@
  */
 
 #include "FeedbackAgent.hpp"
+#include "../core/ModelSlot.hpp"
+#include "../core/LlamaDecode.hpp"
 #include <string>
 #include <vector>
 #include <memory>
@@ -13,6 +15,7 @@
 #include <sstream>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 // Llama.cpp includes
 #include <llama.h>
@@ -29,15 +32,11 @@ namespace EMPI {
 class FeedbackAgent::LlamaImpl {
 public:
     LlamaImpl(const std::string& model_path)
-        : model_(nullptr)
-        , ctx_(nullptr)
-        , sampler_(nullptr)
-        , vocab_(nullptr)
-        , is_available_(false)
+        : models_(load_config())
     {
         if (fs::exists(model_path)) {
             try {
-                load_model(model_path);
+                models_.load(model_path);
             } catch (const std::exception& e) {
                 last_error_ = e.what();
             }
@@ -46,65 +45,48 @@ public:
         }
     }
     
-    ~LlamaImpl() {
-        if (sampler_) llama_sampler_free(sampler_);
-        if (ctx_) llama_free(ctx_);
-        if (model_) llama_model_free(model_);
+    bool is_available() const { return models_.available(); }
+    std::string get_last_error() const { return last_error_; }
+    
+    json context_stats() const {
+        auto model = models_.current();
+        return model ? model->contexts().stats() : json::object();
     }
     
-    bool is_available() const { return is_available_; }
-    std::string get_last_error() const { return last_error_; }
+    json configure_memory(const ResidencyConfig& config) { return models_.configure_memory(config); }
+    json memory_report() const {
+        auto model = models_.current();
+        return model ? model->residency().report() : json::object();
+    }
     
-    json analyze_feedback(const json& dialog_history) {
-        if (!is_available_) {
-            throw std::runtime_error("Model not available: " + last_error_);
-        }
-        
+    bool reload_model(const std::string& model_path) { return models_.load_async(model_path); }
+    void wait_for_model() { models_.wait_for_load(); }
+    json model_status() const { return models_.status(); }
+    void set_idle_policy(const IdlePolicy& policy) { models_.set_idle_policy(policy); }
+    
+    void set_prompt_lookup(bool enabled) { prompt_lookup_ = enabled; }
+    
+    /**
+     * @param usage Receives the token usage of this call
+     */
+    FeedbackAnalysisData analyze_feedback(const json& dialog_history, json& usage) {
         std::string prompt = construct_prompt(dialog_history);
-        std::string response = generate_text(prompt, 512);
+        GenerationResult response = generate_text(prompt, 512);
         
-        return parse_response(response);
+        usage = response.usage();
+        return parse_response(response.text);
     }
     
 private:
-    llama_model* model_;
-    llama_context* ctx_;
-    llama_sampler* sampler_;
-    const llama_vocab* vocab_;
-    bool is_available_;
+    ModelSlot models_;
     std::string last_error_;
+    // Set while requests read it
+    std::atomic<bool> prompt_lookup_{true};
     
-    void load_model(const std::string& model_path) {
-        llama_backend_init();
-        
-        llama_model_params model_params = llama_model_default_params();
-        model_params.n_gpu_layers = 99;
-        
-        model_ = llama_model_load_from_file(model_path.c_str(), model_params);
-        if (!model_) {
-            throw std::runtime_error("Failed to load model: " + model_path);
-        }
-        
-        vocab_ = llama_model_get_vocab(model_);
-        
-        llama_context_params ctx_params = llama_context_default_params();
-        ctx_params.n_ctx = 2048;
-        ctx_params.n_batch = 2048;
-        ctx_params.n_threads = std::thread::hardware_concurrency();
-        
-        ctx_ = llama_init_from_model(model_, ctx_params);
-        if (!ctx_) {
-            llama_model_free(model_);
-            throw std::runtime_error("Failed to create context");
-        }
-        
-        llama_sampler_chain_params sampler_params = llama_sampler_chain_default_params();
-        sampler_ = llama_sampler_chain_init(sampler_params);
-        llama_sampler_chain_add(sampler_, llama_sampler_init_min_p(0.05f, 1));
-        llama_sampler_chain_add(sampler_, llama_sampler_init_temp(0.7f));
-        llama_sampler_chain_add(sampler_, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
-        
-        is_available_ = true;
+    static ModelLoadConfig load_config() {
+        ModelLoadConfig config;
+        config.size_classes = {1024, 2048};
+        return config;
     }
     
     std::string construct_prompt(const json& dialog_history) {
@@ -128,62 +110,43 @@ private:
         return ss.str();
     }
     
-    std::string generate_text(const std::string& prompt, int max_tokens) {
-        std::string result;
-        std::vector<llama_token> tokens;
-        
-        int n_tokens = llama_tokenize(vocab_, prompt.c_str(), prompt.length(), nullptr, 0, true, true);
-        if (n_tokens < 0) {
-            tokens.resize(-n_tokens);
-            llama_tokenize(vocab_, prompt.c_str(), prompt.length(), tokens.data(), tokens.size(), true, true);
-        } else {
-            tokens.resize(n_tokens);
-            llama_tokenize(vocab_, prompt.c_str(), prompt.length(), tokens.data(), tokens.size(), true, true);
+    GenerationResult generate_text(const std::string& prompt, int max_tokens) {
+        // Held until the call returns, so a concurrent model swap or idle unload waits for this request
+        std::shared_ptr<LoadedModel> model = models_.acquire();
+        if (!model) {
+            throw std::runtime_error("Model not available: " + last_error_);
         }
         
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
-        if (llama_decode(ctx_, batch) != 0) {
-            throw std::runtime_error("Failed to decode prompt");
-        }
+        GenerationOptions options;
+        options.max_tokens = max_tokens;
+        options.prompt_lookup = prompt_lookup_;
         
-        for (int i = 0; i < max_tokens; i++) {
-            llama_token new_token = llama_sampler_sample(sampler_, ctx_, -1);
-            
-            if (llama_vocab_is_eog(vocab_, new_token)) {
-                break;
-            }
-            
-            char buf[256];
-            int n = llama_token_to_piece(vocab_, new_token, buf, sizeof(buf), 0, true);
-            if (n < 0) break;
-            
-            result += std::string(buf, n);
-            
-            batch = llama_batch_get_one(&new_token, 1);
-            if (llama_decode(ctx_, batch) != 0) break;
-        }
+        // Samplers are stateful and pooled contexts generate concurrently, so each call builds its own
+        std::unique_ptr<llama_sampler, decltype(&llama_sampler_free)> sampler(
+            llama_sampler_chain_init(llama_sampler_chain_default_params()), llama_sampler_free);
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_min_p(0.05f, 1));
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_temp(0.7f));
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
         
-        return result;
+        ContextPool::Lease context = model->contexts().acquire(count_tokens(model->vocab(), prompt) + max_tokens);
+        return EMPI::generate_text(context.get(), model->vocab(), sampler.get(), prompt, options);
     }
     
-    json parse_response(const std::string& response) {
+    FeedbackAnalysisData parse_response(const std::string& response) {
         size_t json_start = response.find('{');
         size_t json_end = response.rfind('}');
         
-        if (json_start != std::string::npos && json_end != std::string::npos) {
+        if (json_start != std::string::npos && json_end != std::string::npos && json_end > json_start) {
             try {
-                return json::parse(response.substr(json_start, json_end - json_start + 1));
+                return json::parse(response.substr(json_start, json_end - json_start + 1))
+                    .get<FeedbackAnalysisData>();
             } catch (...) {
             }
         }
         
-        return {
-            {"sentiment", "neutral"},
-            {"topics", json::array()},
-            {"satisfaction_score", 0.5},
-            {"complaints", json::array()},
-            {"feedback_summary", response.substr(0, 200)}
-        };
+        FeedbackAnalysisData fallback;
+        fallback.feedback_summary = response.substr(0, 200);
+        return fallback;
     }
 };
 
@@ -210,6 +173,61 @@ std::string FeedbackAgent::get_last_error() const {
     return last_error_;
 }
 
+void FeedbackAgent::set_prompt_lookup(bool enabled) {
+    if (llama_impl_) {
+        llama_impl_->set_prompt_lookup(enabled);
+    }
+}
+
+json FeedbackAgent::get_context_stats() const {
+    return llama_impl_ ? llama_impl_->context_stats() : json::object();
+}
+
+json FeedbackAgent::configure_memory(const ResidencyConfig& config) {
+    return llama_impl_ && is_available() ? llama_impl_->configure_memory(config) : json::object();
+}
+
+json FeedbackAgent::get_memory_report() const {
+    return llama_impl_ && is_available() ? llama_impl_->memory_report() : json::object();
+}
+
+bool FeedbackAgent::reload_model(const std::string& model_path) {
+    return llama_impl_ && llama_impl_->reload_model(model_path);
+}
+
+void FeedbackAgent::wait_for_model() {
+    if (llama_impl_) {
+        llama_impl_->wait_for_model();
+    }
+}
+
+json FeedbackAgent::get_model_status() const {
+    return llama_impl_ ? llama_impl_->model_status() : json::object();
+}
+
+void FeedbackAgent::set_idle_policy(const IdlePolicy& policy) {
+    if (llama_impl_) {
+        llama_impl_->set_idle_policy(policy);
+    }
+}
+
+FeedbackAnalysisData FeedbackAgent::analyze(const json& dialog_history) {
+    json usage;
+    return analyze(dialog_history, usage);
+}
+
+FeedbackAnalysisData FeedbackAgent::analyze(const json& dialog_history, json& usage) {
+    usage = json::object();
+    if (llama_impl_ && is_available()) {
+        return llama_impl_->analyze_feedback(dialog_history, usage);
+    }
+    
+    FeedbackAnalysisData mock;
+    mock.topics = {"general"};
+    mock.feedback_summary = "Mock feedback analysis";
+    return mock;
+}
+
 void FeedbackAgent::register_handlers() {
     register_handler("feedback_analysis",
         [](const json& input, const json& context, json& state) -> json {
@@ -247,23 +265,18 @@ void FeedbackAgent::register_handlers() {
             }
             
             try {
-                json analysis;
-                if (llama_impl_ && is_available()) {
-                    analysis = llama_impl_->analyze_feedback(extracted_info["dialog_history"]);
-                } else {
-                    analysis = {
-                        {"sentiment", "neutral"},
-                        {"topics", {"general"}},
-                        {"satisfaction_score", 0.5},
-                        {"complaints", json::array()},
-                        {"feedback_summary", "Mock feedback analysis"}
-                    };
-                }
+                json usage;
+                FeedbackAnalysisData analysis = analyze(extracted_info["dialog_history"], usage);
+                ProfileFlags profile = derive_profile_flags(extracted_info["dialog_history"], analysis);
                 
                 data_field["status"] = "success";
                 data_field["analysis_id"] = "fb_" + std::to_string(state.value("total_analyses", 0));
                 data_field["analysis"] = analysis;
+                data_field["profile_flags"] = profile;
                 data_field["messages_analyzed"] = extracted_info["message_count"];
+                if (!usage.empty()) {
+                    data_field["tokens"] = usage;
+                }
                 
             } catch (const std::exception& e) {
                 data_field["status"] = "error";
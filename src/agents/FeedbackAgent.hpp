@@ -1,6 +1,9 @@
 #pragma once
 
 #include "../core/UniversalAgent.hpp"
+#include "../core/Payloads.hpp"
+#include "../core/ProfileFlags.hpp"
+#include "../core/ModelSlot.hpp"
 #include <string>
 #include <memory>
 
@@ -13,6 +16,9 @@ namespace EMPI {
  * Uses φ-ψ handler architecture:
  * - φ-function: Extracts dialog history from input, updates state
  * - ψ-function: Calls Python script or LLM to analyze user feedback
+ * 
+ * Besides the free-form analysis, the response carries `profile_flags`, a
+ * normalized ProfileFlags profile usable as a cache or routing key.
  */
 class FeedbackAgent : public UniversalAgent {
 public:
@@ -35,6 +41,78 @@ public:
      * @brief Gets the last error message.
      */
     std::string get_last_error() const;
+    
+    /**
+     * @brief Analyzes a dialog history directly, bypassing EMPI message wrapping.
+     * 
+     * Falls back to a neutral mock analysis when the model is unavailable.
+     * 
+     * @param dialog_history Array of {"role", "content"} messages
+     * @return FeedbackAnalysisData Parsed user feedback analysis
+     */
+    FeedbackAnalysisData analyze(const json& dialog_history);
+    
+    /**
+     * @brief Like analyze(dialog_history), also returning the token usage of this call.
+     * 
+     * @param usage Receives {"prompt", "generated", "speculation"}, or {} for the mock analysis
+     */
+    FeedbackAnalysisData analyze(const json& dialog_history, json& usage);
+    
+    /**
+     * @brief Enables prompt-lookup speculative decoding (on by default).
+     */
+    void set_prompt_lookup(bool enabled);
+    
+    /**
+     * @brief Contexts per size class (1k/2k), leases and allocated KV tokens; see ContextPool.
+     */
+    json get_context_stats() const;
+    
+    /**
+     * @brief Applies huge-page, mlock and prefetch settings to the model mapping and KV buffers.
+     * 
+     * Also applied to contexts created later. Refused operations (missing
+     * privileges, memlock limit) are reported as warnings, never thrown.
+     * 
+     * @return {"model", "kv"} residency after applying, or {} without a model
+     */
+    json configure_memory(const ResidencyConfig& config);
+    
+    /**
+     * @brief Mapped, resident, locked and huge-page bytes of the model and KV buffers.
+     */
+    json get_memory_report() const;
+    
+    /**
+     * @brief Loads another model file in the background and switches to it when ready.
+     * 
+     * Requests keep running on the current model meanwhile. Requests started
+     * after the switch use the new model; those still running on the old one
+     * finish there, and the old model is freed after the last of them. A
+     * failed load keeps the current model (see get_model_status()).
+     * 
+     * @return false if a previous reload is still loading
+     */
+    bool reload_model(const std::string& model_path);
+    
+    /**
+     * @brief Blocks until a reload started by reload_model() has finished.
+     */
+    void wait_for_model();
+    
+    /**
+     * @brief {"path", "fingerprint", "loading", "swaps", "draining", "last_error", "idle"}; see ModelSlot.
+     */
+    json get_model_status() const;
+    
+    /**
+     * @brief Frees the contexts, and optionally the model, after the agent has been idle.
+     * 
+     * The next request reloads what was freed. With `min_available_bytes`
+     * an idle agent also gives its memory back when the host runs low.
+     */
+    void set_idle_policy(const IdlePolicy& policy);
 
 private:
     /**
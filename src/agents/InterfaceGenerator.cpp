@@ -4,6 +4,11 @@
  */
 
 #include "InterfaceGenerator.hpp"
+#include "../core/BlobStore.hpp"
+#include "../core/ContentSpec.hpp"
+#include "../core/LlamaDecode.hpp"
+#include "../core/ModelSlot.hpp"
+#include "../core/RequestCost.hpp"
 #include <string>
 #include <vector>
 #include <memory>
@@ -12,6 +17,8 @@
 #include <fstream>
 #include <sstream>
 #include <thread>
+#include <algorithm>
+#include <atomic>
 
 #include "llama.h"
 
@@ -23,15 +30,11 @@ namespace EMPI {
 class InterfaceGenerator::LlamaImpl {
 public:
     LlamaImpl(const std::string& model_path)
-        : model_(nullptr)
-        , ctx_(nullptr)
-        , sampler_(nullptr)
-        , vocab_(nullptr)
-        , is_available_(false)
+        : models_(load_config())
     {
         if (fs::exists(model_path)) {
             try {
-                load_model(model_path);
+                models_.load(model_path);
             } catch (const std::exception& e) {
                 last_error_ = e.what();
             }
@@ -40,66 +43,202 @@ public:
         }
     }
     
-    ~LlamaImpl() {
-        if (sampler_) llama_sampler_free(sampler_);
-        if (ctx_) llama_free(ctx_);
-        if (model_) llama_model_free(model_);
+    bool is_available() const { return models_.available(); }
+    std::string get_last_error() const { return last_error_; }
+    
+    void set_prompt_lookup(bool enabled) { prompt_lookup_ = enabled; }
+    
+    json context_stats() const {
+        auto model = models_.current();
+        return model ? model->contexts().stats() : json::object();
     }
     
-    bool is_available() const { return is_available_; }
-    std::string get_last_error() const { return last_error_; }
+    json configure_memory(const ResidencyConfig& config) { return models_.configure_memory(config); }
+    json memory_report() const {
+        auto model = models_.current();
+        return model ? model->residency().report() : json::object();
+    }
     
-    std::string generate_interface(const json& text_metrics, const json& feedback_analysis, const std::string&original_text) {
-        if (!is_available_) {
-            throw std::runtime_error("Model not available: " + last_error_);
+    bool reload_model(const std::string& model_path) { return models_.load_async(model_path); }
+    void wait_for_model() { models_.wait_for_load(); }
+    json model_status() const { return models_.status(); }
+    void set_idle_policy(const IdlePolicy& policy) { models_.set_idle_policy(policy); }
+    
+    /**
+     * @brief Fingerprint key of the active model (0 without one), mixed into page cache keys.
+     */
+    uint64_t model_key() const {
+        auto model = models_.current();
+        if (model) {
+            return model->key();
         }
+        // Unloaded while idle: the fingerprint is kept, so cached pages stay valid
+        std::string fingerprint = models_.status().value("fingerprint", "");
+        return fingerprint.empty() ? 0 : std::stoull(fingerprint, nullptr, 16);
+    }
+    void set_step_tokens(int32_t tokens) { step_tokens_ = tokens; }
+    
+    GenerationResult generate_interface(const TextMetricsData& text_metrics, const FeedbackAnalysisData& feedback_analysis, const std::string&original_text, const ProfileFlags& profile) {
+        std::shared_ptr<LoadedModel> model = require_model();
         
-        std::string prompt = construct_prompt(text_metrics, feedback_analysis, original_text);
-        return generate_html(prompt);
+        std::string prompt = construct_prompt(text_metrics, feedback_analysis, original_text, profile);
+        return generate_html(*model, prompt);
     }
     
-private:
-    llama_model* model_;
-    llama_context* ctx_;
-    llama_sampler* sampler_;
-    const llama_vocab* vocab_;
-    bool is_available_;
-    std::string last_error_;
+    /**
+     * @brief Generates a compact content spec under the spec grammar.
+     */
+    GenerationResult generate_content_spec(const TextMetricsData& text_metrics, const FeedbackAnalysisData& feedback_analysis, const std::string& original_text, const ProfileFlags& profile) {
+        std::shared_ptr<LoadedModel> model = require_model();
+        
+        SamplerPtr sampler = make_sampler(*model, kContentSpecGrammar);
+        std::string prompt = construct_spec_prompt(text_metrics, feedback_analysis, original_text, profile);
+        return generate_html(*model, prompt, kContentSpecMaxTokens, sampler.get());
+    }
+    
+    /**
+     * @brief Page generated in OutputMode::Sections.
+     */
+    struct SectionedPage {
+        PageOutline outline;
+        ContentSpec spec;
+    };
     
-    void load_model(const std::string& model_path) {
-        llama_backend_init();
+    /**
+     * @brief Generates an outline under the outline grammar, then all section bodies at once.
+     *
+     * The section prompts share one prefix (instructions, original text and
+     * outline), decoded once and forked into one sequence per section by
+     * generate_parallel(), so the page takes about as long as its longest
+     * section rather than the sum of all of them.
+     *
+     * `usage` is filled in as each phase finishes, so it also accounts for
+     * the tokens of an attempt that throws.
+     */
+    SectionedPage generate_sections(const TextMetricsData& text_metrics, const FeedbackAnalysisData& feedback_analysis, const std::string& original_text, const ProfileFlags& profile, json& usage) {
+        std::shared_ptr<LoadedModel> model = require_model();
         
-        llama_model_params model_params = llama_model_default_params();
-        model_params.n_gpu_layers = 99;
+        SectionedPage page;
+        SamplerPtr outline_sampler = make_sampler(*model, kOutlineGrammar);
+        std::string outline_prompt = construct_outline_prompt(text_metrics, feedback_analysis, original_text, profile);
+        GenerationResult outline = generate_html(*model, outline_prompt, kOutlineMaxTokens, outline_sampler.get());
+        usage = {
+            {"prompt", outline.prompt_tokens},
+            {"generated", outline.generated_tokens},
+            {"outline", outline.usage()}
+        };
+        page.outline = parse_outline(outline.text);
         
-        model_ = llama_model_load_from_file(model_path.c_str(), model_params);
-        if (!model_) {
-            throw std::runtime_error("Failed to load model: " + model_path);
-        }
+        size_t n = std::min<size_t>(page.outline.items.size(), kSectionSequences);
+        page.outline.items.resize(n);
         
-        vocab_ = llama_model_get_vocab(model_);
+        std::vector<SamplerPtr> owned;
+        std::vector<llama_sampler*> samplers;
+        std::vector<std::string> suffixes;
+        for (const auto& item : page.outline.items) {
+            owned.push_back(make_sampler(*model, nullptr));
+            samplers.push_back(owned.back().get());
+            suffixes.push_back("SECTION: " + item.heading + "\nCOVER: " + item.intent + "\n[/INST]\n");
+        }
         
-        llama_context_params ctx_params = llama_context_default_params();
-        ctx_params.n_ctx = 4096;
-        ctx_params.n_batch = 2048;
-        ctx_params.n_threads = std::thread::hardware_concurrency();
+        std::string prefix = construct_section_prefix(original_text, profile, page.outline);
+        GenerationOptions options;
+        options.max_tokens = 300;
+        options.step_tokens = step_tokens_;
+        size_t needed = count_tokens(model->vocab(), prefix);
+        for (const auto& suffix : suffixes) {
+            needed += count_tokens(model->vocab(), suffix) + options.max_tokens;
+        }
+        ContextPool::Lease context = model->contexts().acquire(needed);
+        ParallelGenerationResult bodies = generate_parallel(context.get(), model->vocab(), samplers, prefix, suffixes, options);
+        usage["prompt"] = outline.prompt_tokens + bodies.prompt_tokens;
+        usage["generated"] = outline.generated_tokens + bodies.generated_tokens;
+        usage["sections"] = bodies.usage();
         
-        ctx_ = llama_init_from_model(model_, ctx_params);
-        if (!ctx_) {
-            llama_model_free(model_);
-            throw std::runtime_error("Failed to create context");
+        page.spec.title = page.outline.title;
+        page.spec.key_points = page.outline.key_points;
+        for (size_t i = 0; i < n; ++i) {
+            ContentSection section = section_from_text(page.outline.items[i].heading, bodies.texts[i]);
+            if (!section.paragraphs.empty()) {
+                page.spec.sections.push_back(std::move(section));
+            }
+        }
+        if (page.spec.sections.empty()) {
+            throw std::runtime_error("No section bodies were generated");
         }
+        return page;
+    }
+    
+    std::string rewrite_fragment(const std::string& fragment, const std::vector<std::string>& instructions) {
+        std::shared_ptr<LoadedModel> model = require_model();
         
-        llama_sampler_chain_params sampler_params = llama_sampler_chain_default_params();
-        sampler_ = llama_sampler_chain_init(sampler_params);
-        llama_sampler_chain_add(sampler_, llama_sampler_init_min_p(0.05f, 1));
-        llama_sampler_chain_add(sampler_, llama_sampler_init_temp(0.8f));
-        llama_sampler_chain_add(sampler_, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
+        std::stringstream ss;
+        ss << "[INST] Rewrite the following HTML fragment for a reader with updated needs.\n\n";
+        ss << "CHANGES:\n";
+        for (const auto& instruction : instructions) {
+            ss << "- " << instruction << "\n";
+        }
+        ss << "\nKeep the meaning, the existing tags and attributes. ";
+        ss << "Return only the rewritten fragment, without <html>, <head> or <body>.\n\n";
+        ss << "FRAGMENT:\n" << fragment << "\n";
+        ss << "[/INST]\n";
         
-        is_available_ = true;
+        // Rewrites are roughly the size of the input; ~4 chars per token plus headroom
+        int max_tokens = std::clamp(static_cast<int>(fragment.size() / 3), 64, 1500);
+        return generate_html(*model, ss.str(), max_tokens).text;
+    }
+    
+private:
+    /// Parallel sequences per context, i.e. the most sections generated at once; matches the outline grammar's 4 items
+    static constexpr uint32_t kSectionSequences = 4;
+    ModelSlot models_;
+    std::string last_error_;
+    // Set while requests read them
+    std::atomic<bool> prompt_lookup_{true};
+    std::atomic<int32_t> step_tokens_{GenerationOptions{}.step_tokens};
+    
+    using SamplerPtr = std::unique_ptr<llama_sampler, decltype(&llama_sampler_free)>;
+    
+    /**
+     * @brief Fresh sampler chain with the default settings, optionally grammar-constrained.
+     */
+    SamplerPtr make_sampler(const LoadedModel& model, const char* grammar_text) {
+        SamplerPtr sampler(llama_sampler_chain_init(llama_sampler_chain_default_params()), llama_sampler_free);
+        if (grammar_text) {
+            llama_sampler* grammar = llama_sampler_init_grammar(model.vocab(), grammar_text, "root");
+            if (!grammar) {
+                throw std::runtime_error("Failed to compile output grammar");
+            }
+            llama_sampler_chain_add(sampler.get(), grammar);
+        }
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_min_p(0.05f, 1));
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_temp(0.8f));
+        llama_sampler_chain_add(sampler.get(), llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
+        return sampler;
+    }
+    
+    static ModelLoadConfig load_config() {
+        ModelLoadConfig config;
+        config.size_classes = {1024, 2048, 4096};
+        // Section bodies are decoded as parallel sequences over one shared prefix
+        config.n_seq_max = kSectionSequences;
+        config.kv_unified = true;
+        return config;
+    }
+    
+    /**
+     * @brief The active model (reloaded if it was unloaded while idle), held by the
+     * caller for the whole request so a swap or idle unload waits for it.
+     */
+    std::shared_ptr<LoadedModel> require_model() {
+        std::shared_ptr<LoadedModel> model = models_.acquire();
+        if (!model) {
+            throw std::runtime_error("Model not available: " + last_error_);
+        }
+        return model;
     }
    
-    std::string construct_prompt(const json& text_metrics, const json& user_profile, const std::string& original_text) { 
+    std::string construct_prompt(const TextMetricsData& text_metrics, const FeedbackAnalysisData& user_profile, const std::string& original_text, const ProfileFlags& profile) { 
     std::stringstream ss;
     
     ss << "[INST] You are an accessibility assistant. Adapt the following text for a user with specific needs.\n\n";
@@ -108,25 +247,32 @@ private:
     ss << original_text << "\n\n";
 
     ss << "ORIGINAL TEXT METRICS:\n";
-    ss << text_metrics.dump(2) << "\n\n";
+    ss << json(text_metrics).dump(2) << "\n\n";
     
     ss << "USER PROFILE:\n";
-    ss << user_profile.dump(2) << "\n\n";
+    ss << json(user_profile).dump(2) << "\n\n";
+    
+    std::vector<std::string> needs = profile.need_names();
+    ss << "USER NEEDS: ";
+    for (size_t i = 0; i < needs.size(); ++i) {
+        ss << (i ? ", " : "") << needs[i];
+    }
+    ss << (needs.empty() ? "none detected\n\n" : "\n\n");
     
     ss << "TASK:\n";
     ss << "1. Analyze the user's profile (age, ADHD, dyslexia, special needs)\n";
     ss << "2. Rewrite/adapt the original text to match their needs\n";
     ss << "3. Generate a complete HTML page with the ADAPTED text\n";
-    ss << "4. Use appropriate formatting based on their needs:\n";
-    ss << "   - For dyslexia: Use OpenDyslexic font, larger spacing, cream background\n";
-    ss << "   - For ADHD: Short paragraphs, clear headings, highlighted key points\n";
-    ss << "   - For low vision: High contrast, large text\n";
+    ss << "4. Adapt the content to their needs:\n";
+    ss << "   - For dyslexia: Short sentences, common words\n";
+    ss << "   - For ADHD: Short paragraphs, clear headings, key points in <strong>\n";
     ss << "   - For autism: Clear structure, literal language, avoid idioms\n";
-    ss << "   - For children: Simpler words, colorful, engaging\n";
-    ss << "   - For seniors: Larger text, simple navigation\n\n";
+    ss << "   - For children: Simpler words, engaging tone\n";
+    ss << "   - For seniors: Simple navigation\n\n";
     
     ss << "OUTPUT FORMAT:\n";
-    ss << "- Complete HTML5 page with inline CSS\n";
+    ss << "- Complete HTML5 page using semantic tags (main, h1-h3, section, p, ul, strong)\n";
+    ss << "- Do NOT write CSS or style attributes; a stylesheet for this user is added automatically\n";
     ss << "- Show both original metrics and adapted version\n";
     ss << "- Explain what adaptations were made for this user\n";
     ss << "- Make it practical and usable\n\n";
@@ -137,56 +283,94 @@ private:
     return ss.str();
 }
     
-    std::string generate_html(const std::string& prompt) {
-        std::string result;
-        std::vector<llama_token> tokens;
+    std::string construct_spec_prompt(const TextMetricsData& text_metrics, const FeedbackAnalysisData& user_profile, const std::string& original_text, const ProfileFlags& profile) {
+        std::stringstream ss;
         
-        // Токенизация с add_bos=true как в command-inference.cpp
-        int n_tokens = llama_tokenize(vocab_, prompt.c_str(), prompt.length(), nullptr, 0, true, true);
-        if (n_tokens < 0) {
-            tokens.resize(-n_tokens);
-            llama_tokenize(vocab_, prompt.c_str(), prompt.length(), tokens.data(), tokens.size(), true, true);
-        } else {
-            tokens.resize(n_tokens);
-            llama_tokenize(vocab_, prompt.c_str(), prompt.length(), tokens.data(), tokens.size(), true, true);
+        ss << "[INST] You are an accessibility assistant. Adapt the following text for a user with specific needs.\n\n";
+        ss << "ORIGINAL TEXT:\n" << original_text << "\n\n";
+        ss << "TEXT METRICS: grade " << text_metrics.flesch_kincaid_grade.value_or(0.0)
+           << ", " << text_metrics.word_count.value_or(0) << " words\n";
+        ss << "USER PROFILE: " << json(user_profile).dump() << "\n";
+        append_needs(ss, profile);
+        
+        ss << "Rewrite the text for these needs: short sentences and common words for dyslexia, ";
+        ss << "short paragraphs for ADHD, literal language without idioms for autism, ";
+        ss << "simpler words for children.\n\n";
+        
+        ss << "Answer with JSON only, no HTML:\n";
+        ss << "{\"t\": title, \"s\": [{\"h\": section heading, \"p\": [short paragraphs]}], ";
+        ss << "\"k\": [key points], \"g\": [[term, simple definition]], ";
+        ss << "\"n\": one sentence on what was adapted}\n";
+        ss << "[/INST]\n";
+        
+        return ss.str();
+    }
+    
+    std::string construct_outline_prompt(const TextMetricsData& text_metrics, const FeedbackAnalysisData& user_profile, const std::string& original_text, const ProfileFlags& profile) {
+        std::stringstream ss;
+        
+        ss << "[INST] You are an accessibility assistant. Plan an adapted version of the following text for a user with specific needs.\n\n";
+        ss << "ORIGINAL TEXT:\n" << original_text << "\n\n";
+        ss << "TEXT METRICS: grade " << text_metrics.flesch_kincaid_grade.value_or(0.0)
+           << ", " << text_metrics.word_count.value_or(0) << " words\n";
+        ss << "USER PROFILE: " << json(user_profile).dump() << "\n";
+        append_needs(ss, profile);
+        
+        ss << "Split the adapted page into 2-4 short sections. ";
+        ss << "Answer with JSON only:\n";
+        ss << "{\"t\": title, \"o\": [[section heading, what the section covers]], \"k\": [key points]}\n";
+        ss << "[/INST]\n";
+        
+        return ss.str();
+    }
+    
+    std::string construct_section_prefix(const std::string& original_text, const ProfileFlags& profile, const PageOutline& outline) {
+        std::stringstream ss;
+        
+        ss << "[INST] You are an accessibility assistant writing one section of an adapted page.\n\n";
+        ss << "ORIGINAL TEXT:\n" << original_text << "\n\n";
+        append_needs(ss, profile);
+        
+        ss << "PAGE OUTLINE: " << outline.title << "\n";
+        for (size_t i = 0; i < outline.items.size(); ++i) {
+            ss << (i + 1) << ". " << outline.items[i].heading << "\n";
         }
+        ss << "\nWrite only the body of the section below, adapted for these needs: ";
+        ss << "short sentences and common words for dyslexia, short paragraphs for ADHD, ";
+        ss << "literal language without idioms for autism, simpler words for children. ";
+        ss << "Plain text, one paragraph per line, no heading, no markup.\n\n";
         
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
-        if (llama_decode(ctx_, batch) != 0) {
-            throw std::runtime_error("Failed to decode prompt");
+        return ss.str();
+    }
+    
+    static void append_needs(std::stringstream& ss, const ProfileFlags& profile) {
+        std::vector<std::string> needs = profile.need_names();
+        ss << "USER NEEDS: ";
+        for (size_t i = 0; i < needs.size(); ++i) {
+            ss << (i ? ", " : "") << needs[i];
         }
+        ss << (needs.empty() ? "none detected\n\n" : "\n\n");
+    }
+    
+    /**
+     * @brief Generates under `sampler`, or a fresh default chain: samplers are stateful and
+     * pooled contexts generate concurrently, so none is shared between calls.
+     */
+    GenerationResult generate_html(LoadedModel& model, const std::string& prompt, int max_tokens = 500, llama_sampler* sampler = nullptr) {
+        GenerationOptions options;
+        options.max_tokens = max_tokens;
+        options.stop = "</html>";
+        options.prompt_lookup = prompt_lookup_;
+        options.step_tokens = step_tokens_;
         
-        // Генерация как в command-inference.cpp
-        for (int i = 0; i < 500; i++) {
-            llama_token new_token = llama_sampler_sample(sampler_, ctx_, -1);
-            
-            if (llama_vocab_is_eog(vocab_, new_token)) {
-                break;
-            }
-            
-            char buf[256];
-            int n = llama_token_to_piece(vocab_, new_token, buf, sizeof(buf), 0, true);
-            if (n <= 0) {
-                break;
-            }
-            
-            std::string piece(buf, n);
-            
-            // Останавливаемся на маркере конца
-            if (piece.find("</html>") != std::string::npos) {
-                result += piece;
-                break;
-            }
-            
-            result += piece;
-            
-            batch = llama_batch_get_one(&new_token, 1);
-            if (llama_decode(ctx_, batch) != 0) {
-                break;
-            }
+        SamplerPtr owned(nullptr, llama_sampler_free);
+        if (!sampler) {
+            owned = make_sampler(model, nullptr);
+            sampler = owned.get();
         }
         
-        return result;
+        ContextPool::Lease context = model.contexts().acquire(count_tokens(model.vocab(), prompt) + max_tokens);
+        return generate_text(context.get(), model.vocab(), sampler, prompt, options);
     }
 };
 
@@ -213,6 +397,204 @@ std::string InterfaceGenerator::get_last_error() const {
     return last_error_;
 }
 
+HTMLGenerationData InterfaceGenerator::patch(const std::string& previous_html,
+                                             const ProfileFlags& previous_profile,
+                                             const ProfileFlags& profile,
+                                             const std::string& original_text) {
+    InterfacePatch patched = patch_interface(previous_html, previous_profile, profile);
+    
+    json llm_fragments = json::array();
+    json unresolved = json::array();
+    if (!patched.rewrite_instructions.empty()) {
+        auto range = find_content_fragment(patched.html);
+        if (range && llama_impl_ && is_available()) {
+            std::string fragment = patched.html.substr(range->begin, range->end - range->begin);
+            std::string rewritten = llama_impl_->rewrite_fragment(fragment, patched.rewrite_instructions);
+            if (!rewritten.empty()) {
+                patched.html.replace(range->begin, range->end - range->begin, rewritten);
+                llm_fragments.push_back({{"bytes_in", fragment.size()}, {"bytes_out", rewritten.size()}});
+            }
+        }
+        if (llm_fragments.empty()) {
+            unresolved = patched.rewrite_instructions;
+        }
+    }
+    
+    // A page still missing a content rewrite is not what html_generation would produce for this profile
+    if (!original_text.empty() && unresolved.empty()) {
+        page_cache_.insert(page_key(original_text), profile, patched.html);
+    }
+    
+    HTMLGenerationData result;
+    result.html = std::move(patched.html);
+    result.html_size = static_cast<int64_t>(result.html.length());
+    result.extra["patch"] = {
+        {"applied", patched.applied},
+        {"llm_fragments", llm_fragments},
+        {"unresolved", unresolved},
+        {"profile_flags", profile}
+    };
+    return result;
+}
+
+uint64_t InterfaceGenerator::page_key(const std::string& original_text) const {
+    // Pages of a replaced model never match once the fingerprint changes
+    uint64_t model = llama_impl_ ? llama_impl_->model_key() : 0;
+    return SemanticCache::hash_text(original_text) ^ (model * 0x9E3779B97F4A7C15ull);
+}
+
+void InterfaceGenerator::set_output_mode(OutputMode mode) {
+    output_mode_ = mode;
+}
+
+void InterfaceGenerator::set_prompt_lookup(bool enabled) {
+    if (llama_impl_) {
+        llama_impl_->set_prompt_lookup(enabled);
+    }
+}
+
+void InterfaceGenerator::set_step_tokens(int32_t tokens) {
+    if (llama_impl_) {
+        llama_impl_->set_step_tokens(tokens);
+    }
+}
+
+void InterfaceGenerator::configure_cache(const SemanticCacheConfig& config) {
+    page_cache_.configure(config);
+}
+
+json InterfaceGenerator::get_cache_stats() const {
+    return page_cache_.stats();
+}
+
+json InterfaceGenerator::get_context_stats() const {
+    return llama_impl_ ? llama_impl_->context_stats() : json::object();
+}
+
+json InterfaceGenerator::configure_memory(const ResidencyConfig& config) {
+    return llama_impl_ && is_available() ? llama_impl_->configure_memory(config) : json::object();
+}
+
+json InterfaceGenerator::get_memory_report() const {
+    return llama_impl_ && is_available() ? llama_impl_->memory_report() : json::object();
+}
+
+bool InterfaceGenerator::reload_model(const std::string& model_path) {
+    return llama_impl_ && llama_impl_->reload_model(model_path);
+}
+
+void InterfaceGenerator::wait_for_model() {
+    if (llama_impl_) {
+        llama_impl_->wait_for_model();
+    }
+}
+
+json InterfaceGenerator::get_model_status() const {
+    return llama_impl_ ? llama_impl_->model_status() : json::object();
+}
+
+void InterfaceGenerator::set_idle_policy(const IdlePolicy& policy) {
+    if (llama_impl_) {
+        llama_impl_->set_idle_policy(policy);
+    }
+}
+
+HTMLGenerationData InterfaceGenerator::generate(const TextMetricsData& text_metrics,
+                                                const FeedbackAnalysisData& feedback_analysis,
+                                                const std::string& original_text,
+                                                const std::optional<ProfileFlags>& profile) {
+    HTMLGenerationData result;
+    ProfileFlags flags = profile ? *profile : derive_profile_flags(json::array(), feedback_analysis);
+    if (llama_impl_ && is_available()) {
+        // Pages are only reusable for the same source text
+        bool cacheable = !original_text.empty();
+        uint64_t text_hash = cacheable ? page_key(original_text) : 0;
+        
+        std::optional<SemanticCache::Hit> hit;
+        if (cacheable) {
+            hit = page_cache_.lookup(text_hash, flags);
+        }
+        
+        // A neighbouring profile's page is patched from the profile it was generated for,
+        // which restyles it and rewrites its content for plain language or density changes
+        if (hit && hit->tier == SemanticCache::Tier::Approximate) {
+            HTMLGenerationData patched = patch(hit->value, hit->profile, flags, original_text);
+            if (patched.extra["patch"]["unresolved"].empty()) {
+                result = std::move(patched);
+                hit->value = std::move(result.html);
+            } else {
+                hit.reset();
+            }
+        }
+        
+        if (hit) {
+            record_cache_hit();
+            result.html = std::move(hit->value);
+            result.extra["cache"] = {
+                {"tier", hit->tier == SemanticCache::Tier::Exact ? "exact" : "approximate"},
+                {"distance", hit->distance}
+            };
+        } else {
+            bool structured = false;
+            // Tokens spent on the spec or outline; kept if the attempt fails
+            json attempt_usage;
+            // A spec or outline cut off by the token budget does not parse; the page is then generated as HTML
+            try {
+                if (output_mode_ == OutputMode::Sections) {
+                    auto page = llama_impl_->generate_sections(text_metrics, feedback_analysis, original_text, flags, attempt_usage);
+                    result.html = render_content_spec(page.spec, flags);
+                    result.extra["content_spec"] = page.spec;
+                    result.extra["outline"] = json::array();
+                    for (const auto& item : page.outline.items) {
+                        result.extra["outline"].push_back({item.heading, item.intent});
+                    }
+                    result.extra["tokens"] = attempt_usage;
+                    structured = true;
+                } else if (output_mode_ == OutputMode::ContentSpec) {
+                    GenerationResult output = llama_impl_->generate_content_spec(text_metrics, feedback_analysis, original_text, flags);
+                    attempt_usage = output.usage();
+                    ContentSpec spec = parse_content_spec(output.text);
+                    result.html = render_content_spec(spec, flags);
+                    result.extra["content_spec"] = spec;
+                    result.extra["tokens"] = attempt_usage;
+                    structured = true;
+                }
+            } catch (const std::runtime_error& e) {
+                result.extra["fallback"] = {{"mode", "html"}, {"reason", e.what()}};
+            }
+            if (!structured) {
+                GenerationResult output = llama_impl_->generate_interface(text_metrics, feedback_analysis, original_text, flags);
+                result.html = std::move(output.text);
+                apply_profile_stylesheet(result.html, flags);
+                json usage = output.usage();
+                if (!attempt_usage.empty()) {
+                    // Totals cover both attempts; the failed one is itemized
+                    usage["prompt"] = usage["prompt"].get<size_t>() + attempt_usage.value("prompt", size_t{0});
+                    usage["generated"] = usage["generated"].get<size_t>() + attempt_usage.value("generated", size_t{0});
+                    usage["failed_attempt"] = std::move(attempt_usage);
+                }
+                result.extra["tokens"] = std::move(usage);
+            }
+            if (cacheable) {
+                page_cache_.insert(text_hash, flags, result.html);
+            }
+            result.extra["cache"] = {{"tier", "miss"}};
+        }
+    } else {
+        // Fallback HTML template
+        result.html = R"(<!DOCTYPE html>
+<html>
+<head><title>Analysis Results</title>
+<style>.container{max-width:800px;margin:0 auto;padding:20px}.section{margin:20px 0;padding:15px;border:1px solid #ccc;border-radius:3px}pre{white-space:pre-wrap}</style>
+</head>
+<body><div class="container"><h1>Analysis Results</h1><div class="section"><h3>Text Metrics</h3><pre>)" + json(text_metrics).dump(2) + R"(</pre></div><div class="section"><h3>Feedback Analysis</h3><pre>)" + json(feedback_analysis).dump(2) + R"(</pre></div></div></body>
+</html>)";
+        apply_profile_stylesheet(result.html, flags);
+    }
+    result.html_size = static_cast<int64_t>(result.html.length());
+    return result;
+}
+
 void InterfaceGenerator::register_handlers() {
     register_handler("html_generation",
         // φ-function
@@ -228,6 +610,9 @@ void InterfaceGenerator::register_handlers() {
             if (input.contains("original_text")) {
                 extracted_info["original_text"] = input["original_text"];
             } 
+            if (input.contains("profile_flags")) {
+                extracted_info["profile_flags"] = input["profile_flags"];
+            }
  
             if (!extracted_info.contains("text_metrics")) {
                 extracted_info["error"] = "Missing text_metrics";
@@ -253,28 +638,28 @@ void InterfaceGenerator::register_handlers() {
             }
             
             try {
-                std::string html;
-                if (llama_impl_ && is_available()) {
-                    html = llama_impl_->generate_interface(
-                        extracted_info["text_metrics"],
-                        extracted_info["feedback_analysis"],
-			extracted_info.value("original_text", "")
-                    );
-                } else {
-                    // Fallback HTML template
-                    html = R"(<!DOCTYPE html>
-<html>
-<head><title>Analysis Results</title>
-<style>body{font-family:Arial;margin:0;padding:20px;background:#f5f5f5}.container{max-width:800px;margin:0 auto;background:white;padding:20px;border-radius:5px;box-shadow:0 2px 5px rgba(0,0,0,0.1)}h1{color:#2c3e50}.section{margin:20px 0;padding:15px;background:#ecf0f1;border-radius:3px}</style>
-</head>
-<body><div class="container"><h1>Analysis Results</h1><div class="section"><h3>Text Metrics</h3><pre>)" + extracted_info["text_metrics"].dump(2) + R"(</pre></div><div class="section"><h3>Feedback Analysis</h3><pre>)" + extracted_info["feedback_analysis"].dump(2) + R"(</pre></div></div></body>
-</html>)";
+                std::optional<ProfileFlags> profile;
+                if (extracted_info.contains("profile_flags")) {
+                    profile = extracted_info["profile_flags"].get<ProfileFlags>();
                 }
+                auto original_text = extracted_info.contains("original_text")
+                    ? read_text(extracted_info["original_text"])
+                    : std::make_shared<const std::string>();
+                
+                HTMLGenerationData generated = generate(
+                    extracted_info["text_metrics"].get<TextMetricsData>(),
+                    extracted_info["feedback_analysis"].get<FeedbackAnalysisData>(),
+                    *original_text,
+                    profile
+                );
                 
                 data_field["status"] = "success";
                 data_field["generation_id"] = "gen_" + std::to_string(state.value("total_generations", 0));
-                data_field["html"] = html;
-                data_field["html_size"] = html.length();
+                data_field["html"] = share_text(std::move(generated.html));
+                data_field["html_size"] = generated.html_size;
+                for (auto& [key, value] : generated.extra.items()) {
+                    data_field[key] = value;
+                }
                 
             } catch (const std::exception& e) {
                 data_field["status"] = "error";
@@ -285,6 +670,66 @@ void InterfaceGenerator::register_handlers() {
             return data_field;
         }
     );
+    
+    register_handler("html_patch",
+        // φ-function
+        [](const json& input, const json& context, json& state) -> json {
+            json extracted_info;
+            
+            if (!input.contains("previous_html") ||
+                !(input["previous_html"].is_string() || BlobRef::is_ref(input["previous_html"]))) {
+                extracted_info["error"] = "Missing previous_html";
+                return extracted_info;
+            }
+            if (!input.contains("previous_profile_flags") || !input.contains("profile_flags")) {
+                extracted_info["error"] = "Missing previous_profile_flags or profile_flags";
+                return extracted_info;
+            }
+            
+            extracted_info["previous_html"] = input["previous_html"];
+            extracted_info["previous_profile_flags"] = input["previous_profile_flags"];
+            extracted_info["profile_flags"] = input["profile_flags"];
+            extracted_info["original_text"] = input.contains("original_text") ? input["original_text"] : json("");
+            state["total_patches"] = state.value("total_patches", 0) + 1;
+            
+            return extracted_info;
+        },
+        
+        // ψ-function
+        [this](const json& extracted_info, const json& context, json& state) -> json {
+            json data_field;
+            
+            if (extracted_info.contains("error")) {
+                data_field["status"] = "error";
+                data_field["message"] = extracted_info["error"];
+                return data_field;
+            }
+            
+            try {
+                HTMLGenerationData patched = patch(
+                    *read_text(extracted_info["previous_html"]),
+                    extracted_info["previous_profile_flags"].get<ProfileFlags>(),
+                    extracted_info["profile_flags"].get<ProfileFlags>(),
+                    *read_text(extracted_info["original_text"])
+                );
+                
+                data_field["status"] = "success";
+                data_field["generation_id"] = "patch_" + std::to_string(state.value("total_patches", 0));
+                data_field["html"] = share_text(std::move(patched.html));
+                data_field["html_size"] = patched.html_size;
+                for (auto& [key, value] : patched.extra.items()) {
+                    data_field[key] = value;
+                }
+                
+            } catch (const std::exception& e) {
+                data_field["status"] = "error";
+                data_field["message"] = std::string("Patch failed: ") + e.what();
+                last_error_ = data_field["message"];
+            }
+            
+            return data_field;
+        }
+    );
 }
 
 } // namespace EMPI
@@ -1,11 +1,27 @@
 #pragma once
 
 #include "../core/UniversalAgent.hpp"
+#include "../core/Payloads.hpp"
+#include "../core/ProfileFlags.hpp"
+#include "../core/ModelSlot.hpp"
+#include "../core/SemanticCache.hpp"
+#include "../core/InterfacePatcher.hpp"
 #include <string>
 #include <memory>
+#include <optional>
 
 namespace EMPI {
 
+/**
+ * @enum OutputMode
+ * @brief What the model is asked to produce for a new page.
+ */
+enum class OutputMode : uint8_t {
+    Html = 0,     ///< Complete HTML page written by the model
+    ContentSpec,  ///< Grammar-constrained content spec rendered natively (see ContentSpec)
+    Sections      ///< Outline first, then all section bodies decoded in parallel (see PageOutline)
+};
+
 /**
  * @class InterfaceGenerator
  * @brief EMPI agent that generates interface HTML based on analysis results.
@@ -13,6 +29,14 @@ namespace EMPI {
  * Uses φ-ψ handler architecture:
  * - φ-function: Extracts text metrics and feedback analysis
  * - ψ-function: Calls LLM to generate personalized HTML interface
+ * 
+ * Generated pages are cached by (original text, ProfileFlags). A request whose
+ * profile is within the configured distance of a cached one reuses that page
+ * instead of calling the LLM (see SemanticCache).
+ * 
+ * Task types:
+ * - "html_generation": full page generation
+ * - "html_patch": incremental update of a page for a changed profile
  */
 class InterfaceGenerator : public UniversalAgent {
 public:
@@ -27,13 +51,160 @@ public:
     
     bool is_available() const;
     std::string get_last_error() const;
+    
+    /**
+     * @brief Generates an interface directly, bypassing EMPI message wrapping.
+     * 
+     * Falls back to a static HTML report when the model is unavailable.
+     * 
+     * @param text_metrics Metrics produced by TextAnalyzer
+     * @param feedback_analysis User profile produced by FeedbackAgent
+     * @param original_text Text to adapt
+     * @param profile Normalized profile from FeedbackAgent; derived from
+     *                feedback_analysis when not provided
+     * @return HTMLGenerationData Generated page and its size; `extra["cache"]`
+     *         describes the cache tier that served the page and `extra["tokens"]`
+     *         the prompt/generated token counts of a model call. An approximate
+     *         hit is patched from its cached profile (see patch()), with the
+     *         edits in `extra["patch"]`; if a content change cannot be
+     *         rewritten, the page is generated instead
+     */
+    HTMLGenerationData generate(const TextMetricsData& text_metrics,
+                                const FeedbackAnalysisData& feedback_analysis,
+                                const std::string& original_text,
+                                const std::optional<ProfileFlags>& profile = std::nullopt);
+    
+    /**
+     * @brief Adapts a previously generated page to a slightly changed profile.
+     * 
+     * Style-level changes are applied deterministically (see patch_interface());
+     * content-level changes send only the page's content fragment to the LLM.
+     * Without a model, content changes are reported in `extra["patch"]["unresolved"]`.
+     * 
+     * @param previous_html Page generated for previous_profile
+     * @param previous_profile Profile the page was generated for
+     * @param profile Updated profile
+     * @param original_text Optional source text; when set, a fully patched page (nothing unresolved) is cached
+     * @return HTMLGenerationData Patched page; `extra["patch"]` lists the edits
+     */
+    HTMLGenerationData patch(const std::string& previous_html,
+                             const ProfileFlags& previous_profile,
+                             const ProfileFlags& profile,
+                             const std::string& original_text = "");
+    
+    /**
+     * @brief Selects how new pages are generated.
+     * 
+     * In OutputMode::ContentSpec the model spends its tokens on the adapted
+     * text only; markup is produced by render_content_spec() and is always
+     * well-formed. The spec is returned in `extra["content_spec"]`.
+     * 
+     * OutputMode::Sections targets long pages: a short outline is generated
+     * first, then every section body is decoded as its own sequence over a
+     * shared prompt prefix, and the sections are assembled in outline order.
+     * The outline is returned in `extra["outline"]`, per-phase usage in
+     * `extra["tokens"]`.
+     *
+     * If the spec or outline does not parse (e.g. cut off by the token
+     * budget), the page is generated in OutputMode::Html and
+     * `extra["fallback"]` holds the reason. `extra["tokens"]` then counts
+     * both attempts, with the usage of the failed one in `"failed_attempt"`.
+     */
+    void set_output_mode(OutputMode mode);
+    OutputMode output_mode() const { return output_mode_; }
+    
+    /**
+     * @brief Enables prompt-lookup speculative decoding (on by default).
+     * 
+     * Continuations are drafted from n-grams of the prompt, which holds the
+     * original text, and verified in one batched decode; see generate_text().
+     * Acceptance statistics are reported in `extra["tokens"]["speculation"]`.
+     */
+    void set_prompt_lookup(bool enabled);
+    
+    /**
+     * @brief Token budget of one decode call (default 512, capped by n_batch).
+     * 
+     * Long prompts are prefilled in chunks of this size, interleaved with
+     * the decode steps of sequences that are already generating (see
+     * generate_parallel()). Smaller budgets keep per-token latency even,
+     * larger ones finish prefill in fewer calls.
+     */
+    void set_step_tokens(int32_t tokens);
+    
+    /**
+     * @brief Reconfigures the page cache (threshold, capacity, on/off).
+     */
+    void configure_cache(const SemanticCacheConfig& config);
+    
+    /**
+     * @brief Cache counters, including hit rate at alternative distance thresholds.
+     */
+    json get_cache_stats() const;
+    
+    /**
+     * @brief Contexts per size class (1k/2k/4k), leases and allocated KV tokens; see ContextPool.
+     */
+    json get_context_stats() const;
+    
+    /**
+     * @brief Applies huge-page, mlock and prefetch settings to the model mapping and KV buffers.
+     * 
+     * Also applied to contexts created later. Refused operations (missing
+     * privileges, memlock limit) are reported as warnings, never thrown.
+     * 
+     * @return {"model", "kv"} residency after applying, or {} without a model
+     */
+    json configure_memory(const ResidencyConfig& config);
+    
+    /**
+     * @brief Mapped, resident, locked and huge-page bytes of the model and KV buffers.
+     */
+    json get_memory_report() const;
+    
+    /**
+     * @brief Loads another model file in the background and switches to it when ready.
+     * 
+     * Requests keep running on the current model meanwhile. Requests started
+     * after the switch use the new model; those still running on the old one
+     * finish there, and the old model is freed after the last of them. A
+     * failed load keeps the current model (see get_model_status()).
+     * 
+     * @return false if a previous reload is still loading
+     */
+    bool reload_model(const std::string& model_path);
+    
+    /**
+     * @brief Blocks until a reload started by reload_model() has finished.
+     */
+    void wait_for_model();
+    
+    /**
+     * @brief {"path", "fingerprint", "loading", "swaps", "draining", "last_error", "idle"}; see ModelSlot.
+     */
+    json get_model_status() const;
+    
+    /**
+     * @brief Frees the contexts, and optionally the model, after the agent has been idle.
+     * 
+     * The next request reloads what was freed. With `min_available_bytes`
+     * an idle agent also gives its memory back when the host runs low.
+     */
+    void set_idle_policy(const IdlePolicy& policy);
 
 private:
     void register_handlers();
     
+    /**
+     * @brief Page cache key: the source text hash combined with the active model's fingerprint.
+     */
+    uint64_t page_key(const std::string& original_text) const;
+    
     class LlamaImpl;
     std::unique_ptr<LlamaImpl> llama_impl_;
+    SemanticCache page_cache_;
     std::string last_error_;
+    OutputMode output_mode_ = OutputMode::Html;
 };
 
 } // namespace EMPI
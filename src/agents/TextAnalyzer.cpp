@@ -4,13 +4,26 @@
  */
 
 #include "TextAnalyzer.hpp"
+#include "../core/CpuBudget.hpp"
+#include "../core/ForkServer.hpp"
+#include "../core/MetricProjection.hpp"
+#include "../core/Probes.hpp"
+#include "../core/RequestCost.hpp"
+#include "../core/TextAggregates.hpp"
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <thread>
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <utility>
 #include <filesystem>
 #include <unistd.h>  // For mkstemp, close, unlink
 #include <sys/types.h>
@@ -22,6 +35,38 @@ using json = nlohmann::json;
 
 namespace EMPI {
 
+namespace {
+
+/// Default `system.max_text_length` of text_analyzer.py, in characters
+constexpr size_t kMaxTextLength = 100000;
+
+/**
+ * @brief Bytes of the first `max_chars` UTF-8 characters of `text` (Python's `text[:max_chars]`).
+ */
+size_t utf8_prefix_bytes(const std::string& text, size_t max_chars) {
+    size_t chars = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        // Continuation bytes belong to the preceding character
+        if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80 && chars++ == max_chars) {
+            return i;
+        }
+    }
+    return text.size();
+}
+
+bool has_words(const std::string& text, size_t count) {
+    size_t words = 0;
+    bool in_word = false;
+    for (char c : text) {
+        bool space = std::isspace(static_cast<unsigned char>(c)) != 0;
+        if (!space && !in_word && ++words >= count) return true;
+        in_word = !space;
+    }
+    return false;
+}
+
+} // namespace
+
 /**
  * @class TextAnalyzer::PythonSubprocessImpl
  * @brief Executes Python scripts via subprocess pipes.
@@ -58,6 +103,26 @@ public:
      * @return JSON containing script output
      */
     json call_script_with_json_input(const json& input_data) {
+        std::shared_ptr<ForkServer> fork_server = current_fork_server();
+        if (fork_server && fork_server->running()) {
+            auto text = input_data.find("text");
+            size_t cost = text != input_data.end() && text->is_string() ? text->get_ref<const std::string&>().size() : 0;
+            EMPI_PROBE2(python__dispatch, current_request_id(), cost);
+            try {
+                auto dispatched = std::chrono::steady_clock::now();
+                json result = fork_server->call(input_data, cost);
+                record_python_ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - dispatched).count());
+                EMPI_PROBE2(python__return, current_request_id(), 0);
+                return result;
+            } catch (const std::exception&) {
+                // Closes this dispatch; the one-shot interpreter below is traced as its own call
+                EMPI_PROBE2(python__return, current_request_id(), -1);
+            }
+        }
+        
+        // One core per analysis, whichever process runs it; fork-server workers lease theirs in their lane slot
+        CpuLease cpu = CpuBudget::global().acquire("analyzer", 1);
+        
         char temp_input[256] = "/tmp/text_analyzer_input_XXXXXX";
         char temp_output[256] = "/tmp/text_analyzer_output_XXXXXX";
         int fd_input = -1, fd_output = -1;
@@ -100,7 +165,10 @@ public:
                 "    try:\n"
                 "        from text_analyzer import TextAnalyzer\n"
                 "        analyzer = TextAnalyzer()\n"
-                "        result = analyzer.analyze(text)\n"
+                "        if data.get('mode') == 'aggregate':\n"
+                "            result = analyzer.partial_aggregates(text, data.get('metrics'))\n"
+                "        else:\n"
+                "            result = analyzer.analyze(text, data.get('metrics'))\n"
                 "    except Exception as e:\n"
                 "        result = {'error': 'Python analysis failed: ' + str(e)}\n"
                 "with open('" + std::string(temp_output) + "', 'w') as f:\n"
@@ -108,7 +176,11 @@ public:
                 "\"";
             
             // Execute Python command
+            EMPI_PROBE2(python__dispatch, current_request_id(), input_json.size());
+            auto dispatched = std::chrono::steady_clock::now();
             int return_code = system(command.c_str());
+            record_python_ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - dispatched).count());
+            EMPI_PROBE2(python__return, current_request_id(), return_code);
             
             if (return_code != 0) {
                 throw std::runtime_error("Python script failed with exit code: " + std::to_string(return_code));
@@ -157,9 +229,52 @@ public:
     std::string get_script_path() const { return script_path_; }
     std::string get_python_path() const { return python_path_; }
     
+    /**
+     * @brief Starts integrations/analyzer_server.py as zygote for persistent workers.
+     * 
+     * @throws std::runtime_error If the zygote does not start
+     */
+    void start_fork_server(ForkServerConfig config) {
+        std::string server_script = (fs::path(script_path_).parent_path() / "analyzer_server.py").string();
+        if (config.lanes.empty()) {
+            // Short texts, chunks and medium documents, whole huge documents
+            config.lanes = {{2000, 1}, {20000, 1}, {SIZE_MAX, 1}};
+        }
+        if (config.cpu_consumer.empty()) {
+            config.cpu_consumer = "analyzer";
+        }
+        auto server = std::make_shared<ForkServer>(std::vector<std::string>{python_path_, server_script}, config);
+        server->start();
+        std::lock_guard<std::mutex> lock(fork_server_mutex_);
+        // The previous server, if any, is released after the lock like in stop_fork_server()
+        fork_server_.swap(server);
+    }
+    
+    void stop_fork_server() {
+        std::shared_ptr<ForkServer> stopped;
+        {
+            std::lock_guard<std::mutex> lock(fork_server_mutex_);
+            stopped.swap(fork_server_);
+        }
+        // Analyses still running hold their own reference; the last one stops the zygote
+    }
+    
+    json fork_server_stats() const {
+        std::shared_ptr<ForkServer> fork_server = current_fork_server();
+        return fork_server ? fork_server->stats() : json{{"running", false}};
+    }
+    
 private:
     std::string python_path_;
     std::string script_path_;
+    /// Replaced and reset while analyses run; callers work on a copy taken under the mutex
+    std::shared_ptr<ForkServer> fork_server_;
+    mutable std::mutex fork_server_mutex_;
+    
+    std::shared_ptr<ForkServer> current_fork_server() const {
+        std::lock_guard<std::mutex> lock(fork_server_mutex_);
+        return fork_server_;
+    }
     
     std::string find_python_executable(const std::string& preferred_path) const {
         if (!preferred_path.empty() && check_command(preferred_path + " --version")) {
@@ -217,6 +332,18 @@ private:
     }
 };
 
+/**
+ * @brief Maps Flesch-Kincaid grade to (complexity_label, accessibility_level).
+ */
+static std::pair<std::string, std::string> complexity_labels(double flesch_kincaid) {
+    if (flesch_kincaid <= 8.0) {
+        return {"simple", "high"};
+    } else if (flesch_kincaid <= 12.0) {
+        return {"moderate", "medium"};
+    }
+    return {"complex", "low"};
+}
+
 /**
  * @brief Constructs a text analysis agent.
  * 
@@ -255,6 +382,123 @@ std::string TextAnalyzer::get_python_path() const {
     return python_impl_ ? python_impl_->get_python_path() : "";
 }
 
+bool TextAnalyzer::start_fork_server(const ForkServerConfig& config) {
+    try {
+        python_impl_->start_fork_server(config);
+        return true;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Fork-server failed to start: ") + e.what();
+        return false;
+    }
+}
+
+void TextAnalyzer::stop_fork_server() {
+    python_impl_->stop_fork_server();
+}
+
+json TextAnalyzer::fork_server_stats() const {
+    return python_impl_->fork_server_stats();
+}
+
+void TextAnalyzer::set_chunking(size_t chunk_chars, size_t threads) {
+#ifndef EMPI_CHUNKED_ANALYSIS
+    if (chunk_chars != 0) {
+        throw std::runtime_error("Chunked analysis is not enabled in this build (EMPI_CHUNKED_ANALYSIS)");
+    }
+#endif
+    chunk_chars_ = chunk_chars;
+    chunk_threads_ = threads;
+}
+
+json TextAnalyzer::run_analysis(const json& python_input) {
+    const std::string& full_text = python_input.at("text").get_ref<const std::string&>();
+    if (chunk_chars_ == 0 || full_text.size() < 2 * chunk_chars_) {
+        return python_impl_->call_script_with_json_input(python_input);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    // The whole-text analysis only reads the first max_text_length characters
+    std::string text = full_text.substr(0, utf8_prefix_bytes(full_text, kMaxTextLength));
+    std::vector<std::string> chunks = split_paragraph_chunks(text, chunk_chars_);
+    // Linsear Write is taken from the first chunk and reads the first 100 words
+    if (chunks.size() < 2 || !has_words(chunks.front(), 100)) {
+        return python_impl_->call_script_with_json_input(python_input);
+    }
+
+    // Map: one aggregate per chunk, in document order whichever worker ran it
+    std::vector<json> partials(chunks.size());
+    size_t threads = chunk_threads_ ? chunk_threads_ : CpuBudget::global().cores();
+    threads = std::min(threads, chunks.size());
+    std::atomic<size_t> next{0};
+    RequestCostScope* cost = current_request_cost();
+    auto worker = [&] {
+        RequestCostBinding binding(cost);
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            json chunk_input = python_input;
+            chunk_input["text"] = chunks[i];
+            chunk_input["mode"] = "aggregate";
+            partials[i] = python_impl_->call_script_with_json_input(chunk_input);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    // Reduce
+    TextAggregates merged;
+    for (const json& partial : partials) {
+        if (partial.contains("error")) {
+            return partial;
+        }
+        merged.merge(partial.get<TextAggregates>());
+    }
+
+    TextMetricsData metrics = merged.finalize();
+    if (python_input.contains("metrics")) {
+        auto selected = python_input["metrics"].get<std::vector<std::string>>();
+        project_metrics(metrics, selected);
+        metrics.extra["metadata"]["metrics"] = selected;
+    }
+    json result = metrics;
+    result["metadata"]["text_length_characters"] = std::count_if(
+        text.begin(), text.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+    result["metadata"]["threads"] = threads;
+    result["metadata"]["processing_time_seconds"] =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+TextMetricsData TextAnalyzer::analyze(const std::string& text, const std::string& language,
+                                      const std::vector<std::string>& requested_metrics) {
+    if (text.empty()) {
+        throw std::runtime_error("No text provided");
+    }
+    
+    json python_input = {{"text", text}};
+    if (!language.empty()) {
+        python_input["language"] = language;
+    }
+    if (!requested_metrics.empty()) {
+        python_input["metrics"] = resolve_metrics(requested_metrics);
+    }
+    
+    json python_result = run_analysis(python_input);
+    if (python_result.contains("error")) {
+        throw std::runtime_error(python_result["error"].get<std::string>());
+    }
+    
+    TextMetricsData metrics = python_result.get<TextMetricsData>();
+    if (!metrics.flesch_kincaid_grade) {
+        throw std::runtime_error("Invalid Python output structure: missing flesch_kincaid_grade");
+    }
+    return metrics;
+}
+
 /**
  * @brief Registers EMPI protocol handlers.
  * 
@@ -264,17 +508,17 @@ std::string TextAnalyzer::get_python_path() const {
 void TextAnalyzer::register_handlers() {
     register_handler("text_metrics",
         // φ-function
-        [](const json& input, const json& context, json& state) -> json {
+        [this](const json& input, const json& context, json& state) -> json {
             json extracted_info;
             
-            // Extract text with fallback hierarchy
+            // Extract text with fallback hierarchy; any of them may be a blob reference
             std::string text;
             if (input.contains("text")) {
-                text = input["text"].get<std::string>();
+                text = *read_text(input["text"]);
             } else if (input.contains("content")) {
-                text = input["content"].get<std::string>();
+                text = *read_text(input["content"]);
             } else if (input.contains("data") && input["data"].contains("text")) {
-                text = input["data"]["text"].get<std::string>();
+                text = *read_text(input["data"]["text"]);
             }
             
             if (text.empty()) {
@@ -289,6 +533,16 @@ void TextAnalyzer::register_handlers() {
                 extracted_info["language"] = input["meta"]["language"];
             }
             
+            // Optional metric projection
+            if (input.contains("metrics")) {
+                try {
+                    extracted_info["metrics"] = resolve_metrics(input["metrics"]);
+                } catch (const std::invalid_argument& e) {
+                    extracted_info["error"] = e.what();
+                    return extracted_info;
+                }
+            }
+            
             extracted_info["text"] = text;
             
             // Update state
@@ -324,6 +578,11 @@ void TextAnalyzer::register_handlers() {
                     if (lang_it != extracted_info.end()) {
                         python_input["language"] = lang_it->get<std::string>();
                     }
+                    
+                    auto metrics_it = extracted_info.find("metrics");
+                    if (metrics_it != extracted_info.end()) {
+                        python_input["metrics"] = *metrics_it;
+                    }
                 } catch (const json::exception& e) {
                     data_field["status"] = "error";
                     data_field["message"] = std::string("Invalid extracted info: ") + e.what();
@@ -331,7 +590,7 @@ void TextAnalyzer::register_handlers() {
                     return data_field;
                 }
                 
-                auto python_result = python_impl_->call_script_with_json_input(python_input);
+                auto python_result = run_analysis(python_input);
                 
                 // Parse Python result with expected structure
                 if (python_result.contains("error")) {
@@ -344,27 +603,22 @@ void TextAnalyzer::register_handlers() {
                 
                 // Parse known metrics structure
                 try {
+                    TextMetricsData metrics = python_result.get<TextMetricsData>();
+                    
                     // Required metrics
-                    double flesch_kincaid = python_result.at("flesch_kincaid_grade").get<double>();
+                    if (!metrics.flesch_kincaid_grade) {
+                        throw std::invalid_argument("missing flesch_kincaid_grade");
+                    }
+                    auto labels = complexity_labels(*metrics.flesch_kincaid_grade);
                     
                     data_field["status"] = "success";
                     data_field["analysis_id"] = 
                         "analyze_" + std::to_string(state.value("total_texts_processed", 0));
-                    data_field["metrics"] = python_result;
+                    data_field["metrics"] = metrics;
+                    data_field["complexity_label"] = labels.first;
+                    data_field["accessibility_level"] = labels.second;
                     
-                    // Set complexity based on Flesch-Kincaid values
-                    if (flesch_kincaid <= 8.0) {
-                        data_field["complexity_label"] = "simple";
-                        data_field["accessibility_level"] = "high";
-                    } else if (flesch_kincaid <= 12.0) {
-                        data_field["complexity_label"] = "moderate";
-                        data_field["accessibility_level"] = "medium";
-                    } else {
-                        data_field["complexity_label"] = "complex";
-                        data_field["accessibility_level"] = "low";
-                    }
-                    
-                } catch (const json::exception& e) {
+                } catch (const std::exception& e) {
                     data_field["status"] = "error";
                     data_field["message"] = std::string("Invalid Python output structure: ") + e.what();
                     data_field["error_type"] = "output_structure";
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "../core/UniversalAgent.hpp"
+#include "../core/ForkServer.hpp"
+#include "../core/Payloads.hpp"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace EMPI {
 
@@ -58,8 +61,87 @@ public:
      * @return std::string Path to text_analyzer.py.
      */
     std::string get_script_path() const;
+    
+    /**
+     * @brief Analyzes text directly, bypassing EMPI message wrapping.
+     * 
+     * Intended for in-process callers that pass typed payloads between
+     * agents and convert to JSON only at process boundaries.
+     * 
+     * @param text Text to analyze
+     * @param language Optional language code
+     * @param requested_metrics Metrics to compute (see resolve_metrics()); empty computes all
+     * @return TextMetricsData Parsed metrics
+     * @throws std::runtime_error If the Python analyzer fails or omits flesch_kincaid_grade.
+     * @throws std::invalid_argument If `requested_metrics` names an unknown metric.
+     */
+    TextMetricsData analyze(const std::string& text, const std::string& language = "",
+                            const std::vector<std::string>& requested_metrics = {});
+    
+    /**
+     * @brief Configures map-reduce analysis of large documents.
+     * 
+     * Texts of at least twice `chunk_chars` are split at paragraph breaks
+     * after a sentence end into chunks of about `chunk_chars`, analyzed by
+     * `threads` concurrent Python workers and merged (see TextAggregates).
+     * The merged metrics equal those of a whole-text analysis, including its
+     * max_text_length truncation, and do not depend on the thread count.
+     * Texts without such breaks are analyzed whole.
+     * 
+     * Held back until the chunked results have been checked against
+     * textstat (test_chunked_matches_whole): only builds configured with
+     * EMPI_CHUNKED_ANALYSIS accept a non-zero `chunk_chars`.
+     * 
+     * @param chunk_chars Target chunk size; 0 (the default) disables chunking
+     * @param threads Concurrent workers (0 = the cores of CpuBudget::global())
+     * @throws std::runtime_error If `chunk_chars` is non-zero in a build without EMPI_CHUNKED_ANALYSIS
+     */
+    void set_chunking(size_t chunk_chars, size_t threads = 0);
+    
+    /**
+     * @brief Serves analyses from workers forked off a preloaded zygote.
+     * 
+     * Without a fork-server every analysis starts a new interpreter that
+     * imports textstat and spaCy and loads the model. With it,
+     * integrations/analyzer_server.py loads them once and each worker is
+     * forked from it, sharing the model pages copy-on-write. The pool grows
+     * with the number of concurrent analyses (e.g. chunk workers) up to
+     * `config.max_workers` and shrinks back after `config.idle_timeout`.
+     * If a worker cannot serve a request, a one-shot interpreter does.
+     * 
+     * Requests are routed into lanes by text length so that a book-sized
+     * document cannot hold every worker while short texts queue behind it.
+     * Unless `config.lanes` is set, one worker slot each is reserved for
+     * short texts (up to 2k characters), medium texts and chunks (up to 20k)
+     * and longer texts; idle lanes lend their slots (see ForkServer). An
+     * analysis leases its "analyzer" core only once it holds a slot.
+     * 
+     * @param config Worker limits (see ForkServerConfig)
+     * @return false If the zygote did not start; see get_last_error()
+     */
+    bool start_fork_server(const ForkServerConfig& config = {});
+    
+    /**
+     * @brief Stops the zygote and its workers; later analyses start one-shot interpreters.
+     * 
+     * Safe while analyses run: those already on a worker finish there, and
+     * the zygote exits when the last of them returns.
+     */
+    void stop_fork_server();
+    
+    /**
+     * @brief Worker pool statistics (see ForkServer::stats()), or {"running": false}.
+     */
+    json fork_server_stats() const;
 
 private:
+    /**
+     * @brief Runs the Python analyzer, chunked when the text is large.
+     * 
+     * @return Metrics JSON, or {"error": ...} as produced by the script
+     */
+    json run_analysis(const json& python_input);
+    
     /**
      * @brief Registers EMPI protocol handlers (φ and ψ functions).
      */
@@ -82,6 +164,9 @@ private:
      * @brief Stores the last error message.
      */
     std::string last_error_;
+    
+    size_t chunk_chars_ = 0;
+    size_t chunk_threads_ = 0;
 };
 
 } // namespace EMPI
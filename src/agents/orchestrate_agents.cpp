@@ -6,6 +6,7 @@
 #include "../src/agents/TextAnalyzer.hpp"
 #include "../src/agents/FeedbackAgent.hpp"
 #include "../src/agents/InterfaceGenerator.hpp"
+#include "../src/core/BlobStore.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -86,6 +87,12 @@ AgentResults run_parallel_agents(OrchestrationLogger& logger, const std::string&
     FeedbackAgent feedback_agent(model_path);
     InterfaceGenerator interface_gen(model_path);
     
+    // Pages and texts pass between the agents by reference
+    auto blobs = std::make_shared<BlobStore>();
+    text_agent.set_blob_store(blobs);
+    feedback_agent.set_blob_store(blobs);
+    interface_gen.set_blob_store(blobs);
+    
     logger.log(OrchestrationLogger::Level::INFO, "TextAnalyzer", 
                text_agent.is_available() ? "Available" : "Fallback mode");
     logger.log(OrchestrationLogger::Level::INFO, "FeedbackAgent", 
@@ -169,7 +176,7 @@ AgentResults run_parallel_agents(OrchestrationLogger& logger, const std::string&
         std::string filename = "interface_" + 
             std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".html";
         std::ofstream file(filename);
-        file << html_data["html"].get<std::string>();
+        file << *blobs->read(html_data["html"]);
         file.close();
         
         logger.log(OrchestrationLogger::Level::INFO, "Main", 
@@ -0,0 +1,385 @@
+/**
+ * @file BlobStore.cpp
+ * @brief Content-addressed blob arena with LRU spill to disk
+ */
+
+#include "BlobStore.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <stdlib.h>  // For mkdtemp
+
+namespace fs = std::filesystem;
+
+namespace EMPI {
+
+namespace {
+
+std::string content_hash(const std::string& data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+/// Content of a file, or null if it cannot be opened
+std::shared_ptr<const std::string> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+bool BlobRef::is_ref(const json& value) {
+    return value.is_object() && value.contains("$blob") && value["$blob"].is_string();
+}
+
+void to_json(json& j, const BlobRef& ref) {
+    j = {{"$blob", ref.handle}, {"size", ref.size}, {"hash", ref.hash}};
+}
+
+void from_json(const json& j, BlobRef& ref) {
+    if (!BlobRef::is_ref(j)) {
+        throw std::invalid_argument("Not a blob reference");
+    }
+    ref.handle = j["$blob"].get<std::string>();
+    ref.size = j.value("size", uint64_t{0});
+    ref.hash = j.value("hash", "");
+}
+
+BlobStore::BlobStore(BlobStoreConfig config)
+    : config_(std::move(config))
+{
+    if (!config_.spill_dir.empty()) {
+        fs::create_directories(config_.spill_dir);
+        return;
+    }
+    std::string pattern = (fs::temp_directory_path() / "empi_blobs_XXXXXX").string();
+    if (!mkdtemp(pattern.data())) {
+        throw std::runtime_error("Cannot create blob spill directory: " + pattern);
+    }
+    config_.spill_dir = pattern;
+    owns_spill_dir_ = true;
+}
+
+BlobStore::~BlobStore() {
+    std::error_code ec;
+    if (owns_spill_dir_) {
+        fs::remove_all(config_.spill_dir, ec);
+        return;
+    }
+    for (const auto& [handle, entry] : entries_) {
+        if (entry.spilled) {
+            fs::remove(spill_path(handle, entry.id), ec);
+        }
+    }
+}
+
+BlobRef BlobStore::put(std::string data) {
+    std::string hash = content_hash(data);
+    std::vector<std::string> unlink;
+    std::vector<Spill> spills;
+    BlobRef ref;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        puts_++;
+        referenced_bytes_ += data.size();
+        expire_locked(now, unlink);
+
+        // Spilled candidates are compared after releasing the lock; their outcome is kept by id
+        std::unordered_map<uint64_t, bool> compared;
+        std::string handle;
+        Entry* match = nullptr;
+        for (bool rescan = true; rescan;) {
+            rescan = false;
+            match = nullptr;
+            // Different content with the same hash gets the next free suffix; existing references keep theirs
+            handle = hash;
+            for (uint32_t n = 1;; ++n) {
+                auto it = entries_.find(handle);
+                if (it == entries_.end()) {
+                    break;
+                }
+                Entry& existing = it->second;
+                bool same = false;
+                if (existing.ref.size != data.size()) {
+                    same = false;
+                } else if (existing.data) {
+                    same = *existing.data == data;
+                } else if (auto seen = compared.find(existing.id); seen != compared.end()) {
+                    same = seen->second;
+                } else {
+                    std::string path = spill_path(handle, existing.id);
+                    uint64_t id = existing.id;
+                    lock.unlock();
+                    std::shared_ptr<const std::string> stored = read_file(path);
+                    // Ids are not reused, so the outcome holds until that spill is gone
+                    compared[id] = stored && *stored == data;
+                    lock.lock();
+                    // The entries may have changed meanwhile
+                    rescan = true;
+                    break;
+                }
+                if (same) {
+                    match = &existing;
+                    break;
+                }
+                handle = hash + "-" + std::to_string(n);
+            }
+        }
+
+        if (match) {
+            dedup_hits_++;
+            match->last_used = now;
+            if (match->spilled || match->spilling) {
+                // Brought back into memory; a spill in progress is discarded when it completes
+                if (match->spilled) {
+                    unlink.push_back(spill_path(handle, match->id));
+                    spilled_bytes_ -= match->ref.size;
+                    match->spilled = false;
+                    match->data = std::make_shared<const std::string>(std::move(data));
+                }
+                match->spilling = false;
+                lru_.push_front(handle);
+                match->lru = lru_.begin();
+                memory_bytes_ += match->ref.size;
+            } else {
+                lru_.splice(lru_.begin(), lru_, match->lru);
+            }
+            ref = match->ref;
+        } else {
+            Entry entry;
+            entry.ref = {handle, data.size(), hash};
+            entry.id = ++next_id_;
+            entry.data = std::make_shared<const std::string>(std::move(data));
+            entry.last_used = now;
+            lru_.push_front(handle);
+            entry.lru = lru_.begin();
+            memory_bytes_ += entry.ref.size;
+            ref = entry.ref;
+            entries_[handle] = std::move(entry);
+        }
+        spills = evict_locked();
+    }
+
+    std::error_code ec;
+    for (const auto& path : unlink) {
+        fs::remove(path, ec);
+    }
+    write_spills(std::move(spills));
+    return ref;
+}
+
+std::shared_ptr<const std::string> BlobStore::get(const BlobRef& ref) const {
+    // A spilled blob stored again meanwhile is back in memory (or spilled anew) and its file gone, hence another look
+    uint64_t read_id = 0;
+    for (int attempt = 0;; ++attempt) {
+        std::string path;
+        std::string hash;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(ref.handle);
+            if (it == entries_.end()) {
+                throw std::runtime_error("Unknown blob: " + ref.handle);
+            }
+            const Entry& entry = it->second;
+            const BlobRef& stored = entry.ref;
+            if (ref.size != stored.size || (!ref.hash.empty() && ref.hash != stored.hash)) {
+                throw std::runtime_error("Blob does not match its reference: " + ref.handle);
+            }
+            if (attempt == 0) {
+                reads_++;
+            }
+            entry.last_used = Clock::now();
+            if (entry.data) {
+                if (!entry.spilling) {
+                    lru_.splice(lru_.begin(), lru_, entry.lru);
+                }
+                return entry.data;
+            }
+            if (entry.id == read_id) {
+                throw std::runtime_error("Cannot read spilled blob: " + spill_path(ref.handle, entry.id));
+            }
+            read_id = entry.id;
+            path = spill_path(ref.handle, entry.id);
+            hash = stored.hash;
+        }
+
+        std::shared_ptr<const std::string> data = read_file(path);
+        if (!data) {
+            continue;
+        }
+        if (data->size() != ref.size || content_hash(*data) != hash) {
+            throw std::runtime_error("Spilled blob does not match its reference: " + ref.handle);
+        }
+        return data;
+    }
+}
+
+bool BlobStore::contains(const std::string& handle) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(handle) > 0;
+}
+
+void BlobStore::erase(const std::string& handle) {
+    std::vector<std::string> unlink;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle);
+        if (it == entries_.end()) return;
+        remove_locked(it, unlink);
+    }
+    std::error_code ec;
+    for (const auto& path : unlink) {
+        fs::remove(path, ec);
+    }
+}
+
+json BlobStore::wrap(std::string value) {
+    if (value.size() < config_.inline_limit) {
+        return value;
+    }
+    return put(std::move(value));
+}
+
+std::shared_ptr<const std::string> BlobStore::read(const json& value) const {
+    if (value.is_string()) {
+        return std::make_shared<const std::string>(value.get_ref<const std::string&>());
+    }
+    if (BlobRef::is_ref(value)) {
+        return get(value.get<BlobRef>());
+    }
+    throw std::invalid_argument("Expected a string or a blob reference");
+}
+
+json BlobStore::materialize(const json& value) const {
+    if (BlobRef::is_ref(value)) {
+        return *get(value.get<BlobRef>());
+    }
+    if (value.is_structured()) {
+        json copy = value.is_object() ? json::object() : json::array();
+        for (auto it = value.begin(); it != value.end(); ++it) {
+            if (value.is_object()) {
+                copy[it.key()] = materialize(it.value());
+            } else {
+                copy.push_back(materialize(it.value()));
+            }
+        }
+        return copy;
+    }
+    return value;
+}
+
+json BlobStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"blobs", entries_.size()},
+        {"memory_bytes", memory_bytes_},
+        {"spilled_bytes", spilled_bytes_},
+        {"dropped", dropped_},
+        {"expired", expired_},
+        {"puts", puts_},
+        {"dedup_hits", dedup_hits_},
+        {"reads", reads_},
+        {"referenced_bytes", referenced_bytes_}
+    };
+}
+
+std::string BlobStore::spill_path(const std::string& handle, uint64_t id) const {
+    return (fs::path(config_.spill_dir) / (handle + "." + std::to_string(id) + ".blob")).string();
+}
+
+void BlobStore::remove_locked(std::unordered_map<std::string, Entry>::iterator it,
+                              std::vector<std::string>& unlink) {
+    Entry& entry = it->second;
+    if (entry.spilled) {
+        unlink.push_back(spill_path(it->first, entry.id));
+        spilled_bytes_ -= entry.ref.size;
+    } else if (!entry.spilling) {
+        memory_bytes_ -= entry.ref.size;
+        lru_.erase(entry.lru);
+    }
+    // A spill in progress finds the entry gone and removes its own file
+    entries_.erase(it);
+}
+
+void BlobStore::expire_locked(Clock::time_point now, std::vector<std::string>& unlink) {
+    if (config_.ttl.count() <= 0 || now < next_expiry_check_) {
+        return;
+    }
+    // Scanning a few times per lifetime keeps expiry within ttl * 9/8
+    next_expiry_check_ = now + std::max<Clock::duration>(config_.ttl / 8, std::chrono::milliseconds(1));
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto next = std::next(it);
+        if (now - it->second.last_used >= config_.ttl) {
+            remove_locked(it, unlink);
+            expired_++;
+        }
+        it = next;
+    }
+}
+
+std::vector<BlobStore::Spill> BlobStore::evict_locked() {
+    std::vector<Spill> spills;
+    // Never evict the blob just stored, so put() always returns a readable reference
+    while (memory_bytes_ > config_.max_memory_bytes && lru_.size() > 1) {
+        std::string handle = lru_.back();
+        lru_.pop_back();
+        Entry& entry = entries_.at(handle);
+        memory_bytes_ -= entry.ref.size;
+        // Still served from memory until the file is written; every spill gets its own file
+        entry.spilling = true;
+        entry.id = ++next_id_;
+        spills.push_back({handle, entry.id, entry.data});
+    }
+    return spills;
+}
+
+void BlobStore::write_spills(std::vector<Spill> spills) {
+    for (auto& spill : spills) {
+        std::string path = spill_path(spill.handle, spill.id);
+        bool written;
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(spill.data->data(), static_cast<std::streamsize>(spill.data->size()));
+            written = static_cast<bool>(file.flush());
+        }
+
+        bool keep_file = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(spill.handle);
+            // Unless the blob was erased, expired or stored again meanwhile
+            if (it != entries_.end() && it->second.id == spill.id && it->second.spilling) {
+                Entry& entry = it->second;
+                entry.spilling = false;
+                if (written) {
+                    entry.spilled = true;
+                    entry.data.reset();
+                    spilled_bytes_ += entry.ref.size;
+                    keep_file = true;
+                } else {
+                    entries_.erase(it);
+                    dropped_++;
+                }
+            }
+        }
+        if (!keep_file) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+}
+
+} // namespace EMPI
@@ -0,0 +1,178 @@
+#pragma once
+
+/**
+ * @file BlobStore.hpp
+ * @brief Out-of-band storage for large strings carried in EMPI payloads.
+ *
+ * A generated page or a source document can be tens of kilobytes. As a
+ * JSON string it is escaped, copied and parsed again at every hop. With a
+ * BlobStore the payload carries a reference instead:
+ *
+ *     {"$blob": "3f1c9a7e5b2d4c60", "size": 48213, "hash": "3f1c9a7e5b2d4c60"}
+ *
+ * The bytes stay in one shared, immutable buffer until a consumer reads
+ * them. Blobs are content-addressed, so storing the same page twice
+ * (e.g. a cache hit) costs nothing. The handle is the content hash, with a
+ * suffix in the unlikely case that different content has the same hash.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct BlobRef
+ * @brief Handle, size and content hash of a stored blob.
+ */
+struct BlobRef {
+    std::string handle;
+    uint64_t size = 0;
+    /// FNV-1a 64 of the content, 16 hex digits
+    std::string hash;
+
+    /**
+     * @brief True if `value` is a serialized BlobRef ({"$blob": ...}).
+     */
+    static bool is_ref(const json& value);
+};
+
+void to_json(json& j, const BlobRef& ref);
+void from_json(const json& j, BlobRef& ref);
+
+/**
+ * @struct BlobStoreConfig
+ * @brief Inline threshold, memory budget and lifetime of the blobs in a BlobStore.
+ */
+struct BlobStoreConfig {
+    /// Strings shorter than this stay inline in the payload (see BlobStore::wrap())
+    size_t inline_limit = 4096;
+    /// Bytes kept in memory; least recently used blobs beyond it are spilled to disk
+    uint64_t max_memory_bytes = 64ull * 1024 * 1024;
+    /// Directory for spilled blobs; empty uses a private directory in the system
+    /// temp directory, removed with the store
+    std::string spill_dir;
+    /// Blobs neither stored nor read for this long are removed, from memory
+    /// and disk; zero keeps them until erase()
+    std::chrono::milliseconds ttl = std::chrono::minutes(10);
+};
+
+/**
+ * @class BlobStore
+ * @brief Shared arena of immutable blobs, spilling to files past its memory budget.
+ *
+ * Agents in one process share a store (UniversalAgent::set_blob_store()).
+ * get() hands out the stored buffer itself, so a consumer holding it is not
+ * affected by a later eviction. Blobs beyond the memory budget are spilled,
+ * so references stay valid until the blob expires (see BlobStoreConfig::ttl)
+ * or is erased; only a blob whose file cannot be written (disk full) is
+ * dropped early.
+ *
+ * Thread-safe. Spill files are written and read without holding the lock.
+ */
+class BlobStore {
+public:
+    explicit BlobStore(BlobStoreConfig config = {});
+    ~BlobStore();
+
+    BlobStore(const BlobStore&) = delete;
+    BlobStore& operator=(const BlobStore&) = delete;
+
+    /**
+     * @brief Stores `data` and returns its reference; an identical blob is reused.
+     *
+     * Also removes expired blobs. A blob that cannot be spilled (disk full) is dropped.
+     */
+    BlobRef put(std::string data);
+
+    /**
+     * @brief The content of a blob, read back from disk if it was spilled.
+     *
+     * @throws std::runtime_error If the blob is unknown or was dropped, or its size, hash or file does not match the reference
+     */
+    std::shared_ptr<const std::string> get(const BlobRef& ref) const;
+
+    bool contains(const std::string& handle) const;
+    void erase(const std::string& handle);
+
+    /**
+     * @brief `value` as an inline string, or as a reference if it reaches the inline limit.
+     */
+    json wrap(std::string value);
+
+    /**
+     * @brief The string behind an inline string or a reference.
+     *
+     * @throws std::invalid_argument If `value` is neither
+     */
+    std::shared_ptr<const std::string> read(const json& value) const;
+
+    /**
+     * @brief Copy of `value` with every reference replaced by its content.
+     */
+    json materialize(const json& value) const;
+
+    /**
+     * @brief Blob count, memory and spilled bytes, drops, expirations, puts, dedup hits, reads and bytes kept out of payloads.
+     */
+    json stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        /// Set while resident or being spilled
+        std::shared_ptr<const std::string> data;
+        BlobRef ref;
+        /// Unique per stored blob and renewed by every spill; names the spill file
+        uint64_t id = 0;
+        bool spilling = false;
+        bool spilled = false;
+        std::list<std::string>::iterator lru;
+        mutable Clock::time_point last_used;
+    };
+
+    /// A blob chosen for eviction, written out after the lock is released
+    struct Spill {
+        std::string handle;
+        uint64_t id = 0;
+        std::shared_ptr<const std::string> data;
+    };
+
+    std::string spill_path(const std::string& handle, uint64_t id) const;
+    /// Removes an entry; its spill file, if any, is added to `unlink` for removal outside the lock
+    void remove_locked(std::unordered_map<std::string, Entry>::iterator it, std::vector<std::string>& unlink);
+    void expire_locked(Clock::time_point now, std::vector<std::string>& unlink);
+    std::vector<Spill> evict_locked();
+    /// Writes the spills and records the outcome; called without the lock
+    void write_spills(std::vector<Spill> spills);
+
+    BlobStoreConfig config_;
+    /// spill_dir was created by the store and is removed with it
+    bool owns_spill_dir_ = false;
+    std::unordered_map<std::string, Entry> entries_;
+    /// Resident blobs, most recently used first
+    mutable std::list<std::string> lru_;
+    uint64_t memory_bytes_ = 0;
+    uint64_t spilled_bytes_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t expired_ = 0;
+    uint64_t next_id_ = 0;
+    Clock::time_point next_expiry_check_{};
+    uint64_t puts_ = 0;
+    uint64_t dedup_hits_ = 0;
+    mutable uint64_t reads_ = 0;
+    uint64_t referenced_bytes_ = 0;
+    mutable std::mutex mutex_;
+};
+
+} // namespace EMPI
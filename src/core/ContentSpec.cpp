@@ -0,0 +1,256 @@
+/**
+ * @file ContentSpec.cpp
+ * @brief Compact content spec and outline: grammars, parsing and native HTML rendering
+ */
+
+#include "ContentSpec.hpp"
+#include "InterfacePatcher.hpp"
+#include <cctype>
+#include <stdexcept>
+
+namespace EMPI {
+
+// Every string and list is bounded so that the longest spec, in characters, fits
+// kContentSpecMaxTokens; test_content_spec checks the sum
+const char* const kContentSpecGrammar = R"GBNF(
+root     ::= "{" ws "\"t\":" ws title "," ws "\"s\":" ws sections "," ws "\"k\":" ws points "," ws "\"g\":" ws glossary "," ws "\"n\":" ws note ws "}"
+sections ::= "[" ws section ("," ws section){0,3} ws "]"
+section  ::= "{" ws "\"h\":" ws heading "," ws "\"p\":" ws "[" ws para ("," ws para){0,2} ws "]" ws "}"
+points   ::= "[" ws (point ("," ws point){0,3})? ws "]"
+glossary ::= "[" ws (entry ("," ws entry){0,2})? ws "]"
+entry    ::= "[" ws term "," ws define ws "]"
+title    ::= "\"" char{0,48} "\""
+heading  ::= "\"" char{0,40} "\""
+para     ::= "\"" char{0,88} "\""
+point    ::= "\"" char{0,56} "\""
+term     ::= "\"" char{0,24} "\""
+define   ::= "\"" char{0,56} "\""
+note     ::= "\"" char{0,80} "\""
+char     ::= [^"\\\x7F\x00-\x1F]
+ws       ::= [ \n]?
+)GBNF";
+
+const char* const kOutlineGrammar = R"GBNF(
+root     ::= "{" ws "\"t\":" ws title "," ws "\"o\":" ws items "," ws "\"k\":" ws points ws "}"
+items    ::= "[" ws item ("," ws item){0,3} ws "]"
+item     ::= "[" ws heading "," ws intent ws "]"
+points   ::= "[" ws (point ("," ws point){0,2})? ws "]"
+title    ::= "\"" char{0,48} "\""
+heading  ::= "\"" char{0,40} "\""
+intent   ::= "\"" char{0,64} "\""
+point    ::= "\"" char{0,48} "\""
+char     ::= [^"\\\x7F\x00-\x1F]
+ws       ::= [ \n]?
+)GBNF";
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::string lowercase(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+json parse_object(const std::string& output, const char* what) {
+    size_t begin = output.find('{');
+    size_t end = output.rfind('}');
+    if (begin == std::string::npos || end == std::string::npos || end < begin) {
+        throw std::runtime_error(std::string("No ") + what + " object in model output");
+    }
+
+    json parsed = json::parse(output.begin() + begin, output.begin() + end + 1, nullptr, false);
+    if (parsed.is_discarded() || !parsed.is_object()) {
+        std::string name = what;
+        name[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(name[0])));
+        throw std::runtime_error(name + " is not valid JSON (truncated output?)");
+    }
+    return parsed;
+}
+
+std::string escape_html(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 8);
+    for (char c : text) {
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            case '\'': out += "&#39;"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> string_list(const json& j, const char* key) {
+    std::vector<std::string> values;
+    auto it = j.find(key);
+    if (it == j.end() || !it->is_array()) return values;
+    for (const auto& value : *it) {
+        if (value.is_string() && !value.get_ref<const std::string&>().empty()) {
+            values.push_back(value.get<std::string>());
+        }
+    }
+    return values;
+}
+
+void render_key_points(std::string& html, const std::vector<std::string>& points) {
+    if (points.empty()) return;
+    html += "<section aria-labelledby=\"key-points\">\n<h2 id=\"key-points\">Key points</h2>\n<ul>\n";
+    for (const auto& point : points) {
+        html += "<li>" + escape_html(point) + "</li>\n";
+    }
+    html += "</ul>\n</section>\n";
+}
+
+} // namespace
+
+void to_json(json& j, const ContentSpec& spec) {
+    json sections = json::array();
+    for (const auto& section : spec.sections) {
+        sections.push_back({{"h", section.heading}, {"p", section.paragraphs}});
+    }
+    json glossary = json::array();
+    for (const auto& entry : spec.glossary) {
+        glossary.push_back({entry.term, entry.definition});
+    }
+    j = {
+        {"t", spec.title},
+        {"s", sections},
+        {"k", spec.key_points},
+        {"g", glossary},
+        {"n", spec.adaptation_note}
+    };
+}
+
+void from_json(const json& j, ContentSpec& spec) {
+    spec = ContentSpec{};
+    spec.title = j.value("t", "");
+    if (j.contains("s") && j["s"].is_array()) {
+        for (const auto& item : j["s"]) {
+            if (!item.is_object()) continue;
+            ContentSection section;
+            section.heading = item.value("h", "");
+            section.paragraphs = string_list(item, "p");
+            if (!section.heading.empty() || !section.paragraphs.empty()) {
+                spec.sections.push_back(std::move(section));
+            }
+        }
+    }
+    spec.key_points = string_list(j, "k");
+    if (j.contains("g") && j["g"].is_array()) {
+        for (const auto& item : j["g"]) {
+            if (item.is_array() && item.size() == 2 && item[0].is_string() && item[1].is_string()) {
+                spec.glossary.push_back({item[0].get<std::string>(), item[1].get<std::string>()});
+            }
+        }
+    }
+    spec.adaptation_note = j.value("n", "");
+}
+
+ContentSpec parse_content_spec(const std::string& output) {
+    ContentSpec spec = parse_object(output, "content spec").get<ContentSpec>();
+    if (spec.sections.empty()) {
+        throw std::runtime_error("Content spec has no sections");
+    }
+    return spec;
+}
+
+PageOutline parse_outline(const std::string& output) {
+    json parsed = parse_object(output, "outline");
+
+    PageOutline outline;
+    outline.title = parsed.value("t", "");
+    if (parsed.contains("o") && parsed["o"].is_array()) {
+        for (const auto& item : parsed["o"]) {
+            if (item.is_array() && item.size() == 2 && item[0].is_string() && item[1].is_string() &&
+                !item[0].get_ref<const std::string&>().empty()) {
+                outline.items.push_back({item[0].get<std::string>(), item[1].get<std::string>()});
+            }
+        }
+    }
+    outline.key_points = string_list(parsed, "k");
+    if (outline.items.empty()) {
+        throw std::runtime_error("Outline has no sections");
+    }
+    return outline;
+}
+
+ContentSection section_from_text(const std::string& heading, const std::string& body) {
+    ContentSection section;
+    section.heading = heading;
+    std::string heading_key = lowercase(trim(heading));
+
+    size_t start = 0;
+    while (start <= body.size()) {
+        size_t end = body.find('\n', start);
+        if (end == std::string::npos) end = body.size();
+        std::string line = trim(body.substr(start, end - start));
+        start = end + 1;
+
+        if (line.empty() || line[0] == '#') continue;
+        if (line.size() > 1 && (line[0] == '-' || line[0] == '*') && line[1] == ' ') {
+            line = trim(line.substr(2));
+        }
+        if (section.paragraphs.empty() && lowercase(line) == heading_key) continue;
+        if (!line.empty()) section.paragraphs.push_back(line);
+    }
+    return section;
+}
+
+std::string render_content_spec(const ContentSpec& spec, const ProfileFlags& profile) {
+    std::string title = spec.title.empty() ? "Adapted text" : spec.title;
+    bool points_first = profile.has(Need::ADHD) || profile.has(Need::ASD) ||
+                        profile.has(Need::Anxiety) || profile.density > 0;
+
+    std::string html =
+        "<!DOCTYPE html>\n<html lang=\"en\">\n<head>\n<meta charset=\"utf-8\">\n"
+        "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">\n"
+        "<title>" + escape_html(title) + "</title>\n</head>\n<body>\n<main id=\"content\">\n"
+        "<h1>" + escape_html(title) + "</h1>\n";
+
+    if (points_first) render_key_points(html, spec.key_points);
+
+    for (size_t i = 0; i < spec.sections.size(); ++i) {
+        const ContentSection& section = spec.sections[i];
+        std::string id = "section-" + std::to_string(i + 1);
+        html += "<section aria-labelledby=\"" + id + "\">\n";
+        html += "<h2 id=\"" + id + "\">" +
+                escape_html(section.heading.empty() ? "Part " + std::to_string(i + 1) : section.heading) + "</h2>\n";
+        for (const auto& paragraph : section.paragraphs) {
+            html += "<p>" + escape_html(paragraph) + "</p>\n";
+        }
+        html += "</section>\n";
+    }
+
+    if (!points_first) render_key_points(html, spec.key_points);
+
+    if (!spec.glossary.empty()) {
+        bool simple = profile.has(Need::Child) || profile.has(Need::Dyslexia);
+        html += "<section aria-labelledby=\"glossary\">\n<h2 id=\"glossary\">";
+        html += simple ? "Words to know" : "Glossary";
+        html += "</h2>\n<dl>\n";
+        for (const auto& entry : spec.glossary) {
+            html += "<dt>" + escape_html(entry.term) + "</dt>\n<dd>" + escape_html(entry.definition) + "</dd>\n";
+        }
+        html += "</dl>\n</section>\n";
+    }
+
+    html += "</main>\n";
+    if (!spec.adaptation_note.empty()) {
+        html += "<footer>\n<p>About this version: " + escape_html(spec.adaptation_note) + "</p>\n</footer>\n";
+    }
+    html += "</body>\n</html>\n";
+
+    apply_profile_stylesheet(html, profile);
+    return html;
+}
+
+} // namespace EMPI
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "ProfileFlags.hpp"
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct ContentSection
+ * @brief One titled block of adapted text.
+ */
+struct ContentSection {
+    std::string heading;
+    std::vector<std::string> paragraphs;
+};
+
+/**
+ * @struct GlossaryEntry
+ * @brief A term of the adapted text and its plain-language definition.
+ */
+struct GlossaryEntry {
+    std::string term;
+    std::string definition;
+};
+
+/**
+ * @struct ContentSpec
+ * @brief Compact description of an adapted page: content only, no markup.
+ *
+ * In content-spec mode the model emits this structure instead of HTML, with
+ * one-letter keys to keep the output short:
+ *
+ *   {"t": title, "s": [{"h": heading, "p": [paragraph, ...]}, ...],
+ *    "k": [key point, ...], "g": [[term, definition], ...], "n": note}
+ *
+ * `n` explains the adaptations made for the reader. render_content_spec()
+ * turns the spec into the page.
+ */
+struct ContentSpec {
+    std::string title;
+    std::vector<ContentSection> sections;
+    std::vector<std::string> key_points;
+    std::vector<GlossaryEntry> glossary;
+    std::string adaptation_note;
+};
+
+void to_json(json& j, const ContentSpec& spec);
+void from_json(const json& j, ContentSpec& spec);
+
+/**
+ * @brief GBNF grammar for the compact spec, for llama_sampler_init_grammar (root rule "root").
+ *
+ * Bounds the number of sections and list items and the length of every
+ * string (no escapes, at most one whitespace between tokens), so that the
+ * longest spec has no more characters than kContentSpecMaxTokens. A
+ * tokenizer that needs several tokens for one character (byte fallback for
+ * rare scripts) can still hit the budget first; callers must handle the
+ * parse error.
+ */
+extern const char* const kContentSpecGrammar;
+
+/// Generation budget of a content spec, in tokens
+constexpr int kContentSpecMaxTokens = 2048;
+
+/**
+ * @brief Parses model output into a spec; text around the JSON object is ignored.
+ *
+ * @throws std::runtime_error If no complete spec object is found or it has no sections
+ */
+ContentSpec parse_content_spec(const std::string& output);
+
+/**
+ * @struct OutlineItem
+ * @brief A planned section: its heading and what the body should cover.
+ */
+struct OutlineItem {
+    std::string heading;
+    std::string intent;
+};
+
+/**
+ * @struct PageOutline
+ * @brief Skeleton of an adapted page, generated before the section bodies.
+ *
+ * Compact form: {"t": title, "o": [[heading, intent], ...], "k": [key point, ...]}.
+ * Each outline item becomes one independently generated section.
+ */
+struct PageOutline {
+    std::string title;
+    std::vector<OutlineItem> items;
+    std::vector<std::string> key_points;
+};
+
+/**
+ * @brief GBNF grammar for the compact outline (1-4 items), root rule "root".
+ *
+ * Bounded like kContentSpecGrammar, to kOutlineMaxTokens characters.
+ */
+extern const char* const kOutlineGrammar;
+
+/// Generation budget of an outline, in tokens
+constexpr int kOutlineMaxTokens = 768;
+
+/**
+ * @brief Parses model output into an outline; text around the JSON object is ignored.
+ *
+ * @throws std::runtime_error If no complete outline object is found or it has no items
+ */
+PageOutline parse_outline(const std::string& output);
+
+/**
+ * @brief Builds a section from a generated plain-text body.
+ *
+ * Each non-empty line becomes a paragraph. Markdown heading lines and a
+ * leading line repeating the heading are dropped, and list markers are
+ * stripped, since the renderer supplies the structure.
+ */
+ContentSection section_from_text(const std::string& heading, const std::string& body);
+
+/**
+ * @brief Renders a spec as a complete, well-formed HTML5 page for a profile.
+ *
+ * All text is escaped. The need preset stylesheet is embedded, key points
+ * come first for readers who need structure up front (ADHD, ASD, anxiety or
+ * denser profiles) and last otherwise.
+ */
+std::string render_content_spec(const ContentSpec& spec, const ProfileFlags& profile);
+
+} // namespace EMPI
@@ -0,0 +1,203 @@
+/**
+ * @file ContextPool.cpp
+ * @brief Size-classed pool of llama contexts sharing one model
+ */
+
+#include "ContextPool.hpp"
+#include "RequestCost.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace EMPI {
+
+struct ContextPool::Lease::Slot {
+    llama_context* ctx = nullptr;
+    size_t class_index = 0;
+    bool in_use = false;
+};
+
+ContextPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), slot_(other.slot_)
+{
+    other.pool_ = nullptr;
+    other.slot_ = nullptr;
+}
+
+ContextPool::Lease& ContextPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        slot_ = other.slot_;
+        other.pool_ = nullptr;
+        other.slot_ = nullptr;
+    }
+    return *this;
+}
+
+ContextPool::Lease::~Lease() {
+    release();
+}
+
+llama_context* ContextPool::Lease::get() const {
+    return slot_ ? slot_->ctx : nullptr;
+}
+
+uint32_t ContextPool::Lease::n_ctx() const {
+    return slot_ ? pool_->classes_[slot_->class_index].n_ctx : 0;
+}
+
+void ContextPool::Lease::release() {
+    if (slot_) {
+        pool_->give_back(slot_);
+        slot_ = nullptr;
+        pool_ = nullptr;
+    }
+}
+
+ContextPool::ContextPool(ContextPoolConfig config, Factory create, Deleter destroy)
+    : config_(std::move(config))
+    , create_(std::move(create))
+    , destroy_(std::move(destroy))
+{
+    std::sort(config_.size_classes.begin(), config_.size_classes.end());
+    config_.size_classes.erase(std::unique(config_.size_classes.begin(), config_.size_classes.end()),
+                               config_.size_classes.end());
+    if (config_.size_classes.empty()) {
+        throw std::invalid_argument("ContextPool needs at least one size class");
+    }
+    config_.max_per_class = std::max<size_t>(1, config_.max_per_class);
+
+    for (uint32_t n_ctx : config_.size_classes) {
+        Class size_class;
+        size_class.n_ctx = n_ctx;
+        classes_.push_back(std::move(size_class));
+    }
+}
+
+ContextPool::~ContextPool() {
+    for (auto& size_class : classes_) {
+        for (auto& slot : size_class.slots) {
+            if (slot->ctx) destroy_(slot->ctx);
+        }
+    }
+}
+
+size_t ContextPool::select_class(const std::vector<uint32_t>& size_classes, size_t tokens) {
+    for (size_t i = 0; i < size_classes.size(); ++i) {
+        if (size_classes[i] >= tokens) return i;
+    }
+    return size_classes.empty() ? 0 : size_classes.size() - 1;
+}
+
+ContextPool::Lease ContextPool::acquire(size_t tokens) {
+    size_t wanted = select_class(config_.size_classes, tokens);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // A free context of the class or any larger one
+        for (size_t c = wanted; c < classes_.size(); ++c) {
+            for (auto& slot : classes_[c].slots) {
+                if (!slot->in_use && slot->ctx) {
+                    slot->in_use = true;
+                    classes_[c].leases++;
+                    if (c != wanted) classes_[wanted].upgraded++;
+                    return Lease(this, slot.get());
+                }
+            }
+        }
+
+        // Otherwise room to create one; creation runs outside the lock
+        for (size_t c = wanted; c < classes_.size(); ++c) {
+            if (classes_[c].slots.size() >= config_.max_per_class) continue;
+
+            classes_[c].slots.push_back(std::make_unique<Lease::Slot>());
+            Lease::Slot* slot = classes_[c].slots.back().get();
+            slot->class_index = c;
+            slot->in_use = true;
+            uint32_t n_ctx = classes_[c].n_ctx;
+
+            lock.unlock();
+            llama_context* ctx = nullptr;
+            try {
+                ctx = create_(n_ctx);
+            } catch (...) {
+            }
+            lock.lock();
+
+            auto& slots = classes_[c].slots;
+            if (!ctx) {
+                slots.erase(std::find_if(slots.begin(), slots.end(),
+                                         [slot](const auto& s) { return s.get() == slot; }));
+                available_.notify_all();
+                throw std::runtime_error("Failed to create context of " + std::to_string(n_ctx) + " tokens");
+            }
+            slot->ctx = ctx;
+            classes_[c].leases++;
+            if (c != wanted) classes_[wanted].upgraded++;
+            return Lease(this, slot);
+        }
+
+        auto waiting = std::chrono::steady_clock::now();
+        available_.wait(lock);
+        record_queue_wait_ms(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waiting).count());
+    }
+}
+
+size_t ContextPool::trim() {
+    std::vector<llama_context*> freed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& size_class : classes_) {
+            auto& slots = size_class.slots;
+            for (auto it = slots.begin(); it != slots.end();) {
+                // Slots without a context are still being created by acquire()
+                if (!(*it)->in_use && (*it)->ctx) {
+                    freed.push_back((*it)->ctx);
+                    it = slots.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        trimmed_ += freed.size();
+    }
+    for (llama_context* ctx : freed) {
+        destroy_(ctx);
+    }
+    return freed.size();
+}
+
+void ContextPool::give_back(Lease::Slot* slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->in_use = false;
+    }
+    available_.notify_all();
+}
+
+json ContextPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json classes = json::array();
+    uint64_t kv_tokens = 0;
+    for (const auto& size_class : classes_) {
+        size_t in_use = std::count_if(size_class.slots.begin(), size_class.slots.end(),
+                                      [](const auto& slot) { return slot->in_use; });
+        kv_tokens += static_cast<uint64_t>(size_class.n_ctx) * size_class.slots.size();
+        classes.push_back({
+            {"n_ctx", size_class.n_ctx},
+            {"contexts", size_class.slots.size()},
+            {"in_use", in_use},
+            {"leases", size_class.leases},
+            {"upgraded", size_class.upgraded}
+        });
+    }
+    return {
+        {"classes", classes},
+        {"max_per_class", config_.max_per_class},
+        {"allocated_kv_tokens", kv_tokens},
+        {"trimmed", trimmed_}
+    };
+}
+
+} // namespace EMPI
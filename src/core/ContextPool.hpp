@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+struct llama_context;
+
+namespace EMPI {
+
+/**
+ * @struct ContextPoolConfig
+ * @brief Size classes and per-class limits of a ContextPool.
+ */
+struct ContextPoolConfig {
+    /// Context sizes (n_ctx) in ascending order
+    std::vector<uint32_t> size_classes = {1024, 2048, 4096};
+    /// Most contexts alive per class; bounds the KV memory of each class
+    size_t max_per_class = 2;
+};
+
+/**
+ * @class ContextPool
+ * @brief Lazily created llama contexts of several sizes over one model.
+ *
+ * A request leases the smallest free context whose n_ctx fits its prompt
+ * plus output budget, so a 300-token feedback prompt uses a 1k context
+ * instead of the agent's largest one. Contexts are created on first use by
+ * the factory and reused afterwards; the KV cache they hold is cleared by
+ * the decode loop at the start of every call. When a class is exhausted a
+ * larger free or creatable context is used, and only when none is left does
+ * acquire() wait for a lease to be returned. Requests larger than the
+ * largest class get the largest class (generate_text() shifts the context).
+ *
+ * The factory and deleter keep this independent of llama.cpp; the agents
+ * pass llama_init_from_model / llama_free with their context parameters.
+ *
+ * Thread-safe.
+ */
+class ContextPool {
+public:
+    using Factory = std::function<llama_context*(uint32_t n_ctx)>;
+    using Deleter = std::function<void(llama_context*)>;
+
+    /**
+     * @class Lease
+     * @brief Exclusive use of one pooled context; returns it to the pool on destruction.
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        llama_context* get() const;
+        uint32_t n_ctx() const;
+        explicit operator bool() const { return slot_ != nullptr; }
+
+        /**
+         * @brief Returns the context to the pool early.
+         */
+        void release();
+
+    private:
+        friend class ContextPool;
+        struct Slot;
+        Lease(ContextPool* pool, Slot* slot) : pool_(pool), slot_(slot) {}
+
+        ContextPool* pool_ = nullptr;
+        Slot* slot_ = nullptr;
+    };
+
+    ContextPool(ContextPoolConfig config, Factory create, Deleter destroy);
+    ~ContextPool();
+
+    ContextPool(const ContextPool&) = delete;
+    ContextPool& operator=(const ContextPool&) = delete;
+
+    /**
+     * @brief Leases a context with room for `tokens` (prompt plus maximum output).
+     *
+     * @throws std::runtime_error If the factory fails to create a context
+     */
+    Lease acquire(size_t tokens);
+
+    /**
+     * @brief Frees every context that is not leased; later requests create them again.
+     *
+     * @return Number of contexts freed
+     */
+    size_t trim();
+
+    /**
+     * @brief Index of the smallest class with n_ctx >= tokens, or the last class.
+     */
+    static size_t select_class(const std::vector<uint32_t>& size_classes, size_t tokens);
+
+    /**
+     * @brief Per-class contexts, leases in use and lease counts, the allocated KV token total and trims.
+     */
+    json stats() const;
+
+private:
+    struct Class {
+        uint32_t n_ctx = 0;
+        std::vector<std::unique_ptr<Lease::Slot>> slots;
+        uint64_t leases = 0;
+        /// Requests for this class served by a larger one
+        uint64_t upgraded = 0;
+    };
+
+    void give_back(Lease::Slot* slot);
+
+    ContextPoolConfig config_;
+    Factory create_;
+    Deleter destroy_;
+    std::vector<Class> classes_;
+    uint64_t trimmed_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+};
+
+} // namespace EMPI
@@ -0,0 +1,189 @@
+/**
+ * @file CpuBudget.cpp
+ * @brief Core leases shared by queue pressure
+ */
+
+#include "CpuBudget.hpp"
+#include "RequestCost.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace EMPI {
+
+CpuLease::CpuLease(CpuLease&& other) noexcept
+    : budget_(other.budget_)
+    , consumer_(std::move(other.consumer_))
+    , cores_(other.cores_)
+    , want_(other.want_)
+    , min_(other.min_)
+{
+    other.budget_ = nullptr;
+    other.cores_ = 0;
+}
+
+CpuLease& CpuLease::operator=(CpuLease&& other) noexcept {
+    if (this != &other) {
+        release();
+        budget_ = other.budget_;
+        consumer_ = std::move(other.consumer_);
+        cores_ = other.cores_;
+        want_ = other.want_;
+        min_ = other.min_;
+        other.budget_ = nullptr;
+        other.cores_ = 0;
+    }
+    return *this;
+}
+
+CpuLease::~CpuLease() {
+    release();
+}
+
+bool CpuLease::refresh() {
+    return budget_ ? budget_->refresh(*this) : false;
+}
+
+void CpuLease::release() {
+    if (budget_) {
+        budget_->give_back(*this);
+        budget_ = nullptr;
+        cores_ = 0;
+    }
+}
+
+CpuBudget::CpuBudget(size_t cores)
+    : cores_(cores)
+{
+    if (cores_ == 0) {
+        const char* configured = std::getenv("EMPI_CPU_CORES");
+        cores_ = configured ? std::strtoul(configured, nullptr, 10) : 0;
+    }
+    if (cores_ == 0) {
+        cores_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    free_ = cores_;
+}
+
+CpuBudget& CpuBudget::global() {
+    static CpuBudget budget;
+    return budget;
+}
+
+size_t CpuBudget::share_locked(const std::string& consumer) const {
+    size_t total = 0;
+    for (const auto& [name, state] : consumers_) {
+        total += state.leases + state.waiting;
+    }
+    auto it = consumers_.find(consumer);
+    size_t pressure = it == consumers_.end() ? 0 : it->second.leases + it->second.waiting;
+    if (total == 0 || pressure == 0) return cores_;
+    return std::max<size_t>(1, cores_ * pressure / total);
+}
+
+bool CpuBudget::others_waiting_locked(const std::string& consumer) const {
+    for (const auto& [name, state] : consumers_) {
+        if (name != consumer && state.waiting > 0) return true;
+    }
+    return false;
+}
+
+CpuLease CpuBudget::acquire(const std::string& consumer, size_t want, size_t min) {
+    want = std::clamp<size_t>(want, 1, cores_);
+    min = std::clamp<size_t>(min, 1, want);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Consumer& state = consumers_[consumer];
+    auto started = std::chrono::steady_clock::now();
+    state.waiting++;
+    size_t grant = 0;
+    while (true) {
+        size_t share = share_locked(consumer);
+        size_t allowance = share > state.held ? share - state.held : 0;
+        if (state.held == 0) allowance = std::max(allowance, min);
+        grant = std::min({want, free_, allowance});
+        if (grant >= min) break;
+        available_.wait(lock);
+    }
+    state.waiting--;
+    state.held += grant;
+    state.leases++;
+    state.grants++;
+    free_ -= grant;
+
+    double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    state.wait_ms += waited;
+    if (waited >= 1.0) {
+        record_queue_wait_ms(waited);
+    }
+    return CpuLease(this, consumer, grant, want, min);
+}
+
+bool CpuBudget::refresh(CpuLease& lease) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Consumer& state = consumers_[lease.consumer_];
+    size_t share = share_locked(lease.consumer_);
+
+    // Beyond its consumer's share while other consumers wait, or beyond an
+    // even split of that share while leases of its own consumer wait
+    size_t excess = 0;
+    bool others_waiting = others_waiting_locked(lease.consumer_);
+    if (others_waiting && state.held > share) {
+        excess = state.held - share;
+    }
+    if (state.waiting > 0) {
+        size_t split = std::max<size_t>(1, share / (state.leases + state.waiting));
+        if (lease.cores_ > split) excess = std::max(excess, lease.cores_ - split);
+    }
+
+    if (others_waiting || state.waiting > 0) {
+        if (excess == 0 || lease.cores_ <= lease.min_) return false;
+        size_t give = std::min(excess, lease.cores_ - lease.min_);
+        lease.cores_ -= give;
+        state.held -= give;
+        state.yielded += give;
+        free_ += give;
+        available_.notify_all();
+        return true;
+    }
+
+    size_t allowance = share > state.held ? share - state.held : 0;
+    size_t grow = std::min({lease.want_ - lease.cores_, free_, allowance});
+    if (grow == 0) return false;
+    lease.cores_ += grow;
+    state.held += grow;
+    free_ -= grow;
+    return true;
+}
+
+void CpuBudget::give_back(CpuLease& lease) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Consumer& state = consumers_[lease.consumer_];
+    state.held -= lease.cores_;
+    state.leases--;
+    free_ += lease.cores_;
+    available_.notify_all();
+}
+
+json CpuBudget::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json consumers = json::object();
+    for (const auto& [name, state] : consumers_) {
+        consumers[name] = {
+            {"held", state.held},
+            {"leases", state.leases},
+            {"waiting", state.waiting},
+            {"grants", state.grants},
+            {"yielded", state.yielded},
+            {"wait_ms", state.wait_ms}
+        };
+    }
+    return {
+        {"cores", cores_},
+        {"free", free_},
+        {"consumers", consumers}
+    };
+}
+
+} // namespace EMPI
@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * @file CpuBudget.hpp
+ * @brief Process-wide budget of CPU cores leased to llama decoding, analyzer workers and batch work.
+ *
+ * Without it every component sizes itself to the whole machine: each llama
+ * context decodes with hardware_concurrency() threads, chunked analysis runs
+ * one Python worker per core and MinHash batches start a thread per core.
+ * Run together, that oversubscribes the cores several times over. With the
+ * budget each of them leases the cores it computes on, so the total stays
+ * within the machine.
+ */
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+class CpuBudget;
+
+/**
+ * @class CpuLease
+ * @brief Cores held by one computation; returned to the budget on destruction.
+ */
+class CpuLease {
+public:
+    CpuLease() = default;
+    CpuLease(CpuLease&& other) noexcept;
+    CpuLease& operator=(CpuLease&& other) noexcept;
+    CpuLease(const CpuLease&) = delete;
+    CpuLease& operator=(const CpuLease&) = delete;
+    ~CpuLease();
+
+    size_t cores() const { return cores_; }
+    explicit operator bool() const { return budget_ != nullptr; }
+
+    /**
+     * @brief Adapts the lease to the current pressure; call between steps of long work.
+     *
+     * Gives cores back (down to the lease's minimum) while other consumers
+     * wait and this one holds more than its share, or while leases of the
+     * same consumer wait and this lease holds more than an even split of
+     * the share. Grows towards the requested count when cores are free and
+     * nobody waits.
+     *
+     * @return true if cores() changed
+     */
+    bool refresh();
+
+    void release();
+
+private:
+    friend class CpuBudget;
+    CpuLease(CpuBudget* budget, std::string consumer, size_t cores, size_t want, size_t min)
+        : budget_(budget), consumer_(std::move(consumer)), cores_(cores), want_(want), min_(min) {}
+
+    CpuBudget* budget_ = nullptr;
+    std::string consumer_;
+    size_t cores_ = 0;
+    size_t want_ = 0;
+    size_t min_ = 0;
+};
+
+/**
+ * @class CpuBudget
+ * @brief Hands out core leases, sharing the cores by queue pressure.
+ *
+ * Consumers are named by kind ("llama", "analyzer", "orchestration").
+ * The pressure of a consumer is its number of held and waiting leases; each
+ * consumer's share of the cores is proportional to it. A lease gets what it
+ * asks for, capped by the free cores and by its consumer's share, but at
+ * least `min` cores when its consumer holds none. When not even `min` is
+ * available, acquire() waits. Long holders call CpuLease::refresh() to give
+ * cores back as other consumers, or other leases of their own consumer,
+ * queue up and to grow again when they leave.
+ *
+ * Leases are not nested: a thread holding a lease must not wait for another.
+ *
+ * Thread-safe.
+ */
+class CpuBudget {
+public:
+    /**
+     * @param cores Cores to share; 0 = EMPI_CPU_CORES if set, else hardware concurrency
+     */
+    explicit CpuBudget(size_t cores = 0);
+
+    CpuBudget(const CpuBudget&) = delete;
+    CpuBudget& operator=(const CpuBudget&) = delete;
+
+    /**
+     * @brief The budget shared by all agents of the process.
+     */
+    static CpuBudget& global();
+
+    /**
+     * @brief Leases between `min` and `want` cores for `consumer`, waiting while fewer than `min` are available.
+     *
+     * `want` and `min` are capped at cores().
+     */
+    CpuLease acquire(const std::string& consumer, size_t want, size_t min = 1);
+
+    size_t cores() const { return cores_; }
+
+    /**
+     * @brief Free cores, waiting time and per-consumer held cores, leases, waiters and grants.
+     */
+    json stats() const;
+
+private:
+    friend class CpuLease;
+
+    struct Consumer {
+        size_t held = 0;
+        size_t leases = 0;
+        size_t waiting = 0;
+        uint64_t grants = 0;
+        /// Cores given back by refresh() under pressure
+        uint64_t yielded = 0;
+        double wait_ms = 0.0;
+    };
+
+    size_t share_locked(const std::string& consumer) const;
+    bool others_waiting_locked(const std::string& consumer) const;
+    void give_back(CpuLease& lease);
+    bool refresh(CpuLease& lease);
+
+    size_t cores_;
+    size_t free_;
+    std::map<std::string, Consumer> consumers_;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+};
+
+} // namespace EMPI
@@ -0,0 +1,255 @@
+/**
+ * @file CssPresets.cpp
+ * @brief Compile-time stylesheet table for need combinations
+ */
+
+#include "CssPresets.hpp"
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace EMPI {
+
+namespace {
+
+/**
+ * @brief Fixed-capacity string that can be filled in a constant expression.
+ */
+template <size_t N>
+struct FixedCss {
+    char data[N] = {};
+    size_t size = 0;
+
+    constexpr void append(std::string_view text) {
+        for (char c : text) {
+            if (size + 1 >= N) throw std::length_error("CSS preset exceeds its buffer");
+            data[size++] = c;
+        }
+    }
+    constexpr std::string_view view() const { return std::string_view(data, size); }
+};
+
+/**
+ * @brief Sink that only measures, used to size FixedCss exactly.
+ */
+struct CssLength {
+    size_t size = 0;
+    constexpr void append(std::string_view text) { size += text.size(); }
+};
+
+constexpr bool has_need(uint8_t needs, Need need) {
+    return (needs >> static_cast<uint8_t>(need)) & 1u;
+}
+
+constexpr uint8_t need_bit(Need need) {
+    return static_cast<uint8_t>(1u << static_cast<uint8_t>(need));
+}
+
+struct Palette {
+    std::string_view text;
+    std::string_view background;
+    std::string_view accent;
+    std::string_view highlight;
+};
+
+constexpr Palette resolve_palette(uint8_t needs) {
+    Palette p{"#1a1a1a", "#ffffff", "#1a5fb4", "#fff3b0"};
+    if (has_need(needs, Need::Child)) {
+        p.accent = "#0b57d0";
+    }
+    if (has_need(needs, Need::Anxiety)) {
+        p = Palette{"#2f3b36", "#f4f6f4", "#3c5a50", "#e3eee8"};
+    }
+    if (has_need(needs, Need::Dyslexia)) {
+        p.background = "#fdf6e3";
+    }
+    if (has_need(needs, Need::LowVision)) {
+        // Black on cream is still above 18:1, so dyslexia keeps its background
+        p.text = "#000000";
+        p.accent = "#0b3d91";
+        p.highlight = "#ffeb3b";
+        if (!has_need(needs, Need::Dyslexia)) {
+            p.background = "#ffffff";
+        }
+    }
+    return p;
+}
+
+template <typename Sink>
+constexpr void compose_preset(uint8_t needs, Sink& out) {
+    const bool adhd = has_need(needs, Need::ADHD);
+    const bool dyslexia = has_need(needs, Need::Dyslexia);
+    const bool asd = has_need(needs, Need::ASD);
+    const bool low_vision = has_need(needs, Need::LowVision);
+    const bool epilepsy = has_need(needs, Need::Epilepsy);
+    const bool anxiety = has_need(needs, Need::Anxiety);
+    const bool child = has_need(needs, Need::Child);
+    const bool senior = has_need(needs, Need::Senior);
+    const Palette p = resolve_palette(needs);
+
+    std::string_view family = "Arial,Helvetica,sans-serif";
+    if (low_vision || senior) family = "Verdana,Arial,sans-serif";
+    if (dyslexia) family = "'OpenDyslexic',Verdana,Arial,sans-serif";
+
+    std::string_view font_size = "100%";
+    if (child) font_size = "112.5%";
+    if (senior) font_size = "125%";
+    if (low_vision) font_size = "150%";
+
+    std::string_view line_height = "1.5";
+    if (adhd || low_vision || senior) line_height = "1.6";
+    if (dyslexia) line_height = "1.8";
+
+    out.append(":root{--empi-text:"); out.append(p.text);
+    out.append(";--empi-bg:"); out.append(p.background);
+    out.append(";--empi-accent:"); out.append(p.accent);
+    out.append("}\n");
+
+    out.append("body{margin:0;padding:1rem;font-family:"); out.append(family);
+    out.append(";font-size:"); out.append(font_size);
+    out.append(";line-height:"); out.append(line_height);
+    out.append(";color:"); out.append(p.text);
+    out.append(";background:"); out.append(p.background);
+    out.append("}\n");
+    if (dyslexia) {
+        out.append("body{letter-spacing:0.05em;word-spacing:0.12em}\n");
+    }
+
+    out.append(adhd || dyslexia ? "main{max-width:60ch;margin:0 auto}\n"
+                                : "main{max-width:70ch;margin:0 auto}\n");
+    out.append("h1,h2,h3{line-height:1.3;color:"); out.append(p.accent); out.append("}\n");
+    out.append("a{text-decoration:underline;color:"); out.append(p.accent); out.append("}\n");
+    out.append("a:focus,button:focus,input:focus,select:focus,textarea:focus{outline:3px solid ");
+    out.append(low_vision ? p.text : p.accent);
+    out.append(";outline-offset:2px}\n");
+    out.append("img{max-width:100%;height:auto}\n");
+
+    if (dyslexia || asd) {
+        out.append("p{text-align:left}em,i{font-style:normal;font-weight:bold}\n");
+    }
+    if (adhd) {
+        out.append("p{margin:0 0 1.2em}strong,mark{color:inherit;padding:0 0.15em;background:");
+        out.append(p.highlight);
+        out.append("}\n");
+    }
+    if (asd) {
+        out.append("h2,h3{border-bottom:2px solid #8a8a8a;padding-bottom:0.25em}section{margin:1.5em 0}\n");
+    }
+    if (child) {
+        out.append("h1{font-size:2em}section{border-radius:12px;padding:1em;border:2px solid ");
+        out.append(p.accent);
+        out.append("}li::marker{color:");
+        out.append(p.accent);
+        out.append("}\n");
+    }
+    if (low_vision || senior) {
+        out.append("a,button,input,select{min-height:44px}button,input,select{padding:0.5em 0.75em}\n");
+    }
+    if (epilepsy || anxiety) {
+        out.append("*,*::before,*::after{animation:none !important;transition:none !important;"
+                   "scroll-behavior:auto !important}\n");
+    }
+}
+
+constexpr size_t longest_preset() {
+    size_t longest = 0;
+    for (size_t needs = 0; needs < kCssPresetCount; ++needs) {
+        CssLength length;
+        compose_preset(static_cast<uint8_t>(needs), length);
+        if (length.size > longest) longest = length.size;
+    }
+    return longest;
+}
+
+using Preset = FixedCss<longest_preset() + 1>;
+
+constexpr Preset build_preset(uint8_t needs) {
+    Preset preset;
+    compose_preset(needs, preset);
+    return preset;
+}
+
+// One constant per combination keeps each evaluation well under compiler step limits
+template <size_t Needs>
+constexpr Preset kPreset = build_preset(static_cast<uint8_t>(Needs));
+
+template <size_t... I>
+constexpr std::array<std::string_view, sizeof...(I)> preset_views(std::index_sequence<I...>) {
+    return {{kPreset<I>.view()...}};
+}
+
+constexpr auto kPresets = preset_views(std::make_index_sequence<kCssPresetCount>{});
+
+constexpr bool preset_contains(uint8_t needs, std::string_view text) {
+    return kPresets[needs].find(text) != std::string_view::npos;
+}
+
+static_assert(!preset_contains(0, "OpenDyslexic"), "default preset uses the plain font");
+static_assert(preset_contains(need_bit(Need::Dyslexia) | need_bit(Need::LowVision),
+                              "color:#000000;background:#fdf6e3"),
+              "low vision keeps cream but forces black text");
+static_assert(preset_contains(need_bit(Need::Anxiety) | need_bit(Need::LowVision),
+                              "color:#000000;background:#ffffff"),
+              "contrast wins over the calm tint");
+static_assert(preset_contains(need_bit(Need::Senior) | need_bit(Need::LowVision), "font-size:150%"),
+              "largest font size wins");
+static_assert(preset_contains(need_bit(Need::Epilepsy), "animation:none"),
+              "epilepsy disables motion");
+
+const char* const kFontPercent[] = {"100%", "125%", "150%", "175%"};
+
+} // namespace
+
+std::string_view need_preset_css(uint8_t needs) {
+    return kPresets[needs];
+}
+
+std::string preference_css(const ProfileFlags& base,
+                           const ProfileFlags& current,
+                           std::vector<std::string>* applied) {
+    std::ostringstream css;
+    auto mark = [applied](const char* name) {
+        if (applied) applied->emplace_back(name);
+    };
+    bool high_contrast = current.contrast == Contrast::High;
+
+    if (current.font_scale != base.font_scale) {
+        css << "html{font-size:" << kFontPercent[current.font_scale & 0x3u] << " !important}"
+               "body,p,li,td,th,label,input,button{font-size:1rem !important}\n";
+        mark("font_scale");
+    }
+    if (current.contrast != base.contrast) {
+        if (current.contrast == Contrast::High) {
+            css << "body,main,article,section,div,p,li{color:#000 !important;background-color:#fff !important}"
+                   "a{color:#0000ee !important}\n";
+            mark("contrast");
+        } else if (current.contrast == Contrast::Low) {
+            css << "body{color:#333 !important;background-color:#f5f1e8 !important}\n";
+            mark("contrast");
+        }
+        // Back to normal has no rule: CSS cannot restore the colors of a page generated for high contrast
+    }
+    if (current.reduce_motion && !base.reduce_motion) {
+        css << "*,*::before,*::after{animation:none !important;transition:none !important;"
+               "scroll-behavior:auto !important}\n";
+        mark("reduce_motion");
+    }
+    if (current.calm_colors && !base.calm_colors && !high_contrast) {
+        css << "body{background-color:#f4f6f4 !important;color:#2f3b36 !important}"
+               "h1,h2,h3{color:#3c5a50 !important}\n";
+        mark("calm_colors");
+    }
+    if (current.density > base.density) {
+        css << "p{margin:0 0 1em 0}\n";
+    }
+    return css.str();
+}
+
+std::string profile_stylesheet(const ProfileFlags& profile) {
+    std::string css(need_preset_css(profile.needs));
+    css += preference_css(implied_profile(profile.needs), profile);
+    return css;
+}
+
+} // namespace EMPI
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ProfileFlags.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace EMPI {
+
+/// One preset per value of ProfileFlags::needs.
+constexpr size_t kCssPresetCount = size_t{1} << kNeedCount;
+
+/**
+ * @brief Ready stylesheet for a need combination.
+ *
+ * All 256 presets are composed at compile time from per-need fragments, with
+ * conflicts between needs resolved once in the table rather than by the LLM:
+ *   - low vision keeps a dyslexia cream background but forces pure black text;
+ *     without dyslexia it switches calm tints back to white
+ *   - the dyslexia cream background takes precedence over the calm tint
+ *   - anxiety's calm accent replaces the brighter child palette
+ *   - the largest font size and line height requested by any need win
+ *
+ * @param needs ProfileFlags::needs bitset
+ */
+std::string_view need_preset_css(uint8_t needs);
+
+/**
+ * @brief CSS for the preference differences between two profiles.
+ *
+ * Covers font scale, contrast, reduced motion, calm colors and paragraph
+ * spacing. Rules use !important so they override page and preset styles.
+ *
+ * @param base Profile the page is already styled for
+ * @param current Target profile
+ * @param applied Optional list receiving the names of emitted rules
+ */
+std::string preference_css(const ProfileFlags& base,
+                           const ProfileFlags& current,
+                           std::vector<std::string>* applied = nullptr);
+
+/**
+ * @brief Complete stylesheet for a profile.
+ *
+ * The need preset plus overrides for explicit preferences beyond what the
+ * needs imply (see implied_profile()).
+ */
+std::string profile_stylesheet(const ProfileFlags& profile);
+
+} // namespace EMPI
@@ -0,0 +1,409 @@
+/**
+ * @file ForkServer.cpp
+ * @brief Zygote process management and the elastic worker pool
+ */
+
+#include "ForkServer.hpp"
+#include "CpuBudget.hpp"
+#include "RequestCost.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace EMPI {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Reads the next '\n'-terminated line into `line` (without it).
+ *
+ * Bytes received past the newline are kept in `pending` for the next call.
+ *
+ * @return false on EOF, error or when `deadline` passes
+ */
+bool read_line(int fd, std::string& line, std::string& pending,
+               Clock::time_point deadline = Clock::time_point::max()) {
+    char buffer[4096];
+    while (true) {
+        size_t newline = pending.find('\n');
+        if (newline != std::string::npos) {
+            line.assign(pending, 0, newline);
+            pending.erase(0, newline + 1);
+            return true;
+        }
+        if (deadline != Clock::time_point::max()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            pollfd pfd{fd, POLLIN, 0};
+            if (left <= 0 || poll(&pfd, 1, static_cast<int>(std::min<long long>(left, 1000 * 1000))) <= 0) {
+                return false;
+            }
+        }
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string make_socket_path() {
+    static std::atomic<unsigned> counter{0};
+    return (fs::temp_directory_path() /
+            ("empi_fork_" + std::to_string(getpid()) + "_" + std::to_string(counter++) + ".sock")).string();
+}
+
+} // namespace
+
+ForkServer::ForkServer(std::vector<std::string> argv, ForkServerConfig config)
+    : argv_(std::move(argv))
+    , config_(config)
+{
+    if (argv_.empty()) {
+        throw std::invalid_argument("Fork-server command is empty");
+    }
+    if (config_.max_workers == 0) {
+        config_.max_workers = CpuBudget::global().cores();
+    }
+
+    std::vector<ForkServerLane> lanes = config_.lanes;
+    if (lanes.empty()) {
+        lanes.push_back({SIZE_MAX, 0});
+    }
+    std::sort(lanes.begin(), lanes.end(),
+              [](const ForkServerLane& a, const ForkServerLane& b) { return a.max_cost < b.max_cost; });
+    size_t reserved = 0;
+    for (const auto& lane : lanes) {
+        lanes_.push_back({lane});
+        reserved += lane.reserved;
+    }
+    // The last lane takes every cost
+    lanes_.back().config.max_cost = SIZE_MAX;
+    config_.max_workers = std::max(config_.max_workers, reserved);
+    shared_slots_ = config_.max_workers - reserved;
+    config_.min_workers = std::min(config_.min_workers, config_.max_workers);
+}
+
+ForkServer::~ForkServer() {
+    stop();
+}
+
+void ForkServer::start() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (zygote_pid_ > 0) return;
+
+    socket_path_ = make_socket_path();
+    std::vector<std::string> args = argv_;
+    args.push_back(socket_path_);
+    // Built before fork(): the child may only call async-signal-safe functions
+    std::vector<char*> exec_argv;
+    for (auto& arg : args) exec_argv.push_back(arg.data());
+    exec_argv.push_back(nullptr);
+
+    int stdin_pipe[2];
+    int stdout_pipe[2];
+    if (pipe2(stdin_pipe, O_CLOEXEC) != 0) {
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+    if (pipe2(stdout_pipe, O_CLOEXEC) != 0) {
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        throw std::runtime_error(std::string("pipe failed: ") + std::strerror(errno));
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(stdin_pipe[0], STDIN_FILENO);
+        dup2(stdout_pipe[1], STDOUT_FILENO);
+        execvp(exec_argv[0], exec_argv.data());
+        _exit(127);
+    }
+    close(stdin_pipe[0]);
+    close(stdout_pipe[1]);
+    if (pid < 0) {
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        throw std::runtime_error(std::string("fork failed: ") + std::strerror(errno));
+    }
+
+    // The zygote may log before it is ready; wait for the "ready" line itself
+    auto deadline = Clock::now() + config_.start_timeout;
+    std::string line;
+    std::string pending;
+    bool ready = false;
+    while (!ready && read_line(stdout_pipe[0], line, pending, deadline)) {
+        ready = line == "ready";
+    }
+    close(stdout_pipe[0]);
+    if (!ready) {
+        close(stdin_pipe[1]);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        throw std::runtime_error("Fork-server zygote did not start: " + argv_.front());
+    }
+    zygote_pid_ = pid;
+    zygote_stdin_ = stdin_pipe[1];
+
+    while (idle_.size() < config_.min_workers) {
+        lock.unlock();
+        int fd = connect_worker();
+        lock.lock();
+        if (fd < 0) {
+            lock.unlock();
+            stop();
+            throw std::runtime_error("Fork-server zygote does not fork workers");
+        }
+        forked_++;
+        idle_.push_back({fd, Clock::now()});
+    }
+    peak_workers_ = std::max(peak_workers_, idle_.size());
+}
+
+void ForkServer::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (zygote_pid_ <= 0) return;
+
+    for (auto& worker : idle_) {
+        close(worker.fd);
+    }
+    idle_.clear();
+    // Leased workers are closed when their callers release them
+
+    close(zygote_stdin_);
+    zygote_stdin_ = -1;
+    kill(zygote_pid_, SIGTERM);
+    waitpid(zygote_pid_, nullptr, 0);
+    zygote_pid_ = -1;
+    std::error_code ec;
+    fs::remove(socket_path_, ec);
+    available_.notify_all();
+}
+
+bool ForkServer::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return zygote_pid_ > 0;
+}
+
+int ForkServer::connect_worker() {
+    auto started = Clock::now();
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+    std::string greeting;
+    std::string pending;
+    // A worker writes nothing between its greeting and the first response
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        !read_line(fd, greeting, pending, Clock::now() + config_.start_timeout) || greeting != "ready") {
+        close(fd);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_fork_ms_ = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    return fd;
+}
+
+int ForkServer::choose_slot_locked(size_t lane) const {
+    const Lane& own = lanes_[lane];
+    if (own.charged < own.config.reserved) {
+        return static_cast<int>(lane);
+    }
+    if (shared_charged_ < shared_slots_) {
+        return kShared;
+    }
+    for (size_t other = 0; other < lanes_.size(); ++other) {
+        const Lane& victim = lanes_[other];
+        if (other == lane || victim.waiting > 0 || victim.charged >= victim.config.reserved) continue;
+        size_t spare = victim.config.reserved - victim.charged;
+        if (other > lane || spare > 1) {
+            return static_cast<int>(other);
+        }
+    }
+    return kNoSlot;
+}
+
+ForkServer::Worker ForkServer::acquire_worker(std::unique_lock<std::mutex>& lock, size_t lane) {
+    auto now = Clock::now();
+    trim_locked(now);
+    bool waited = false;
+
+    while (true) {
+        if (zygote_pid_ <= 0) {
+            throw std::runtime_error("Fork-server is not running");
+        }
+        int slot = choose_slot_locked(lane);
+        if (slot != kNoSlot) {
+            if (slot == kShared) {
+                shared_charged_++;
+            } else {
+                lanes_[slot].charged++;
+                if (static_cast<size_t>(slot) != lane) lanes_[lane].stolen++;
+            }
+            lanes_[lane].running++;
+            busy_++;
+            if (waited) {
+                record_queue_wait_ms(std::chrono::duration<double, std::milli>(Clock::now() - now).count());
+            }
+
+            if (!idle_.empty()) {
+                // Most recently used first, so surplus workers age out
+                Worker worker = idle_.back();
+                idle_.pop_back();
+                worker.lane = lane;
+                worker.slot = slot;
+                return worker;
+            }
+
+            lock.unlock();
+            int fd = connect_worker();
+            lock.lock();
+            if (fd < 0) {
+                release_slot_locked(lane, slot);
+                failures_++;
+                throw std::runtime_error("Fork-server could not fork a worker");
+            }
+            forked_++;
+            peak_workers_ = std::max(peak_workers_, busy_ + idle_.size());
+            return {fd, Clock::now(), lane, slot};
+        }
+        waiting_++;
+        lanes_[lane].waiting++;
+        available_.wait(lock);
+        lanes_[lane].waiting--;
+        waiting_--;
+        waited = true;
+    }
+}
+
+void ForkServer::release_slot_locked(size_t lane, int slot) {
+    if (slot == kShared) {
+        shared_charged_--;
+    } else {
+        lanes_[slot].charged--;
+    }
+    lanes_[lane].running--;
+    busy_--;
+    // Waiters of different lanes may take different slots
+    available_.notify_all();
+}
+
+void ForkServer::release_worker(Worker worker, bool healthy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    release_slot_locked(worker.lane, worker.slot);
+    if (healthy && zygote_pid_ > 0) {
+        worker.last_used = Clock::now();
+        idle_.push_back(worker);
+    } else {
+        close(worker.fd);
+        if (!healthy) failures_++;
+    }
+}
+
+json ForkServer::call(const json& request, size_t cost) {
+    std::string line = request.dump() + "\n";
+    size_t lane = 0;
+    while (cost > lanes_[lane].config.max_cost) lane++;
+    // A worker that died (e.g. killed for memory) is dropped and the request retried on a fresh one
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        Worker worker;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (attempt == 0) {
+                requests_++;
+                lanes_[lane].requests++;
+            }
+            worker = acquire_worker(lock, lane);
+        }
+        CpuLease cpu;
+        if (!config_.cpu_consumer.empty()) {
+            cpu = CpuBudget::global().acquire(config_.cpu_consumer, 1);
+        }
+        std::string response;
+        std::string pending;
+        // One request in flight per worker, so the response line is all it sent
+        if (send_all(worker.fd, line) && read_line(worker.fd, response, pending)) {
+            release_worker(worker, true);
+            return json::parse(response);
+        }
+        release_worker(worker, false);
+    }
+    throw std::runtime_error("Fork-server worker failed twice");
+}
+
+size_t ForkServer::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return trim_locked(Clock::now());
+}
+
+size_t ForkServer::trim_locked(Clock::time_point now) {
+    size_t closed = 0;
+    // idle_ is ordered by release time, oldest first
+    auto it = idle_.begin();
+    while (it != idle_.end() && idle_.size() + busy_ > config_.min_workers &&
+           now - it->last_used >= config_.idle_timeout) {
+        close(it->fd);
+        it = idle_.erase(it);
+        closed++;
+    }
+    retired_ += closed;
+    return closed;
+}
+
+json ForkServer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json lanes = json::array();
+    for (const auto& lane : lanes_) {
+        lanes.push_back({
+            {"max_cost", lane.config.max_cost},
+            {"reserved", lane.config.reserved},
+            {"running", lane.running},
+            {"waiting", lane.waiting},
+            {"requests", lane.requests},
+            {"stolen", lane.stolen}
+        });
+    }
+    return {
+        {"running", zygote_pid_ > 0},
+        {"workers", idle_.size() + busy_},
+        {"idle", idle_.size()},
+        {"busy", busy_},
+        {"waiting", waiting_},
+        {"max_workers", config_.max_workers},
+        {"peak_workers", peak_workers_},
+        {"forked", forked_},
+        {"retired", retired_},
+        {"failures", failures_},
+        {"requests", requests_},
+        {"last_fork_ms", last_fork_ms_},
+        {"shared_slots", shared_slots_},
+        {"lanes", lanes}
+    };
+}
+
+} // namespace EMPI
@@ -0,0 +1,183 @@
+#pragma once
+
+/**
+ * @file ForkServer.hpp
+ * @brief Elastic pool of workers forked from a preloaded zygote process.
+ *
+ * Starting a Python analyzer means importing textstat and spaCy and loading
+ * the model, which takes seconds. A fork-server pays that once: the zygote
+ * (e.g. integrations/analyzer_server.py) loads everything, listens on a Unix
+ * socket and forks a worker for every connection. Workers start in
+ * milliseconds and share the model pages copy-on-write.
+ *
+ * Protocol: the zygote is started as `argv... SOCKET_PATH`, prints a line
+ * "ready" on stdout once it accepts connections and exits when its stdin is
+ * closed. A worker greets its connection with a line "ready", then reads
+ * one JSON request per line and writes one JSON response per line.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct ForkServerLane
+ * @brief A size class of requests with worker slots reserved for it.
+ */
+struct ForkServerLane {
+    /// Largest request cost (e.g. input characters) routed to this lane
+    size_t max_cost = SIZE_MAX;
+    /// Worker slots kept for this lane's requests
+    size_t reserved = 1;
+};
+
+/**
+ * @struct ForkServerConfig
+ * @brief Worker limits and timeouts of a ForkServer.
+ */
+struct ForkServerConfig {
+    /// Idle workers kept when load drops
+    size_t min_workers = 1;
+    /// Most workers alive at once (0 = the cores of CpuBudget::global())
+    size_t max_workers = 0;
+    /// Idle workers beyond min_workers are closed after this long
+    std::chrono::seconds idle_timeout{30};
+    /// Time the zygote may take to load before start() fails
+    std::chrono::seconds start_timeout{120};
+    /// Size classes by ascending max_cost; empty puts every request in one unreserved lane.
+    /// max_workers is raised to the sum of the reservations if it is smaller.
+    std::vector<ForkServerLane> lanes;
+    /// CpuBudget::global() consumer leasing one core per request once it holds a worker
+    /// slot, so waiting for a core never bypasses the lanes; empty leases none
+    std::string cpu_consumer;
+};
+
+/**
+ * @class ForkServer
+ * @brief Zygote process plus the workers forked from it.
+ *
+ * call() uses an idle worker, forks a new one while the pool is below
+ * max_workers, and otherwise waits for one to be released, so the worker
+ * set grows with the number of concurrent callers. Workers idle for longer
+ * than idle_timeout are closed on later calls or by trim(), down to
+ * min_workers. A worker that dies is replaced and the request retried once.
+ *
+ * Requests are routed into lanes by cost, so that a long analysis cannot
+ * hold every worker while short ones queue behind it. A request runs in a
+ * slot reserved for its lane, else in an unreserved slot, else it steals a
+ * free reserved slot of a lane with no waiting requests. It may take the
+ * last free slot of a lane only if that lane is for costlier requests: short
+ * requests borrow briefly, while a long request never takes the only slot
+ * left for short ones.
+ *
+ * Thread-safe.
+ */
+class ForkServer {
+public:
+    /**
+     * @param argv Zygote command line; the socket path is appended
+     */
+    ForkServer(std::vector<std::string> argv, ForkServerConfig config = {});
+    ~ForkServer();
+
+    ForkServer(const ForkServer&) = delete;
+    ForkServer& operator=(const ForkServer&) = delete;
+
+    /**
+     * @brief Starts the zygote and waits until it accepts connections, then forks min_workers.
+     *
+     * @throws std::runtime_error If the zygote cannot be started, exits or times out
+     */
+    void start();
+
+    /**
+     * @brief Closes every worker and stops the zygote. Called by the destructor.
+     */
+    void stop();
+
+    bool running() const;
+
+    /**
+     * @brief Sends one request to a worker and returns its response.
+     *
+     * @param cost Size of the request, selecting its lane (first with cost <= max_cost)
+     *
+     * @throws std::runtime_error If the server is not running or no worker can serve the request
+     */
+    json call(const json& request, size_t cost = 0);
+
+    /**
+     * @brief Closes idle workers beyond min_workers that exceeded idle_timeout.
+     *
+     * @return Number of workers closed
+     */
+    size_t trim();
+
+    /**
+     * @brief Worker counts, forks, retirements, failures, waiting callers, the last fork latency and per-lane load.
+     */
+    json stats() const;
+
+private:
+    /// Slot budget of a worker: a lane index, or one of these
+    static constexpr int kShared = -1;
+    static constexpr int kNoSlot = -2;
+
+    struct Worker {
+        int fd = -1;
+        std::chrono::steady_clock::time_point last_used;
+        size_t lane = 0;
+        int slot = kShared;
+    };
+
+    struct Lane {
+        ForkServerLane config;
+        /// Slots of this lane's reservation in use, by any lane
+        size_t charged = 0;
+        size_t running = 0;
+        size_t waiting = 0;
+        uint64_t requests = 0;
+        /// Requests that ran in another lane's reserved slot
+        uint64_t stolen = 0;
+    };
+
+    int connect_worker();
+    int choose_slot_locked(size_t lane) const;
+    Worker acquire_worker(std::unique_lock<std::mutex>& lock, size_t lane);
+    void release_slot_locked(size_t lane, int slot);
+    void release_worker(Worker worker, bool healthy);
+    size_t trim_locked(std::chrono::steady_clock::time_point now);
+
+    std::vector<std::string> argv_;
+    ForkServerConfig config_;
+    std::string socket_path_;
+    pid_t zygote_pid_ = -1;
+    /// Write end of the zygote's stdin; closing it stops the zygote
+    int zygote_stdin_ = -1;
+
+    std::vector<Worker> idle_;
+    size_t busy_ = 0;
+    size_t waiting_ = 0;
+    std::vector<Lane> lanes_;
+    size_t shared_slots_ = 0;
+    size_t shared_charged_ = 0;
+    uint64_t forked_ = 0;
+    uint64_t retired_ = 0;
+    uint64_t failures_ = 0;
+    uint64_t requests_ = 0;
+    size_t peak_workers_ = 0;
+    double last_fork_ms_ = 0.0;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+};
+
+} // namespace EMPI
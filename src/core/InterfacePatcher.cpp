@@ -0,0 +1,214 @@
+/**
+ * @file InterfacePatcher.cpp
+ * @brief Deterministic page edits for incremental profile changes
+ */
+
+#include "InterfacePatcher.hpp"
+#include "CssPresets.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace EMPI {
+
+namespace {
+
+const char* const kPatchBlockOpen = "<style id=\"empi-patch\"";
+const char* const kPresetBlockOpen = "<style id=\"empi-preset\"";
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+/**
+ * @brief Finds an opening tag `<name ...>` in a lowercased page; returns the position after '>'.
+ */
+std::optional<size_t> find_open_tag_end(const std::string& lower, const std::string& name, size_t from = 0) {
+    std::string needle = "<" + name;
+    size_t pos = lower.find(needle, from);
+    while (pos != std::string::npos) {
+        char next = pos + needle.size() < lower.size() ? lower[pos + needle.size()] : '\0';
+        if (next == '>' || std::isspace(static_cast<unsigned char>(next))) {
+            size_t close = lower.find('>', pos);
+            if (close == std::string::npos) return std::nullopt;
+            return close + 1;
+        }
+        pos = lower.find(needle, pos + 1);
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief Removes an existing patch block and returns the base profile key it recorded.
+ */
+std::optional<uint32_t> strip_patch_block(std::string& html) {
+    size_t begin = html.find(kPatchBlockOpen);
+    if (begin == std::string::npos) return std::nullopt;
+    size_t end = html.find("</style>", begin);
+    if (end == std::string::npos) return std::nullopt;
+
+    std::optional<uint32_t> base_key;
+    const std::string attr = "data-base-key=\"";
+    size_t attr_pos = html.find(attr, begin);
+    if (attr_pos != std::string::npos && attr_pos < end) {
+        try {
+            base_key = static_cast<uint32_t>(std::stoul(html.substr(attr_pos + attr.size())));
+        } catch (...) {
+        }
+    }
+
+    end += std::string("</style>").size();
+    if (end < html.size() && html[end] == '\n') end++;
+    html.erase(begin, end - begin);
+    return base_key;
+}
+
+/**
+ * @brief Splits plain-text paragraphs into chunks of at most max_sentences sentences.
+ */
+std::string split_paragraphs(const std::string& html, size_t max_sentences, bool& changed) {
+    std::string lower = lowercase(html);
+    std::string out;
+    out.reserve(html.size() + html.size() / 8);
+
+    size_t cursor = 0;
+    while (true) {
+        auto open_end = find_open_tag_end(lower, "p", cursor);
+        if (!open_end) break;
+        size_t open_begin = lower.rfind("<p", *open_end);
+        size_t close = lower.find("</p>", *open_end);
+        if (close == std::string::npos) break;
+
+        std::string inner = html.substr(*open_end, close - *open_end);
+        out.append(html, cursor, close - cursor);
+        cursor = close;
+
+        // Only plain text can be split safely; inline markup is left alone.
+        if (inner.find('<') != std::string::npos) continue;
+
+        std::vector<std::string> sentences;
+        size_t start = 0;
+        for (size_t i = 0; i < inner.size(); ++i) {
+            char c = inner[i];
+            if ((c == '.' || c == '!' || c == '?') && i + 2 < inner.size() &&
+                std::isspace(static_cast<unsigned char>(inner[i + 1])) &&
+                std::isupper(static_cast<unsigned char>(inner[i + 2]))) {
+                sentences.push_back(inner.substr(start, i + 1 - start));
+                start = i + 2;
+            }
+        }
+        sentences.push_back(inner.substr(start));
+        if (sentences.size() <= max_sentences) continue;
+
+        std::string open_tag = html.substr(open_begin, *open_end - open_begin);
+        std::string rebuilt;
+        for (size_t i = 0; i < sentences.size(); i += max_sentences) {
+            if (!rebuilt.empty()) rebuilt += "</p>\n" + open_tag;
+            for (size_t k = i; k < std::min(i + max_sentences, sentences.size()); ++k) {
+                if (k > i) rebuilt += ' ';
+                rebuilt += sentences[k];
+            }
+        }
+        out.resize(out.size() - inner.size());
+        out += rebuilt;
+        changed = true;
+    }
+    out.append(html, cursor, std::string::npos);
+    return out;
+}
+
+void insert_head_block(std::string& html, const std::string& block) {
+    std::string lower = lowercase(html);
+    size_t head_close = lower.find("</head>");
+    if (head_close != std::string::npos) {
+        html.insert(head_close, block);
+        return;
+    }
+    if (auto html_open = find_open_tag_end(lower, "html")) {
+        html.insert(*html_open, "\n" + block);
+        return;
+    }
+    html.insert(0, block);
+}
+
+} // namespace
+
+InterfacePatch patch_interface(const std::string& html,
+                               const ProfileFlags& previous,
+                               const ProfileFlags& current) {
+    InterfacePatch patch;
+    patch.html = html;
+
+    // A page patched before keeps the profile it was generated for
+    ProfileFlags base = previous;
+    if (auto base_key = strip_patch_block(patch.html)) {
+        base = ProfileFlags::from_key(*base_key);
+    }
+
+    std::string css;
+    if (current.needs != base.needs) {
+        // A new need combination gets its whole resolved preset instead of piecemeal rules
+        apply_profile_stylesheet(patch.html, current);
+        patch.applied.emplace_back("need_preset");
+    } else {
+        css = preference_css(base, current, &patch.applied);
+    }
+
+    if (current.density > previous.density) {
+        bool changed = false;
+        size_t max_sentences = current.density >= 2 ? 1 : 2;
+        patch.html = split_paragraphs(patch.html, max_sentences, changed);
+        if (changed) patch.applied.emplace_back("split_paragraphs");
+    }
+
+    if (!css.empty()) {
+        insert_head_block(patch.html, std::string(kPatchBlockOpen) + " data-base-key=\"" +
+                                          std::to_string(base.key()) + "\">\n" + css + "</style>\n");
+    }
+
+    if (current.plain_language && !previous.plain_language) {
+        patch.rewrite_instructions.emplace_back(
+            "Use plain, literal language: short sentences, common words, no idioms or metaphors.");
+    }
+    if (current.has(Need::ADHD) && !previous.has(Need::ADHD)) {
+        patch.rewrite_instructions.emplace_back(
+            "Add clear headings and highlight key points in bold.");
+    }
+    if (current.has(Need::Child) && !previous.has(Need::Child)) {
+        patch.rewrite_instructions.emplace_back(
+            "Use simpler words suitable for a child and a friendly, engaging tone.");
+    }
+    return patch;
+}
+
+void apply_profile_stylesheet(std::string& html, const ProfileFlags& profile) {
+    std::string block = std::string(kPresetBlockOpen) + " data-key=\"" + std::to_string(profile.key()) +
+                        "\">\n" + profile_stylesheet(profile) + "</style>\n";
+
+    size_t begin = html.find(kPresetBlockOpen);
+    if (begin != std::string::npos) {
+        size_t end = html.find("</style>", begin);
+        if (end != std::string::npos) {
+            end += std::string("</style>").size();
+            if (end < html.size() && html[end] == '\n') end++;
+            html.replace(begin, end - begin, block);
+            return;
+        }
+    }
+    insert_head_block(html, block);
+}
+
+std::optional<FragmentRange> find_content_fragment(const std::string& html) {
+    std::string lower = lowercase(html);
+    for (const char* tag : {"main", "article", "body"}) {
+        auto open_end = find_open_tag_end(lower, tag);
+        if (!open_end) continue;
+        size_t close = lower.rfind(std::string("</") + tag + ">");
+        if (close == std::string::npos || close < *open_end) continue;
+        return FragmentRange{*open_end, close};
+    }
+    return std::nullopt;
+}
+
+} // namespace EMPI
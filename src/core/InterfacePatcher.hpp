@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ProfileFlags.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace EMPI {
+
+/**
+ * @struct InterfacePatch
+ * @brief Result of patching a generated page for a changed profile.
+ */
+struct InterfacePatch {
+    std::string html;
+    /// Deterministic edits that were applied (e.g. "font_scale", "split_paragraphs").
+    std::vector<std::string> applied;
+    /// Content changes that CSS cannot express; the caller rewrites the content fragment.
+    std::vector<std::string> rewrite_instructions;
+};
+
+/**
+ * @struct FragmentRange
+ * @brief Byte range [begin, end) of a page's inner content.
+ */
+struct FragmentRange {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+/**
+ * @brief Applies the deterministic part of a profile change to a generated page.
+ *
+ * A changed need set replaces the page's preset stylesheet (see
+ * apply_profile_stylesheet()). Otherwise style preferences (font scale,
+ * contrast, motion, calm colors) map to CSS rules emitted into a single
+ * `<style id="empi-patch">` block. The block records the profile the page was
+ * generated for, so repeated patches are computed against that base and
+ * replace each other instead of piling up. Increased density splits long
+ * plain-text paragraphs at sentence boundaries.
+ *
+ * @param html Previously generated page
+ * @param previous Profile the page was generated (or last patched) for
+ * @param current Updated profile
+ */
+InterfacePatch patch_interface(const std::string& html,
+                               const ProfileFlags& previous,
+                               const ProfileFlags& current);
+
+/**
+ * @brief Sets the page's `<style id="empi-preset">` block to profile_stylesheet(profile).
+ *
+ * Replaces an existing preset block in place, otherwise inserts it before
+ * `</head>`.
+ */
+void apply_profile_stylesheet(std::string& html, const ProfileFlags& profile);
+
+/**
+ * @brief Locates the content fragment to send to the LLM for rewrites.
+ *
+ * Prefers the inner HTML of `<main>`, then `<article>`, then `<body>`.
+ */
+std::optional<FragmentRange> find_content_fragment(const std::string& html);
+
+} // namespace EMPI
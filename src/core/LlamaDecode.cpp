@@ -0,0 +1,426 @@
+/**
+ * @file LlamaDecode.cpp
+ * @brief Shared llama.cpp decode loops: prompt-lookup speculation and parallel branches
+ */
+
+#include "LlamaDecode.hpp"
+#include "CpuBudget.hpp"
+#include "Probes.hpp"
+#include "RequestCost.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "llama.h"
+
+namespace EMPI {
+
+namespace {
+
+std::vector<llama_token> tokenize(const llama_vocab* vocab, const std::string& text, bool add_bos = true) {
+    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, add_bos, true);
+    std::vector<llama_token> tokens(n_tokens < 0 ? -n_tokens : n_tokens);
+    llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), tokens.size(), add_bos, true);
+    return tokens;
+}
+
+/**
+ * @brief Owning llama_batch with explicit positions and sequence ids.
+ */
+class Batch {
+public:
+    explicit Batch(int32_t capacity) : batch_(llama_batch_init(capacity, 0, 1)) {}
+    ~Batch() { llama_batch_free(batch_); }
+    Batch(const Batch&) = delete;
+    Batch& operator=(const Batch&) = delete;
+
+    void clear() { batch_.n_tokens = 0; }
+
+    void add(llama_token token, llama_pos pos, bool logits, llama_seq_id seq = 0) {
+        int32_t i = batch_.n_tokens++;
+        batch_.token[i] = token;
+        batch_.pos[i] = pos;
+        batch_.n_seq_id[i] = 1;
+        batch_.seq_id[i][0] = seq;
+        batch_.logits[i] = logits;
+    }
+
+    int32_t size() const { return batch_.n_tokens; }
+
+    const llama_batch& get() const { return batch_; }
+
+private:
+    llama_batch batch_;
+};
+
+/**
+ * @brief Tokens per llama_decode call: the requested budget, capped by the context's n_batch.
+ */
+int32_t step_budget(llama_context* ctx, const GenerationOptions& options) {
+    return std::clamp(options.step_tokens, 1, static_cast<int32_t>(llama_n_batch(ctx)));
+}
+
+/**
+ * @brief Decode threads of one generation, leased from the process CPU budget.
+ *
+ * refresh() runs before every llama_decode call, so a long generation gives
+ * cores back while analyzer workers or other generations queue for them and
+ * takes them again once they are done.
+ */
+class DecodeThreads {
+public:
+    explicit DecodeThreads(llama_context* ctx)
+        : ctx_(ctx)
+        , lease_(CpuBudget::global().acquire("llama", CpuBudget::global().cores()))
+    {
+        apply();
+    }
+
+    void refresh() {
+        if (lease_.refresh()) apply();
+    }
+
+private:
+    void apply() {
+        auto n = static_cast<int32_t>(lease_.cores());
+        llama_set_n_threads(ctx_, n, n);
+    }
+
+    llama_context* ctx_;
+    CpuLease lease_;
+};
+
+/**
+ * @brief Decodes prompt tokens on sequence 0 in chunks of at most `step_tokens`.
+ *
+ * With `logits_last` the final token's logits are requested; they sit at
+ * index batch.size() - 1 afterwards.
+ */
+void prefill(llama_context* ctx, DecodeThreads& threads, Batch& batch, const std::vector<llama_token>& tokens,
+             int32_t step_tokens, bool logits_last) {
+    for (size_t begin = 0; begin < tokens.size(); begin += step_tokens) {
+        size_t end = std::min(tokens.size(), begin + static_cast<size_t>(step_tokens));
+        batch.clear();
+        for (size_t i = begin; i < end; ++i) {
+            batch.add(tokens[i], static_cast<llama_pos>(i), logits_last && i + 1 == tokens.size());
+        }
+        threads.refresh();
+        if (llama_decode(ctx, batch.get()) != 0) {
+            throw std::runtime_error("Failed to decode prompt");
+        }
+    }
+}
+
+/**
+ * @brief Frees half of the cells after the first `n_keep` positions of sequence 0.
+ *
+ * The oldest tokens after the kept prefix are removed and the later ones
+ * are moved back (RoPE is re-applied by llama_memory_seq_add).
+ *
+ * @return Number of positions freed; 0 if the cache cannot shift
+ */
+llama_pos shift_context(llama_memory_t memory, llama_pos n_keep, llama_pos n_past) {
+    llama_pos n_discard = (n_past - n_keep) / 2;
+    if (n_discard <= 0 || !llama_memory_can_shift(memory)) {
+        return 0;
+    }
+    llama_memory_seq_rm(memory, 0, n_keep, n_keep + n_discard);
+    llama_memory_seq_add(memory, 0, n_keep + n_discard, n_past, -n_discard);
+    return n_discard;
+}
+
+} // namespace
+
+size_t count_tokens(const llama_vocab* vocab, const std::string& text) {
+    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, true, true);
+    return static_cast<size_t>(n_tokens < 0 ? -n_tokens : n_tokens);
+}
+
+json GenerationResult::usage() const {
+    return {
+        {"prompt", prompt_tokens},
+        {"generated", generated_tokens},
+        {"speculation", speculation},
+        {"context_shifts", context_shifts}
+    };
+}
+
+GenerationResult generate_text(llama_context* ctx, const llama_vocab* vocab, llama_sampler* sampler,
+                               const std::string& prompt, const GenerationOptions& options) {
+    GenerationResult result;
+    std::vector<llama_token> tokens = tokenize(vocab, prompt);
+    result.prompt_tokens = tokens.size();
+
+    const auto n_ctx = static_cast<llama_pos>(llama_n_ctx(ctx));
+    if (tokens.empty() || static_cast<llama_pos>(tokens.size()) >= n_ctx) {
+        throw std::runtime_error("Prompt of " + std::to_string(tokens.size()) +
+                                 " tokens does not fit the context (" + std::to_string(n_ctx) + ")");
+    }
+
+    // Each call is an independent sequence
+    llama_memory_t memory = llama_get_memory(ctx);
+    llama_memory_clear(memory, true);
+    llama_sampler_reset(sampler);
+
+    const int32_t step_tokens = step_budget(ctx, options);
+    size_t max_draft = options.prompt_lookup ? options.lookup.max_draft : 0;
+    max_draft = std::min(max_draft, static_cast<size_t>(step_tokens - 1));
+    Batch batch(std::max(step_tokens, static_cast<int32_t>(max_draft + 1)));
+
+    DecodeThreads threads(ctx);
+    uint64_t request_id = current_request_id();
+    EMPI_PROBE2(prefill__start, request_id, tokens.size());
+    prefill(ctx, threads, batch, tokens, step_tokens, true);
+    EMPI_PROBE2(prefill__end, request_id, tokens.size());
+
+    PromptLookup lookup(options.lookup);
+    if (options.prompt_lookup) {
+        lookup.reset(tokens);
+    }
+
+    // Appends a token to the output; false when generation is over
+    auto emit = [&](llama_token token) {
+        EMPI_PROBE3(decode__step, request_id, result.generated_tokens, token);
+        result.generated_tokens++;
+        if (llama_vocab_is_eog(vocab, token)) {
+            return false;
+        }
+        char buf[256];
+        int n = llama_token_to_piece(vocab, token, buf, sizeof(buf), 0, true);
+        if (n < 0) {
+            return false;
+        }
+        result.text.append(buf, n);
+        if (!options.stop.empty()) {
+            size_t from = result.text.size() - std::min(result.text.size(), static_cast<size_t>(n) + options.stop.size());
+            if (result.text.find(options.stop, from) != std::string::npos) {
+                return false;
+            }
+        }
+        if (options.prompt_lookup) {
+            lookup.push(token);
+        }
+        return static_cast<int>(result.generated_tokens) < options.max_tokens;
+    };
+
+    auto n_past = static_cast<llama_pos>(tokens.size());
+    int32_t logits_index = batch.get().n_tokens - 1;
+    // Token sampled where a draft was rejected, emitted next instead of sampling again
+    llama_token pending = 0;
+    bool has_pending = false;
+    // The instruction prefix survives shifts; at most half the context so a shift always frees room
+    llama_pos n_keep = std::min<llama_pos>(options.keep_tokens < 0 ? n_past : options.keep_tokens, n_ctx / 2);
+
+    while (true) {
+        llama_token token = has_pending ? pending : llama_sampler_sample(sampler, ctx, logits_index);
+        has_pending = false;
+        if (!emit(token)) {
+            break;
+        }
+        if (n_past >= n_ctx) {
+            llama_pos freed = options.context_shift ? shift_context(memory, n_keep, n_past) : 0;
+            if (freed == 0) {
+                break;
+            }
+            n_past -= freed;
+            result.context_shifts++;
+        }
+
+        std::vector<int32_t> draft;
+        if (options.prompt_lookup) {
+            draft = lookup.draft();
+            if (draft.size() > max_draft) draft.resize(max_draft);
+            size_t budget = std::min<size_t>(options.max_tokens - result.generated_tokens,
+                                             static_cast<size_t>(n_ctx - n_past - 1));
+            if (draft.size() > budget) draft.resize(budget);
+        }
+
+        batch.clear();
+        batch.add(token, n_past, true);
+        for (size_t i = 0; i < draft.size(); ++i) {
+            batch.add(draft[i], n_past + 1 + static_cast<llama_pos>(i), true);
+        }
+        result.speculation.decode_calls++;
+        threads.refresh();
+        if (llama_decode(ctx, batch.get()) != 0) {
+            break;
+        }
+        n_past++;
+        logits_index = 0;
+
+        // Verify the draft position by position
+        bool finished = false;
+        size_t accepted = 0;
+        while (accepted < draft.size()) {
+            llama_token next = llama_sampler_sample(sampler, ctx, static_cast<int32_t>(accepted));
+            if (next != draft[accepted]) {
+                pending = next;
+                has_pending = true;
+                break;
+            }
+            accepted++;
+            n_past++;
+            logits_index = static_cast<int32_t>(accepted);
+            if (!emit(next)) {
+                finished = true;
+                break;
+            }
+        }
+        result.speculation.drafted += draft.size();
+        result.speculation.accepted += accepted;
+        if (finished) {
+            break;
+        }
+        if (accepted < draft.size()) {
+            llama_memory_seq_rm(memory, 0, n_past, -1);
+        }
+    }
+
+    record_tokens(result.prompt_tokens, result.generated_tokens);
+    return result;
+}
+
+json ParallelGenerationResult::usage() const {
+    return {
+        {"prompt", prompt_tokens},
+        {"generated", generated_tokens},
+        {"sequences", texts.size()},
+        {"decode_calls", decode_calls},
+        {"prefill_chunks", prefill_chunks}
+    };
+}
+
+ParallelGenerationResult generate_parallel(llama_context* ctx, const llama_vocab* vocab,
+                                           const std::vector<llama_sampler*>& samplers,
+                                           const std::string& prefix,
+                                           const std::vector<std::string>& suffixes,
+                                           const GenerationOptions& options) {
+    ParallelGenerationResult result;
+    const size_t n = suffixes.size();
+    result.texts.resize(n);
+    if (n == 0) {
+        return result;
+    }
+    if (samplers.size() < n || n > llama_n_seq_max(ctx)) {
+        throw std::runtime_error("Not enough samplers or sequences for " + std::to_string(n) + " branches");
+    }
+
+    /// Scheduling state of one branch (= one sequence id)
+    struct Branch {
+        std::vector<llama_token> prompt;
+        size_t prefilled = 0;
+        llama_pos n_past = 0;
+        /// Batch index of this branch's logits from the last decode, -1 if none
+        int32_t logits_index = -1;
+        int generated = 0;
+        bool active = true;
+    };
+
+    std::vector<llama_token> prefix_tokens = tokenize(vocab, prefix);
+    std::vector<Branch> branches(n);
+    size_t prompt_tokens = prefix_tokens.size();
+    for (size_t i = 0; i < n; ++i) {
+        branches[i].prompt = tokenize(vocab, suffixes[i], false);
+        if (branches[i].prompt.empty()) {
+            throw std::runtime_error("Branch prompts must not be empty");
+        }
+        branches[i].n_past = static_cast<llama_pos>(prefix_tokens.size());
+        prompt_tokens += branches[i].prompt.size();
+    }
+    result.prompt_tokens = prompt_tokens;
+
+    // Every branch shares the prefix cells; split the rest of the context between them
+    const auto n_ctx = static_cast<int64_t>(llama_n_ctx(ctx));
+    int64_t per_branch = (n_ctx - static_cast<int64_t>(prompt_tokens)) / static_cast<int64_t>(n);
+    int budget = static_cast<int>(std::min<int64_t>(options.max_tokens, per_branch - 1));
+    if (prefix_tokens.empty() || budget <= 0) {
+        throw std::runtime_error("Prompt of " + std::to_string(prompt_tokens) +
+                                 " tokens leaves no room for " + std::to_string(n) + " branches");
+    }
+
+    llama_memory_t memory = llama_get_memory(ctx);
+    llama_memory_clear(memory, true);
+    for (size_t i = 0; i < n; ++i) {
+        llama_sampler_reset(samplers[i]);
+    }
+
+    // Room for one token of every branch plus at least one prompt token, so prefill always advances
+    const int32_t step_tokens = std::max(step_budget(ctx, options), static_cast<int32_t>(n + 1));
+    Batch batch(step_tokens);
+
+    DecodeThreads threads(ctx);
+    uint64_t request_id = current_request_id();
+    EMPI_PROBE2(prefill__start, request_id, prompt_tokens);
+    prefill(ctx, threads, batch, prefix_tokens, step_tokens, false);
+    for (size_t i = 1; i < n; ++i) {
+        llama_memory_seq_cp(memory, 0, static_cast<llama_seq_id>(i), -1, -1);
+    }
+
+    // Each step first advances every decoding branch by one token, then
+    // spends what is left of the budget on prompt chunks of the others
+    bool prefill_done = false;
+    for (int step = 0; ; ++step) {
+        std::vector<std::pair<size_t, llama_token>> sampled;
+        for (size_t i = 0; i < n; ++i) {
+            Branch& branch = branches[i];
+            if (!branch.active || branch.logits_index < 0) continue;
+            llama_token token = llama_sampler_sample(samplers[i], ctx, branch.logits_index);
+            EMPI_PROBE3(decode__step, request_id, step, token);
+            branch.generated++;
+            result.generated_tokens++;
+
+            char buf[256];
+            int len = llama_vocab_is_eog(vocab, token) ? -1
+                : llama_token_to_piece(vocab, token, buf, sizeof(buf), 0, true);
+            if (len < 0) {
+                branch.active = false;
+                continue;
+            }
+            result.texts[i].append(buf, len);
+            if (branch.generated >= budget) {
+                branch.active = false;
+                continue;
+            }
+            sampled.emplace_back(i, token);
+        }
+
+        batch.clear();
+        for (const auto& [i, token] : sampled) {
+            Branch& branch = branches[i];
+            branch.logits_index = batch.size();
+            batch.add(token, branch.n_past++, true, static_cast<llama_seq_id>(i));
+        }
+        bool prefilling = false;
+        for (size_t i = 0; i < n && batch.size() < step_tokens; ++i) {
+            Branch& branch = branches[i];
+            if (branch.prefilled == branch.prompt.size()) continue;
+            size_t chunk = std::min(branch.prompt.size() - branch.prefilled,
+                                    static_cast<size_t>(step_tokens - batch.size()));
+            for (size_t t = 0; t < chunk; ++t) {
+                bool last = ++branch.prefilled == branch.prompt.size();
+                if (last) branch.logits_index = batch.size();
+                batch.add(branch.prompt[branch.prefilled - 1], branch.n_past++, last, static_cast<llama_seq_id>(i));
+            }
+            prefilling = true;
+            result.prefill_chunks++;
+        }
+        if (!prefilling && !prefill_done) {
+            prefill_done = true;
+            EMPI_PROBE2(prefill__end, request_id, prompt_tokens);
+        }
+
+        if (batch.size() == 0) {
+            break;
+        }
+        result.decode_calls++;
+        threads.refresh();
+        if (llama_decode(ctx, batch.get()) != 0) {
+            break;
+        }
+    }
+
+    record_tokens(result.prompt_tokens, result.generated_tokens);
+    return result;
+}
+
+} // namespace EMPI
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "PromptLookup.hpp"
+#include <string>
+#include <vector>
+
+struct llama_context;
+struct llama_vocab;
+struct llama_sampler;
+
+namespace EMPI {
+
+/**
+ * @brief Number of tokens `text` tokenizes to (with BOS), without decoding anything.
+ */
+size_t count_tokens(const llama_vocab* vocab, const std::string& text);
+
+/**
+ * @struct GenerationOptions
+ * @brief Per-call settings of generate_text().
+ */
+struct GenerationOptions {
+    int max_tokens = 500;
+    /// Generation stops once the output contains this string (kept in the output)
+    std::string stop;
+    /// Prompt-lookup speculation; output is distributed exactly as without it
+    bool prompt_lookup = true;
+    PromptLookupConfig lookup;
+    /// Most tokens per decode call (capped by the context's n_batch); prompts are prefilled in chunks of this size
+    int32_t step_tokens = 512;
+    /// Keep generating past n_ctx by discarding old tokens after the kept prefix
+    bool context_shift = true;
+    /// Prompt tokens kept on a shift (-1 = the whole prompt); capped at n_ctx / 2
+    int32_t keep_tokens = -1;
+};
+
+/**
+ * @struct GenerationResult
+ * @brief Output text plus token accounting of one generation.
+ */
+struct GenerationResult {
+    std::string text;
+    size_t prompt_tokens = 0;
+    size_t generated_tokens = 0;
+    SpeculationStats speculation;
+    /// Times the KV cache was shifted to make room (see GenerationOptions::context_shift)
+    uint32_t context_shifts = 0;
+
+    /**
+     * @brief {"prompt", "generated", "speculation", "context_shifts"} for result metadata.
+     */
+    json usage() const;
+};
+
+/**
+ * @brief Runs one prompt through a context: prefill, then sampled decoding.
+ *
+ * The context's memory and the sampler are reset first, so every call
+ * starts from an empty KV cache. The prompt is prefilled in chunks of
+ * `options.step_tokens`, so prompts longer than n_batch decode too.
+ *
+ * When prompt plus output reach n_ctx, the context is shifted instead of
+ * stopping: the kept prefix (the prompt, or `keep_tokens` of it) stays, the
+ * older half of the tokens after it is discarded, and the remaining cells
+ * are moved back so generation continues in the same sequence. With prompt lookup enabled, each step
+ * appends the PromptLookup draft to the batch of the sampled token and
+ * decodes them together with logits at every position. Drafted tokens are
+ * then checked in order against what the sampler picks at each position.
+ * Matches are kept without further decoding. At the first mismatch the
+ * sampled token is kept, and the rejected positions are removed from the KV
+ * cache. Because every emitted token is still drawn by the sampler from the
+ * model's logits, speculation only changes the number of decode calls.
+ *
+ * Emits the prefill__start/end and decode__step probes.
+ *
+ * @throws std::runtime_error If the prompt does not fit the context or prefill fails
+ */
+GenerationResult generate_text(llama_context* ctx, const llama_vocab* vocab, llama_sampler* sampler,
+                               const std::string& prompt, const GenerationOptions& options);
+
+/**
+ * @struct ParallelGenerationResult
+ * @brief Outputs of generate_parallel(), one per branch, in input order.
+ */
+struct ParallelGenerationResult {
+    std::vector<std::string> texts;
+    size_t prompt_tokens = 0;
+    size_t generated_tokens = 0;
+    /// Batched decode calls after the shared prefix; about the length of the longest branch
+    uint64_t decode_calls = 0;
+    /// Branch prompt chunks that were decoded alongside other branches' tokens
+    uint64_t prefill_chunks = 0;
+
+    json usage() const;
+};
+
+/**
+ * @brief Generates several continuations of a shared prefix concurrently.
+ *
+ * The prefix is decoded once on sequence 0 and shared with sequences
+ * 1..n-1 through llama_memory_seq_cp (the context needs n_seq_max >= n and
+ * a unified KV cache for the cells to be shared rather than copied). Each
+ * branch then gets its own suffix (tokenized without BOS). Each step samples
+ * one token per unfinished branch and decodes all of them in a single batch,
+ * so wall time follows the longest branch instead of the sum.
+ *
+ * Prompts are prefilled in chunks so no decode call exceeds
+ * `options.step_tokens`: a step first takes one token of every decoding
+ * branch, then fills the rest of the budget with the next prompt chunks of
+ * branches still prefilling. A short branch prompt starts generating while a
+ * long one is still being read, and a long prompt never stalls the others
+ * for more than one bounded step. Branches stop at end-of-generation or
+ * `options.max_tokens`; the budget shrinks when the branches would not fit
+ * the context together. `stop`, prompt lookup and context shifting are
+ * not used here.
+ *
+ * @param samplers One sampler per branch (samplers are stateful)
+ * @throws std::runtime_error If a branch prompt is empty or the prompts leave no room in the context
+ */
+ParallelGenerationResult generate_parallel(llama_context* ctx, const llama_vocab* vocab,
+                                           const std::vector<llama_sampler*>& samplers,
+                                           const std::string& prefix,
+                                           const std::vector<std::string>& suffixes,
+                                           const GenerationOptions& options);
+
+} // namespace EMPI
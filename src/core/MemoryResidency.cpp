@@ -0,0 +1,325 @@
+/**
+ * @file MemoryResidency.cpp
+ * @brief madvise/mlock of model and KV ranges found in /proc/self/maps
+ */
+
+#include "MemoryResidency.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace EMPI {
+
+namespace {
+
+/// One entry of /proc/self/smaps: the mapping and its counters in bytes
+struct SmapsEntry {
+    MemoryRange range;
+    uint64_t locked = 0;
+    uint64_t huge = 0;
+};
+
+bool parse_maps_line(const std::string& line, MemoryRange& range) {
+    std::istringstream in(line);
+    std::string addresses, perms, offset, dev, inode;
+    if (!(in >> addresses >> perms >> offset >> dev >> inode)) {
+        return false;
+    }
+    size_t dash = addresses.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    range.begin = std::stoull(addresses.substr(0, dash), nullptr, 16);
+    range.end = std::stoull(addresses.substr(dash + 1), nullptr, 16);
+    std::getline(in >> std::ws, range.path);
+    return true;
+}
+
+std::vector<MemoryRange> read_maps() {
+    std::vector<MemoryRange> ranges;
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        MemoryRange range;
+        if (parse_maps_line(line, range)) {
+            ranges.push_back(std::move(range));
+        }
+    }
+    return ranges;
+}
+
+std::vector<SmapsEntry> read_smaps() {
+    std::vector<SmapsEntry> entries;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    while (std::getline(smaps, line)) {
+        MemoryRange range;
+        // Counter lines start with "Name:", mapping lines with a hex address range
+        size_t colon = line.find(':');
+        size_t space = line.find(' ');
+        if (colon != std::string::npos && colon < space) {
+            if (entries.empty()) continue;
+            std::string key = line.substr(0, colon);
+            uint64_t kb = std::strtoull(line.c_str() + colon + 1, nullptr, 10);
+            if (key == "Locked") {
+                entries.back().locked += kb * 1024;
+            } else if (key == "AnonHugePages" || key == "FilePmdMapped") {
+                entries.back().huge += kb * 1024;
+            }
+        } else if (parse_maps_line(line, range)) {
+            entries.push_back({std::move(range)});
+        }
+    }
+    return entries;
+}
+
+bool overlaps(const MemoryRange& a, const MemoryRange& b) {
+    return a.begin < b.end && b.begin < a.end;
+}
+
+uint64_t overlap_bytes(const MemoryRange& a, const MemoryRange& b) {
+    return overlaps(a, b) ? std::min(a.end, b.end) - std::max(a.begin, b.begin) : 0;
+}
+
+void warn(ResidencyReport& report, const std::string& what, const MemoryRange& range) {
+    std::ostringstream message;
+    message << what << " failed for " << range.size() << " bytes"
+            << (range.path.empty() ? "" : " of " + range.path) << ": " << std::strerror(errno);
+    report.warnings.push_back(message.str());
+}
+
+#ifdef __linux__
+uint64_t resident_bytes(const MemoryRange& range) {
+    static const long page = sysconf(_SC_PAGESIZE);
+    size_t pages = (range.size() + page - 1) / page;
+    std::vector<unsigned char> vec(pages);
+    if (mincore(reinterpret_cast<void*>(range.begin), range.size(), vec.data()) != 0) {
+        return 0;
+    }
+    uint64_t resident = 0;
+    for (unsigned char flags : vec) {
+        if (flags & 1) resident += page;
+    }
+    return std::min<uint64_t>(resident, range.size());
+}
+#endif
+
+} // namespace
+
+void to_json(json& j, const ResidencyReport& report) {
+    j = {
+        {"mapped_bytes", report.mapped_bytes},
+        {"resident_bytes", report.resident_bytes},
+        {"locked_bytes", report.locked_bytes},
+        {"huge_page_bytes", report.huge_page_bytes},
+        {"warnings", report.warnings}
+    };
+}
+
+std::vector<MemoryRange> file_mappings(const std::string& path) {
+    std::error_code ec;
+    fs::path target = fs::weakly_canonical(path, ec);
+    if (ec) target = path;
+
+    std::vector<MemoryRange> ranges;
+    for (auto& range : read_maps()) {
+        if (!range.path.empty() && range.path == target.string()) {
+            ranges.push_back(std::move(range));
+        }
+    }
+    return ranges;
+}
+
+std::vector<MemoryRange> anonymous_mappings(uint64_t min_size) {
+    std::vector<MemoryRange> ranges;
+    for (auto& range : read_maps()) {
+        if (range.path.empty() && range.size() >= min_size) {
+            ranges.push_back(std::move(range));
+        }
+    }
+    return ranges;
+}
+
+std::vector<MemoryRange> new_mappings(const std::vector<MemoryRange>& before,
+                                      const std::vector<MemoryRange>& after,
+                                      uint64_t min_size) {
+    std::vector<MemoryRange> sorted_before = before;
+    std::sort(sorted_before.begin(), sorted_before.end(),
+              [](const MemoryRange& a, const MemoryRange& b) { return a.begin < b.begin; });
+
+    // after minus before: a buffer merged into an existing mapping shows up as its extension
+    std::vector<MemoryRange> added;
+    auto add = [&](uintptr_t begin, uintptr_t end, const std::string& path) {
+        if (end > begin && end - begin >= min_size) added.push_back({begin, end, path});
+    };
+    for (const auto& range : after) {
+        uintptr_t cursor = range.begin;
+        for (const auto& old : sorted_before) {
+            if (old.end <= cursor) continue;
+            if (old.begin >= range.end) break;
+            if (old.begin > cursor) add(cursor, old.begin, range.path);
+            cursor = std::max(cursor, old.end);
+            if (cursor >= range.end) break;
+        }
+        if (cursor < range.end) add(cursor, range.end, range.path);
+    }
+    return added;
+}
+
+std::vector<MemoryRange> capture_new_mappings(const std::function<void()>& allocate) {
+    static std::mutex capture_mutex;
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    // Small mappings too, so a buffer that grows one of them past the size floor is not taken whole
+    auto before = anonymous_mappings(0);
+    allocate();
+    return new_mappings(before, anonymous_mappings(0), 2 * 1024 * 1024);
+}
+
+uint64_t available_memory_bytes() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t kb = 0;
+    std::string unit;
+    while (meminfo >> key >> kb) {
+        std::getline(meminfo, unit);
+        if (key == "MemAvailable:") {
+            return kb * 1024;
+        }
+    }
+    return 0;
+}
+
+ResidencyReport apply_residency(const std::vector<MemoryRange>& ranges, const ResidencyConfig& config) {
+    ResidencyReport report;
+#ifdef __linux__
+    for (const auto& range : ranges) {
+        void* addr = reinterpret_cast<void*>(range.begin);
+#ifdef MADV_HUGEPAGE
+        if (config.huge_pages && madvise(addr, range.size(), MADV_HUGEPAGE) != 0) {
+            warn(report, "madvise(MADV_HUGEPAGE)", range);
+        }
+#endif
+        if (config.prefetch) {
+            if (madvise(addr, range.size(), MADV_WILLNEED) != 0) {
+                warn(report, "madvise(MADV_WILLNEED)", range);
+            }
+#ifdef MADV_POPULATE_READ
+            // Kernels before 5.14 reject it; WILLNEED has already started readahead
+            if (madvise(addr, range.size(), MADV_POPULATE_READ) != 0 && errno != EINVAL) {
+                warn(report, "madvise(MADV_POPULATE_READ)", range);
+            }
+#endif
+        }
+        if (config.mlock && mlock(addr, range.size()) != 0) {
+            warn(report, "mlock", range);
+        }
+    }
+    ResidencyReport measured = measure_residency(ranges);
+    measured.warnings.insert(measured.warnings.begin(), report.warnings.begin(), report.warnings.end());
+    return measured;
+#else
+    (void)config;
+    if (!ranges.empty()) {
+        report.warnings.push_back("Residency controls are only supported on Linux");
+    }
+    return report;
+#endif
+}
+
+ResidencyReport measure_residency(const std::vector<MemoryRange>& ranges) {
+    ResidencyReport report;
+#ifdef __linux__
+    std::vector<SmapsEntry> smaps = read_smaps();
+    for (const auto& range : ranges) {
+        // Ranges may be stale (buffer freed); only count what is still mapped
+        for (const auto& entry : smaps) {
+            uint64_t bytes = overlap_bytes(entry.range, range);
+            if (bytes == 0) continue;
+
+            MemoryRange part{std::max(entry.range.begin, range.begin), std::min(entry.range.end, range.end), range.path};
+            report.mapped_bytes += bytes;
+            report.resident_bytes += resident_bytes(part);
+            // smaps counters are per mapping; scale them to the part we own
+            report.locked_bytes += entry.locked * bytes / entry.range.size();
+            report.huge_page_bytes += entry.huge * bytes / entry.range.size();
+        }
+    }
+#else
+    (void)ranges;
+#endif
+    return report;
+}
+
+ModelResidency::ModelResidency(std::string model_path)
+    : model_path_(std::move(model_path))
+{
+}
+
+json ModelResidency::configure(const ResidencyConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    configured_ = true;
+
+    ResidencyReport model = apply_residency(file_mappings(model_path_), config_);
+    json kv = apply_residency(kv_ranges(), kv_config());
+    kv["attribution"] = "heuristic";
+    return {{"model", model}, {"kv", kv}};
+}
+
+void ModelResidency::add_buffers(const void* owner, std::vector<MemoryRange> ranges) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (configured_) {
+        apply_residency(ranges, kv_config());
+    }
+    auto& owned = buffers_[owner];
+    owned.insert(owned.end(), ranges.begin(), ranges.end());
+}
+
+void ModelResidency::remove_buffers(const void* owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = buffers_.find(owner);
+    if (it == buffers_.end()) return;
+    buffers_.erase(it);
+}
+
+json ModelResidency::report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json kv = measure_residency(kv_ranges());
+    kv["attribution"] = "heuristic";
+    return {
+        {"config", {
+            {"huge_pages", config_.huge_pages},
+            {"mlock", config_.mlock},
+            {"prefetch", config_.prefetch}
+        }},
+        {"model", measure_residency(file_mappings(model_path_))},
+        {"kv", kv}
+    };
+}
+
+ResidencyConfig ModelResidency::kv_config() const {
+    // The KV ranges may include memory that is not ours; hints only, never lock it
+    ResidencyConfig config = config_;
+    config.mlock = false;
+    return config;
+}
+
+std::vector<MemoryRange> ModelResidency::kv_ranges() const {
+    std::vector<MemoryRange> ranges;
+    for (const auto& [owner, owned] : buffers_) {
+        ranges.insert(ranges.end(), owned.begin(), owned.end());
+    }
+    return ranges;
+}
+
+} // namespace EMPI
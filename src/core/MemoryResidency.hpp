@@ -0,0 +1,170 @@
+#pragma once
+
+/**
+ * @file MemoryResidency.hpp
+ * @brief Page residency controls for model weights and KV buffers.
+ *
+ * llama.cpp mmaps the GGUF file and allocates KV buffers itself, so these
+ * helpers find the ranges afterwards in /proc/self/maps and apply madvise()
+ * and mlock() to them. Everything is best effort: a refused call (no
+ * CAP_IPC_LOCK, RLIMIT_MEMLOCK too low, THP disabled) becomes a warning in
+ * the report and the range stays as it was. On platforms other than Linux
+ * the functions report nothing and do nothing.
+ *
+ * The model mapping is identified by its file. KV buffers are not exposed by
+ * llama.cpp; they are taken to be the anonymous memory that appears while a
+ * context is created (see capture_new_mappings()), which is a heuristic. KV
+ * ranges therefore only get madvise() hints and are measured, never locked.
+ *
+ * Only transparent huge pages are supported. Explicit huge pages (hugetlbfs,
+ * MAP_HUGETLB) would have to be requested when llama.cpp allocates the
+ * buffers and cannot be applied afterwards.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct ResidencyConfig
+ * @brief What to do with the model and KV pages.
+ */
+struct ResidencyConfig {
+    /// madvise(MADV_HUGEPAGE): transparent huge pages for KV buffers, and for the
+    /// model mapping where the kernel supports file THP (hugetlbfs is not supported)
+    bool huge_pages = false;
+    /// mlock() the model mapping so it is never paged out after idle time (KV buffers are not locked)
+    bool mlock = false;
+    /// madvise(MADV_WILLNEED), then MADV_POPULATE_READ where available, to fault pages in now
+    bool prefetch = true;
+};
+
+/**
+ * @struct MemoryRange
+ * @brief One mapping of the process, as listed in /proc/self/maps.
+ */
+struct MemoryRange {
+    uintptr_t begin = 0;
+    uintptr_t end = 0;
+    /// Backing file, or empty for anonymous memory
+    std::string path;
+
+    uint64_t size() const { return end - begin; }
+};
+
+/**
+ * @struct ResidencyReport
+ * @brief Mapped vs resident bytes of a set of ranges, plus refused operations.
+ */
+struct ResidencyReport {
+    uint64_t mapped_bytes = 0;
+    /// Pages present in memory (mincore), i.e. accessible without a major fault
+    uint64_t resident_bytes = 0;
+    uint64_t locked_bytes = 0;
+    /// Bytes backed by huge pages (AnonHugePages + FilePmdMapped)
+    uint64_t huge_page_bytes = 0;
+    std::vector<std::string> warnings;
+};
+
+void to_json(json& j, const ResidencyReport& report);
+
+/**
+ * @brief Mappings of `path` (compared after resolving symlinks), in address order.
+ */
+std::vector<MemoryRange> file_mappings(const std::string& path);
+
+/**
+ * @brief All anonymous mappings of at least `min_size` bytes.
+ */
+std::vector<MemoryRange> anonymous_mappings(uint64_t min_size = 2 * 1024 * 1024);
+
+/**
+ * @brief The parts of `after` not covered by `before`, dropping parts smaller than `min_size`.
+ *
+ * Snapshots of anonymous_mappings() taken around an allocation yield the
+ * buffers it created, including one the kernel merged into an adjacent
+ * mapping (allocations on other threads in between are included).
+ */
+std::vector<MemoryRange> new_mappings(const std::vector<MemoryRange>& before,
+                                      const std::vector<MemoryRange>& after,
+                                      uint64_t min_size = 0);
+
+/**
+ * @brief Runs `allocate` between two snapshots of the anonymous mappings and returns the new memory.
+ *
+ * Calls are serialized process-wide, so allocations made through here (e.g.
+ * contexts created by different agents) are never attributed to each other.
+ * Large allocations made meanwhile by other code are still included, and
+ * memory released and reused at the same addresses in between is missed.
+ */
+std::vector<MemoryRange> capture_new_mappings(const std::function<void()>& allocate);
+
+/**
+ * @brief MemAvailable from /proc/meminfo in bytes, or 0 if unknown.
+ */
+uint64_t available_memory_bytes();
+
+/**
+ * @brief Applies `config` to the ranges; failures are collected as warnings.
+ */
+ResidencyReport apply_residency(const std::vector<MemoryRange>& ranges, const ResidencyConfig& config);
+
+/**
+ * @brief Measures the ranges without changing them.
+ */
+ResidencyReport measure_residency(const std::vector<MemoryRange>& ranges);
+
+/**
+ * @class ModelResidency
+ * @brief Tracks an agent's model mapping and KV buffers and applies a ResidencyConfig to them.
+ *
+ * Buffers are registered per owner (a llama_context) when the context is
+ * created and dropped before it is freed; the current config is applied to
+ * new buffers as they are registered.
+ *
+ * Thread-safe.
+ */
+class ModelResidency {
+public:
+    explicit ModelResidency(std::string model_path = "");
+
+    /**
+     * @brief Sets the config and applies it to the model and every tracked buffer.
+     */
+    json configure(const ResidencyConfig& config);
+
+    /**
+     * @brief Registers the buffers of `owner` and applies the current config, except mlock, to them.
+     */
+    void add_buffers(const void* owner, std::vector<MemoryRange> ranges);
+
+    void remove_buffers(const void* owner);
+
+    /**
+     * @brief {"config", "model": ResidencyReport, "kv": ResidencyReport plus "attribution"}.
+     *
+     * `kv.attribution` is "heuristic": the KV ranges are the mappings captured
+     * around context creation (see capture_new_mappings()).
+     */
+    json report() const;
+
+private:
+    ResidencyConfig kv_config() const;
+    std::vector<MemoryRange> kv_ranges() const;
+
+    std::string model_path_;
+    ResidencyConfig config_;
+    bool configured_ = false;
+    std::unordered_map<const void*, std::vector<MemoryRange>> buffers_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace EMPI
@@ -0,0 +1,59 @@
+/**
+ * @file MetricProjection.cpp
+ * @brief Validation and projection of requested text metrics
+ */
+
+#include "MetricProjection.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace EMPI {
+
+const std::vector<std::string>& text_metric_names() {
+    static const std::vector<std::string> names = [] {
+        std::vector<std::string> result;
+        TextMetricsData metrics;
+        TextMetricsData::visit_fields(metrics, [&result](const char* name, auto&) {
+            result.emplace_back(name);
+        });
+        return result;
+    }();
+    return names;
+}
+
+std::vector<std::string> resolve_metrics(const json& requested) {
+    if (!requested.is_array()) {
+        throw std::invalid_argument("'metrics' must be an array of metric names");
+    }
+    const auto& names = text_metric_names();
+    std::vector<bool> wanted(names.size(), false);
+    // Complexity labels are derived from it, so it is always computed
+    static const size_t grade = std::find(names.begin(), names.end(), "flesch_kincaid_grade") - names.begin();
+    wanted.at(grade) = true;
+    for (const auto& name : requested) {
+        if (!name.is_string()) {
+            throw std::invalid_argument("'metrics' must be an array of metric names");
+        }
+        auto it = std::find(names.begin(), names.end(), name.get_ref<const std::string&>());
+        if (it == names.end()) {
+            throw std::invalid_argument("Unknown metric: " + name.get<std::string>());
+        }
+        wanted[it - names.begin()] = true;
+    }
+
+    std::vector<std::string> selected;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (wanted[i]) selected.push_back(names[i]);
+    }
+    return selected;
+}
+
+void project_metrics(TextMetricsData& metrics, const std::vector<std::string>& selected) {
+    TextMetricsData::visit_fields(metrics, [&selected](const char* name, auto& field) {
+        if (std::find(selected.begin(), selected.end(), name) == selected.end()) {
+            field.reset();
+        }
+    });
+}
+
+} // namespace EMPI
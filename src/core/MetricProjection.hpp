@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * @file MetricProjection.hpp
+ * @brief Selection of the text metrics a request asks for.
+ *
+ * A text_metrics request may carry `"metrics": ["flesch_kincaid_grade", ...]`.
+ * The Python analyzer then computes only those metrics and the intermediates
+ * they depend on (see METRICS in integrations/text_analyzer.py); a request
+ * without the field gets every metric, as before.
+ */
+
+#include "Payloads.hpp"
+#include <string>
+#include <vector>
+
+namespace EMPI {
+
+/**
+ * @brief Names of all TextMetricsData fields, in visit_fields() order.
+ */
+const std::vector<std::string>& text_metric_names();
+
+/**
+ * @brief Validates a requested metric list and returns it in canonical order.
+ *
+ * flesch_kincaid_grade is always included: the complexity labels are
+ * derived from it. Duplicates are removed.
+ *
+ * @param requested JSON array of metric names
+ * @throws std::invalid_argument If `requested` is not an array of known metric names
+ */
+std::vector<std::string> resolve_metrics(const json& requested);
+
+/**
+ * @brief Clears every metric of `metrics` that is not in `selected`.
+ *
+ * Used after a chunked analysis, whose merge step derives all formulas
+ * from the aggregates, including ones whose inputs were not collected.
+ */
+void project_metrics(TextMetricsData& metrics, const std::vector<std::string>& selected);
+
+} // namespace EMPI
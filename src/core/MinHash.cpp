@@ -0,0 +1,241 @@
+/**
+ * @file MinHash.cpp
+ * @brief MinHash signatures and banded LSH clustering
+ */
+
+#include "MinHash.hpp"
+#include "CpuBudget.hpp"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+namespace EMPI {
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t fnv1a(const std::string& text, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<std::string> normalized_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) {
+            word.push_back(static_cast<char>(std::tolower(c)));
+        } else if (!word.empty()) {
+            words.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) words.push_back(std::move(word));
+    return words;
+}
+
+std::vector<uint64_t> shingle_hashes(const std::string& text, size_t shingle_words) {
+    std::vector<std::string> words = normalized_words(text);
+    std::vector<uint64_t> hashes;
+    if (words.empty()) return hashes;
+
+    size_t k = std::max<size_t>(1, std::min(shingle_words, words.size()));
+    hashes.reserve(words.size() - k + 1);
+    for (size_t i = 0; i + k <= words.size(); ++i) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t j = i; j < i + k; ++j) {
+            hash = fnv1a(words[j], hash);
+            hash = fnv1a(" ", hash);
+        }
+        hashes.push_back(hash);
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    return hashes;
+}
+
+} // namespace
+
+MinHashDeduplicator::MinHashDeduplicator(MinHashConfig config)
+    : config_(config)
+    , buckets_(config.bands)
+{
+    if (config_.bands == 0 || config_.rows_per_band == 0) {
+        throw std::invalid_argument("MinHash needs at least one band and one row");
+    }
+    size_t num_hashes = config_.bands * config_.rows_per_band;
+    seeds_.reserve(num_hashes);
+    for (size_t i = 0; i < num_hashes; ++i) {
+        seeds_.push_back(splitmix64(config_.seed + i));
+    }
+}
+
+MinHashDeduplicator::Signature MinHashDeduplicator::signature(const std::string& text) const {
+    std::vector<uint64_t> shingles = shingle_hashes(text, config_.shingle_words);
+    if (shingles.empty()) return {};
+
+    Signature sig(seeds_.size(), std::numeric_limits<uint32_t>::max());
+    for (uint64_t shingle : shingles) {
+        for (size_t i = 0; i < seeds_.size(); ++i) {
+            auto value = static_cast<uint32_t>(splitmix64(shingle ^ seeds_[i]) >> 32);
+            if (value < sig[i]) sig[i] = value;
+        }
+    }
+    return sig;
+}
+
+double MinHashDeduplicator::similarity(const Signature& a, const Signature& b) {
+    if (a.empty() || a.size() != b.size()) return 0.0;
+    size_t equal = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        equal += a[i] == b[i];
+    }
+    return static_cast<double>(equal) / static_cast<double>(a.size());
+}
+
+std::vector<size_t> MinHashDeduplicator::add_batch(const std::vector<std::string>& texts) {
+    std::vector<Signature> batch(texts.size());
+
+    size_t threads = config_.threads ? config_.threads : CpuBudget::global().cores();
+    threads = std::min(threads, texts.size());
+    CpuLease cpu;
+    if (threads > 1) {
+        cpu = CpuBudget::global().acquire("orchestration", threads);
+        threads = cpu.cores();
+    }
+    if (threads <= 1) {
+        for (size_t i = 0; i < texts.size(); ++i) batch[i] = signature(texts[i]);
+    } else {
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([this, &texts, &batch, t, threads] {
+                for (size_t i = t; i < texts.size(); i += threads) {
+                    batch[i] = signature(texts[i]);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+
+    size_t first = signatures_.size();
+    for (auto& sig : batch) {
+        insert(std::move(sig));
+    }
+
+    std::vector<size_t> representatives;
+    representatives.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        representatives.push_back(find_root(first + i));
+    }
+    return representatives;
+}
+
+size_t MinHashDeduplicator::add(const std::string& text) {
+    return add_batch({text}).front();
+}
+
+void MinHashDeduplicator::insert(Signature sig) {
+    auto doc = static_cast<uint32_t>(signatures_.size());
+    signatures_.push_back(std::move(sig));
+    parent_.push_back(doc);
+
+    const Signature& current = signatures_.back();
+    if (current.empty()) return;
+
+    for (size_t band = 0; band < config_.bands; ++band) {
+        uint64_t key = splitmix64(band);
+        for (size_t row = 0; row < config_.rows_per_band; ++row) {
+            key = splitmix64(key ^ current[band * config_.rows_per_band + row]);
+        }
+        auto& bucket = buckets_[band][key];
+        for (uint32_t other : bucket) {
+            if (find_root(other) == find_root(doc)) continue;
+            if (similarity(current, signatures_[other]) >= config_.threshold) {
+                unite(doc, other);
+            }
+        }
+        bucket.push_back(doc);
+    }
+}
+
+size_t MinHashDeduplicator::find_root(size_t doc) const {
+    size_t root = doc;
+    while (parent_[root] != root) root = parent_[root];
+    while (parent_[doc] != root) {
+        size_t next = parent_[doc];
+        parent_[doc] = static_cast<uint32_t>(root);
+        doc = next;
+    }
+    return root;
+}
+
+void MinHashDeduplicator::unite(size_t a, size_t b) {
+    size_t ra = find_root(a);
+    size_t rb = find_root(b);
+    if (ra == rb) return;
+    // The earliest document stays the representative
+    if (rb < ra) std::swap(ra, rb);
+    parent_[rb] = static_cast<uint32_t>(ra);
+}
+
+size_t MinHashDeduplicator::representative(size_t doc) const {
+    if (doc >= parent_.size()) {
+        throw std::out_of_range("Unknown document index");
+    }
+    return find_root(doc);
+}
+
+json MinHashDeduplicator::report(const std::vector<std::string>& ids) const {
+    auto name = [&ids](size_t doc) -> json {
+        if (doc < ids.size()) return ids[doc];
+        return doc;
+    };
+
+    std::map<size_t, std::vector<size_t>> clusters;
+    for (size_t doc = 0; doc < signatures_.size(); ++doc) {
+        clusters[find_root(doc)].push_back(doc);
+    }
+
+    json duplicate_clusters = json::array();
+    size_t duplicates = 0;
+    for (const auto& [root, members] : clusters) {
+        if (members.size() < 2) continue;
+        duplicates += members.size() - 1;
+
+        json entries = json::array();
+        for (size_t doc : members) {
+            if (doc == root) continue;
+            entries.push_back({
+                {"id", name(doc)},
+                {"similarity", similarity(signatures_[doc], signatures_[root])}
+            });
+        }
+        duplicate_clusters.push_back({
+            {"representative", name(root)},
+            {"duplicates", entries}
+        });
+    }
+
+    return {
+        {"documents", signatures_.size()},
+        {"representatives", clusters.size()},
+        {"duplicates", duplicates},
+        {"threshold", config_.threshold},
+        {"clusters", duplicate_clusters}
+    };
+}
+
+} // namespace EMPI
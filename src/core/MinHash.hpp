@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct MinHashConfig
+ * @brief Shingling and LSH parameters for near-duplicate detection.
+ *
+ * With b bands of r rows, pairs of Jaccard similarity s become candidates
+ * with probability 1 - (1 - s^r)^b; the default 16x8 has its steep part
+ * around s = 0.7, and candidates are then verified against `threshold`.
+ */
+struct MinHashConfig {
+    size_t shingle_words = 3;
+    size_t bands = 16;
+    size_t rows_per_band = 8;
+    /// Minimum estimated Jaccard similarity for two texts to be clustered.
+    double threshold = 0.8;
+    /// Threads used to compute signatures of a batch (0 = the cores of CpuBudget::global()).
+    size_t threads = 0;
+    uint64_t seed = 0x9e3779b97f4a7c15ull;
+};
+
+/**
+ * @class MinHashDeduplicator
+ * @brief Streaming MinHash/LSH clustering of near-duplicate texts.
+ *
+ * Texts are normalized (lowercase alphanumeric words), shingled into word
+ * n-grams and reduced to fixed-size MinHash signatures. Documents are added
+ * in batches: signatures are computed in parallel, then inserted in order
+ * into banded LSH buckets, so the result does not depend on thread count.
+ * Verified candidate pairs are merged with union-find; the earliest document
+ * of a cluster is its representative.
+ *
+ * Memory per document is one signature (bands * rows_per_band * 4 bytes)
+ * plus one bucket entry per band.
+ */
+class MinHashDeduplicator {
+public:
+    using Signature = std::vector<uint32_t>;
+
+    explicit MinHashDeduplicator(MinHashConfig config = {});
+
+    /**
+     * @brief MinHash signature of a text; empty texts yield an empty signature.
+     */
+    Signature signature(const std::string& text) const;
+
+    /**
+     * @brief Estimated Jaccard similarity (fraction of agreeing rows).
+     */
+    static double similarity(const Signature& a, const Signature& b);
+
+    /**
+     * @brief Adds a batch of documents.
+     *
+     * @return Current representative index of each added document
+     *         (the document's own index when it starts a new cluster)
+     */
+    std::vector<size_t> add_batch(const std::vector<std::string>& texts);
+
+    /**
+     * @brief Adds a single document; see add_batch().
+     */
+    size_t add(const std::string& text);
+
+    /**
+     * @brief Representative of a document's cluster (may change as documents are added).
+     */
+    size_t representative(size_t doc) const;
+
+    size_t size() const { return signatures_.size(); }
+
+    /**
+     * @brief Dedup report: counts and every cluster with more than one member.
+     *
+     * @param ids Optional document ids (same order as added); indices are used otherwise
+     */
+    json report(const std::vector<std::string>& ids = {}) const;
+
+private:
+    void insert(Signature signature);
+    size_t find_root(size_t doc) const;
+    void unite(size_t a, size_t b);
+
+    MinHashConfig config_;
+    std::vector<uint64_t> seeds_;
+    std::vector<Signature> signatures_;
+    mutable std::vector<uint32_t> parent_;
+    /// One bucket table per band: band hash -> documents
+    std::vector<std::unordered_map<uint64_t, std::vector<uint32_t>>> buckets_;
+};
+
+} // namespace EMPI
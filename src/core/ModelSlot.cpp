@@ -0,0 +1,372 @@
+/**
+ * @file ModelSlot.cpp
+ * @brief Model loading, fingerprinting, background hot swap and idle unloading
+ */
+
+#include "ModelSlot.hpp"
+#include "CpuBudget.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "llama.h"
+
+namespace fs = std::filesystem;
+
+namespace EMPI {
+
+namespace {
+
+uint64_t fnv1a(uint64_t hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::string model_fingerprint(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (!file || ec) {
+        return "";
+    }
+
+    uint64_t hash = fnv1a(14695981039346656037ull, reinterpret_cast<const char*>(&size), sizeof(size));
+    std::vector<char> buffer(1 << 20);
+    file.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(size, buffer.size())));
+    hash = fnv1a(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+
+    const uint64_t tail = 64 * 1024;
+    if (size > buffer.size() + tail) {
+        file.seekg(static_cast<std::streamoff>(size - tail));
+        file.read(buffer.data(), tail);
+        hash = fnv1a(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+LoadedModel::LoadedModel(const std::string& path, const ModelLoadConfig& config,
+                         const std::optional<ResidencyConfig>& residency)
+    : path_(path)
+    , fingerprint_(model_fingerprint(path))
+    , key_(fingerprint_.empty() ? 0 : std::stoull(fingerprint_, nullptr, 16))
+    , residency_(path)
+{
+    if (fingerprint_.empty()) {
+        throw std::runtime_error("Model not found: " + path);
+    }
+
+    llama_backend_init();
+
+    llama_model_params model_params = llama_model_default_params();
+    model_params.n_gpu_layers = config.n_gpu_layers;
+    // Weights stay in the page cache after an idle unload, so a reload maps them without reading disk
+    model_params.use_mmap = true;
+
+    // Serialized with context creation so that buffers allocated by the load are not taken for KV buffers
+    capture_new_mappings([&] { model_ = llama_model_load_from_file(path.c_str(), model_params); });
+    if (!model_) {
+        throw std::runtime_error("Failed to load model: " + path);
+    }
+    vocab_ = llama_model_get_vocab(model_);
+
+    // Contexts are created per size class on demand; the smallest one is created now to fail early
+    ContextPoolConfig pool_config;
+    pool_config.size_classes = config.size_classes;
+    contexts_ = std::make_unique<ContextPool>(pool_config,
+        [this, config](uint32_t n_ctx) {
+            llama_context_params ctx_params = llama_context_default_params();
+            ctx_params.n_ctx = n_ctx;
+            ctx_params.n_batch = std::min(config.n_batch, n_ctx);
+            // Upper bound; each generation runs with the threads it leases (see CpuBudget)
+            ctx_params.n_threads = static_cast<int32_t>(CpuBudget::global().cores());
+            ctx_params.n_threads_batch = ctx_params.n_threads;
+            ctx_params.n_seq_max = config.n_seq_max;
+            ctx_params.kv_unified = config.kv_unified;
+            // KV buffers are the anonymous mappings the context adds
+            llama_context* ctx = nullptr;
+            std::vector<MemoryRange> buffers = capture_new_mappings([&] {
+                ctx = llama_init_from_model(model_, ctx_params);
+            });
+            if (ctx) {
+                residency_.add_buffers(ctx, std::move(buffers));
+            }
+            return ctx;
+        },
+        [this](llama_context* ctx) {
+            residency_.remove_buffers(ctx);
+            llama_free(ctx);
+        });
+
+    try {
+        if (residency) {
+            residency_.configure(*residency);
+        }
+        contexts_->acquire(0);
+    } catch (const std::exception&) {
+        contexts_.reset();
+        llama_model_free(model_);
+        throw std::runtime_error("Failed to create context");
+    }
+}
+
+LoadedModel::~LoadedModel() {
+    contexts_.reset();
+    if (model_) llama_model_free(model_);
+}
+
+ModelSlot::ModelSlot(ModelLoadConfig config)
+    : config_(std::move(config))
+{
+}
+
+ModelSlot::~ModelSlot() {
+    stop_idle();
+    wait_for_load();
+}
+
+void ModelSlot::load(const std::string& path) {
+    std::optional<ResidencyConfig> residency;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        residency = residency_;
+    }
+    try {
+        install(std::make_shared<LoadedModel>(path, config_, residency));
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = e.what();
+        throw;
+    }
+}
+
+bool ModelSlot::load_async(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loading_) {
+        return false;
+    }
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    loading_ = true;
+    loading_path_ = path;
+    loader_ = std::thread([this, path] {
+        try {
+            load(path);
+        } catch (const std::exception&) {
+            // Recorded in last_error_; the current model keeps serving
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        loading_ = false;
+        loading_path_.clear();
+    });
+    return true;
+}
+
+void ModelSlot::wait_for_load() {
+    std::thread loader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loader = std::move(loader_);
+    }
+    if (loader.joinable()) {
+        loader.join();
+    }
+}
+
+std::shared_ptr<LoadedModel> ModelSlot::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+std::shared_ptr<LoadedModel> ModelSlot::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_used_ = std::chrono::steady_clock::now();
+        if (current_ || unloaded_path_.empty()) {
+            return current_;
+        }
+    }
+
+    // Concurrent first requests after an unload wait for a single reload
+    std::lock_guard<std::mutex> reload(reload_mutex_);
+    std::string path;
+    std::optional<ResidencyConfig> residency;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_ || unloaded_path_.empty()) {
+            return current_;
+        }
+        path = unloaded_path_;
+        residency = residency_;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<LoadedModel> model;
+    try {
+        model = std::make_shared<LoadedModel>(path, config_, residency);
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_error_ = e.what();
+        throw;
+    }
+    install(model);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    reloads_++;
+    last_reload_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    last_used_ = std::chrono::steady_clock::now();
+    return model;
+}
+
+bool ModelSlot::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_ || !unloaded_path_.empty();
+}
+
+void ModelSlot::set_idle_policy(const IdlePolicy& policy) {
+    stop_idle();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_policy_ = policy;
+    idle_policy_.check_interval = std::max(idle_policy_.check_interval, std::chrono::seconds(1));
+    if (!idle_policy_.enabled()) {
+        return;
+    }
+    stop_idle_ = false;
+    idle_thread_ = std::thread([this] { idle_loop(); });
+}
+
+json ModelSlot::configure_memory(const ResidencyConfig& config) {
+    std::shared_ptr<LoadedModel> model;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        residency_ = config;
+        model = current_;
+    }
+    return model ? model->residency().configure(config) : json::object();
+}
+
+std::string ModelSlot::last_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+json ModelSlot::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t draining = std::count_if(retired_.begin(), retired_.end(),
+                                    [](const auto& model) { return !model.expired(); });
+    double idle_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - last_used_).count();
+    return {
+        {"path", current_ ? current_->path() : unloaded_path_},
+        {"fingerprint", current_ ? current_->fingerprint() : unloaded_fingerprint_},
+        {"loading", loading_ ? json(loading_path_) : json(nullptr)},
+        {"swaps", swaps_},
+        {"draining", draining},
+        {"last_error", last_error_},
+        {"idle", {
+            {"seconds", idle_seconds},
+            {"unloaded", !current_ && !unloaded_path_.empty()},
+            {"unloads", idle_unloads_},
+            {"trimmed_contexts", idle_trims_},
+            {"reloads", reloads_},
+            {"last_reload_seconds", last_reload_seconds_}
+        }}
+    };
+}
+
+void ModelSlot::install(std::shared_ptr<LoadedModel> model) {
+    std::shared_ptr<LoadedModel> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::move(current_);
+        current_ = std::move(model);
+        last_error_.clear();
+        unloaded_path_.clear();
+        unloaded_fingerprint_.clear();
+        if (previous) {
+            swaps_++;
+            retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                          [](const auto& old) { return old.expired(); }),
+                           retired_.end());
+            retired_.push_back(previous);
+        }
+    }
+    // Dropping our reference outside the lock; the model is freed here unless requests still hold it
+    previous.reset();
+}
+
+void ModelSlot::idle_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_idle_) {
+        idle_wake_.wait_for(lock, idle_policy_.check_interval);
+        if (stop_idle_) break;
+        lock.unlock();
+        check_idle();
+        lock.lock();
+    }
+}
+
+void ModelSlot::check_idle() {
+    IdlePolicy policy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        policy = idle_policy_;
+    }
+    bool pressure = policy.min_available_bytes > 0 &&
+                    available_memory_bytes() < policy.min_available_bytes;
+
+    std::shared_ptr<LoadedModel> model;
+    std::shared_ptr<LoadedModel> unloaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Requests copy current_ under this lock, so a count of 1 means none is running
+        if (!current_ || loading_ || current_.use_count() > 1) {
+            return;
+        }
+        bool expired = policy.idle_after.count() > 0 &&
+                       std::chrono::steady_clock::now() - last_used_ >= policy.idle_after;
+        if (!expired && !pressure) {
+            return;
+        }
+        if (policy.unload_model) {
+            unloaded_path_ = current_->path();
+            unloaded_fingerprint_ = current_->fingerprint();
+            unloaded = std::move(current_);
+            idle_unloads_++;
+        } else {
+            model = current_;
+        }
+    }
+
+    if (model) {
+        size_t freed = model->contexts().trim();
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_trims_ += freed;
+    }
+    // `unloaded` frees the model and its contexts here, outside the lock
+}
+
+void ModelSlot::stop_idle() {
+    std::thread monitor;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_idle_ = true;
+        monitor = std::move(idle_thread_);
+    }
+    idle_wake_.notify_all();
+    if (monitor.joinable()) {
+        monitor.join();
+    }
+}
+
+} // namespace EMPI
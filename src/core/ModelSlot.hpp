@@ -0,0 +1,223 @@
+#pragma once
+
+#include "ContextPool.hpp"
+#include "MemoryResidency.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+struct llama_model;
+struct llama_vocab;
+
+namespace EMPI {
+
+/**
+ * @struct ModelLoadConfig
+ * @brief How an agent loads its model and creates its contexts.
+ */
+struct ModelLoadConfig {
+    int32_t n_gpu_layers = 99;
+    std::vector<uint32_t> size_classes = {1024, 2048, 4096};
+    uint32_t n_batch = 2048;
+    /// Parallel sequences per context (see generate_parallel())
+    uint32_t n_seq_max = 1;
+    bool kv_unified = false;
+};
+
+/**
+ * @struct IdlePolicy
+ * @brief When an idle agent gives memory back to the host.
+ *
+ * An agent is idle when no request holds its model. After `idle_after`
+ * without requests its contexts are freed, and with `unload_model` the
+ * model as well. Below the `min_available_bytes` watermark (MemAvailable)
+ * this happens at the next check, without waiting for `idle_after`.
+ */
+struct IdlePolicy {
+    /// 0 = only under memory pressure
+    std::chrono::seconds idle_after{0};
+    bool unload_model = false;
+    /// 0 = no watermark
+    uint64_t min_available_bytes = 0;
+    std::chrono::seconds check_interval{10};
+
+    bool enabled() const { return idle_after.count() > 0 || min_available_bytes > 0; }
+};
+
+/**
+ * @brief Content fingerprint of a model file: FNV-1a over its size, first 1 MiB and last 64 KiB.
+ *
+ * The GGUF header and metadata (architecture, quantization, vocabulary) sit
+ * at the start of the file, so two quantizations of the same model differ.
+ *
+ * @return 16 hex digits, or "" if the file cannot be read
+ */
+std::string model_fingerprint(const std::string& path);
+
+/**
+ * @class LoadedModel
+ * @brief One loaded model with its context pool and residency tracking.
+ *
+ * Requests hold a shared_ptr for their whole duration, so the model and
+ * its contexts outlive a swap until the last in-flight request returns.
+ */
+class LoadedModel {
+public:
+    /**
+     * @throws std::runtime_error If the model or its first context cannot be created
+     */
+    LoadedModel(const std::string& path, const ModelLoadConfig& config,
+                const std::optional<ResidencyConfig>& residency);
+    ~LoadedModel();
+
+    LoadedModel(const LoadedModel&) = delete;
+    LoadedModel& operator=(const LoadedModel&) = delete;
+
+    const llama_vocab* vocab() const { return vocab_; }
+    ContextPool& contexts() { return *contexts_; }
+    ModelResidency& residency() { return residency_; }
+
+    const std::string& path() const { return path_; }
+    const std::string& fingerprint() const { return fingerprint_; }
+
+    /**
+     * @brief 64-bit form of the fingerprint, for mixing into cache keys.
+     */
+    uint64_t key() const { return key_; }
+
+private:
+    std::string path_;
+    std::string fingerprint_;
+    uint64_t key_ = 0;
+    llama_model* model_ = nullptr;
+    const llama_vocab* vocab_ = nullptr;
+    ModelResidency residency_;
+    std::unique_ptr<ContextPool> contexts_;
+};
+
+/**
+ * @class ModelSlot
+ * @brief The model an agent currently serves with, replaceable without downtime.
+ *
+ * current() returns the active model. load_async() loads a replacement on a
+ * background thread while requests keep using the old one; once it is ready
+ * it becomes current() atomically. Requests already running finish on the
+ * old model, which is freed when the last of them drops its reference.
+ * A failed load leaves the active model in place and is reported by status().
+ *
+ * With an IdlePolicy a monitor thread frees contexts, and optionally the
+ * model, once the agent has been idle. The path and fingerprint are kept,
+ * and acquire() loads the model again on the next request. Models are
+ * mmapped (llama.cpp's default), so the file usually stays in the page
+ * cache after an unload and the reload reads no disk.
+ *
+ * Thread-safe.
+ */
+class ModelSlot {
+public:
+    explicit ModelSlot(ModelLoadConfig config = {});
+    ~ModelSlot();
+
+    ModelSlot(const ModelSlot&) = delete;
+    ModelSlot& operator=(const ModelSlot&) = delete;
+
+    /**
+     * @brief Loads `path` on the calling thread and makes it current.
+     *
+     * @throws std::runtime_error If loading fails (the previous model stays current)
+     */
+    void load(const std::string& path);
+
+    /**
+     * @brief Starts loading `path` in the background.
+     *
+     * @return false if another load is still running
+     */
+    bool load_async(const std::string& path);
+
+    /**
+     * @brief Blocks until no background load is running.
+     */
+    void wait_for_load();
+
+    /**
+     * @brief The active model, or nullptr if none is loaded.
+     */
+    std::shared_ptr<LoadedModel> current() const;
+
+    /**
+     * @brief The model for a new request: marks activity and reloads an idle-unloaded model.
+     *
+     * @return nullptr if no model was ever loaded
+     * @throws std::runtime_error If reloading an unloaded model fails
+     */
+    std::shared_ptr<LoadedModel> acquire();
+
+    /**
+     * @brief True if a model is loaded or was unloaded while idle and can be reloaded.
+     */
+    bool available() const;
+
+    /**
+     * @brief Starts, changes or (with a default policy) stops idle unloading.
+     */
+    void set_idle_policy(const IdlePolicy& policy);
+
+    /**
+     * @brief Applies residency settings to the active model and to models loaded later.
+     */
+    json configure_memory(const ResidencyConfig& config);
+
+    std::string last_error() const;
+
+    /**
+     * @brief {"path", "fingerprint", "loading", "swaps", "draining", "last_error", "idle"}.
+     *
+     * `draining` counts replaced models still held by in-flight requests;
+     * `idle` has the seconds since the last request, whether the model is
+     * unloaded, and the unload, trim and reload counters.
+     */
+    json status() const;
+
+private:
+    void install(std::shared_ptr<LoadedModel> model);
+    void idle_loop();
+    void check_idle();
+    void stop_idle();
+
+    ModelLoadConfig config_;
+    std::optional<ResidencyConfig> residency_;
+    std::shared_ptr<LoadedModel> current_;
+    std::vector<std::weak_ptr<LoadedModel>> retired_;
+    std::thread loader_;
+    bool loading_ = false;
+    std::string loading_path_;
+    std::string last_error_;
+    uint64_t swaps_ = 0;
+    mutable std::mutex mutex_;
+
+    // Idle policy; unloaded_path_/unloaded_fingerprint_ are the warm metadata of an unloaded model
+    IdlePolicy idle_policy_;
+    std::chrono::steady_clock::time_point last_used_ = std::chrono::steady_clock::now();
+    std::string unloaded_path_;
+    std::string unloaded_fingerprint_;
+    uint64_t idle_unloads_ = 0;
+    uint64_t idle_trims_ = 0;
+    uint64_t reloads_ = 0;
+    double last_reload_seconds_ = 0.0;
+    std::mutex reload_mutex_;
+    std::thread idle_thread_;
+    bool stop_idle_ = false;
+    std::condition_variable idle_wake_;
+};
+
+} // namespace EMPI
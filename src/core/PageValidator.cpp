@@ -0,0 +1,429 @@
+/**
+ * @file PageValidator.cpp
+ * @brief In-process WCAG checks for generated pages
+ */
+
+#include "PageValidator.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace EMPI {
+
+namespace {
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+struct Tag {
+    std::string name;
+    bool closing = false;
+    std::unordered_map<std::string, std::string> attrs;
+    size_t end = 0;  ///< Position after '>'
+
+    bool has(const std::string& attr) const { return attrs.count(attr) > 0; }
+    std::string get(const std::string& attr) const {
+        auto it = attrs.find(attr);
+        return it == attrs.end() ? "" : it->second;
+    }
+};
+
+bool is_name_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == ':';
+}
+
+/**
+ * @brief Parses the tag starting at html[pos] == '<'; nullopt if it never closes.
+ */
+std::optional<Tag> read_tag(const std::string& html, size_t pos) {
+    Tag tag;
+    size_t i = pos + 1;
+    if (i < html.size() && html[i] == '/') {
+        tag.closing = true;
+        i++;
+    }
+    size_t name_begin = i;
+    while (i < html.size() && is_name_char(html[i])) i++;
+    tag.name = lowercase(html.substr(name_begin, i - name_begin));
+
+    while (i < html.size()) {
+        while (i < html.size() && (std::isspace(static_cast<unsigned char>(html[i])) || html[i] == '/')) i++;
+        if (i >= html.size()) return std::nullopt;
+        if (html[i] == '>') {
+            tag.end = i + 1;
+            return tag;
+        }
+
+        size_t attr_begin = i;
+        while (i < html.size() && !std::isspace(static_cast<unsigned char>(html[i])) &&
+               html[i] != '=' && html[i] != '>' && html[i] != '/') {
+            i++;
+        }
+        std::string attr = lowercase(html.substr(attr_begin, i - attr_begin));
+        std::string value;
+        if (i < html.size() && html[i] == '=') {
+            i++;
+            if (i < html.size() && (html[i] == '"' || html[i] == '\'')) {
+                char quote = html[i++];
+                size_t close = html.find(quote, i);
+                if (close == std::string::npos) return std::nullopt;
+                value = html.substr(i, close - i);
+                i = close + 1;
+            } else {
+                size_t value_begin = i;
+                while (i < html.size() && !std::isspace(static_cast<unsigned char>(html[i])) && html[i] != '>') i++;
+                value = html.substr(value_begin, i - value_begin);
+            }
+        }
+        if (!attr.empty()) tag.attrs[attr] = value;
+        else i++;
+    }
+    return std::nullopt;
+}
+
+struct Declaration {
+    std::string property;
+    std::string value;
+};
+
+std::vector<Declaration> parse_declarations(const std::string& block) {
+    std::vector<Declaration> out;
+    size_t start = 0;
+    while (start < block.size()) {
+        size_t end = block.find(';', start);
+        if (end == std::string::npos) end = block.size();
+        std::string decl = block.substr(start, end - start);
+        size_t colon = decl.find(':');
+        if (colon != std::string::npos) {
+            std::string value = lowercase(trim(decl.substr(colon + 1)));
+            size_t important = value.find("!important");
+            if (important != std::string::npos) value = trim(value.substr(0, important));
+            out.push_back({lowercase(trim(decl.substr(0, colon))), value});
+        }
+        start = end + 1;
+    }
+    return out;
+}
+
+std::optional<std::string> color_token(const std::string& value) {
+    std::string first = value.substr(0, value.find(' '));
+    if (first == "white") return std::string("#ffffff");
+    if (first == "black") return std::string("#000000");
+    if (!first.empty() && first[0] == '#') return first;
+    return std::nullopt;
+}
+
+/**
+ * @brief Style state collected from <style> blocks and style attributes.
+ */
+struct StyleScan {
+    std::optional<std::string> body_color;
+    std::optional<std::string> body_background;
+    bool outline_suppressed = false;
+    bool focus_outline = false;
+    std::vector<double> small_font_px;
+
+    void apply(const std::string& selectors, const std::string& block) {
+        std::string lower_selectors = lowercase(selectors);
+        bool is_body = false;
+        size_t start = 0;
+        while (start <= lower_selectors.size()) {
+            size_t end = lower_selectors.find(',', start);
+            if (end == std::string::npos) end = lower_selectors.size();
+            if (trim(lower_selectors.substr(start, end - start)) == "body") is_body = true;
+            start = end + 1;
+        }
+        bool is_focus = lower_selectors.find(":focus") != std::string::npos;
+
+        for (const auto& decl : parse_declarations(block)) {
+            if (is_body && decl.property == "color") {
+                if (auto c = color_token(decl.value)) body_color = c;
+            } else if (is_body && (decl.property == "background" || decl.property == "background-color")) {
+                if (auto c = color_token(decl.value)) body_background = c;
+            } else if (decl.property == "outline") {
+                bool none = decl.value == "none" || decl.value == "0" || decl.value.rfind("0 ", 0) == 0;
+                if (is_focus && !none) focus_outline = true;
+                if (none) outline_suppressed = true;
+            } else if (decl.property == "font-size" && decl.value.size() > 2 &&
+                       decl.value.compare(decl.value.size() - 2, 2, "px") == 0) {
+                try {
+                    double px = std::stod(decl.value);
+                    if (px < 12.0) small_font_px.push_back(px);
+                } catch (...) {
+                }
+            }
+        }
+    }
+
+    void scan_stylesheet(const std::string& css) {
+        size_t pos = 0;
+        while (pos < css.size()) {
+            size_t close = css.find('}', pos);
+            if (close == std::string::npos) close = css.size();
+            std::string rule = css.substr(pos, close - pos);
+            // The innermost '{' separates selectors from declarations (handles @media nesting)
+            size_t open = rule.rfind('{');
+            if (open != std::string::npos) {
+                std::string selectors = rule.substr(0, open);
+                size_t outer = selectors.rfind('{');
+                if (outer != std::string::npos) selectors = selectors.substr(outer + 1);
+                apply(selectors, rule.substr(open + 1));
+            }
+            pos = close + 1;
+        }
+    }
+};
+
+const std::unordered_set<std::string> kAriaRoles = {
+    "alert", "alertdialog", "application", "article", "banner", "button", "cell", "checkbox",
+    "columnheader", "combobox", "complementary", "contentinfo", "definition", "dialog", "directory",
+    "document", "feed", "figure", "form", "grid", "gridcell", "group", "heading", "img", "link",
+    "list", "listbox", "listitem", "log", "main", "marquee", "math", "menu", "menubar", "menuitem",
+    "menuitemcheckbox", "menuitemradio", "navigation", "none", "note", "option", "presentation",
+    "progressbar", "radio", "radiogroup", "region", "row", "rowgroup", "rowheader", "scrollbar",
+    "search", "searchbox", "separator", "slider", "spinbutton", "status", "switch", "tab", "table",
+    "tablist", "tabpanel", "term", "textbox", "timer", "toolbar", "tooltip", "tree", "treegrid",
+    "treeitem"
+};
+
+const std::unordered_set<std::string> kGenericLinkText = {"click here", "read more", "more", "link", "here"};
+
+double channel(int value) {
+    double c = value / 255.0;
+    return c <= 0.03928 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+std::optional<double> luminance(const std::string& color) {
+    if (color.empty() || color[0] != '#') return std::nullopt;
+    std::string hex = color.substr(1);
+    if (hex.size() == 3) {
+        hex = std::string{hex[0], hex[0], hex[1], hex[1], hex[2], hex[2]};
+    }
+    if (hex.size() != 6 || !std::all_of(hex.begin(), hex.end(),
+                                        [](unsigned char c) { return std::isxdigit(c); })) {
+        return std::nullopt;
+    }
+    int r = std::stoi(hex.substr(0, 2), nullptr, 16);
+    int g = std::stoi(hex.substr(2, 2), nullptr, 16);
+    int b = std::stoi(hex.substr(4, 2), nullptr, 16);
+    return 0.2126 * channel(r) + 0.7152 * channel(g) + 0.0722 * channel(b);
+}
+
+} // namespace
+
+size_t PageValidation::count(IssueSeverity severity) const {
+    return static_cast<size_t>(std::count_if(issues.begin(), issues.end(),
+        [severity](const ValidationIssue& issue) { return issue.severity == severity; }));
+}
+
+double contrast_ratio(const std::string& foreground, const std::string& background) {
+    auto fg = luminance(foreground);
+    auto bg = luminance(background);
+    if (!fg || !bg) return 0.0;
+    double lighter = std::max(*fg, *bg);
+    double darker = std::min(*fg, *bg);
+    return (lighter + 0.05) / (darker + 0.05);
+}
+
+PageValidation validate_page(const std::string& html) {
+    PageValidation result;
+    auto report = [&result](const char* criterion, const char* level, IssueSeverity severity, std::string description) {
+        result.issues.push_back({criterion, level, severity, std::move(description)});
+        if (severity == IssueSeverity::Error) result.valid = false;
+    };
+
+    std::string lower = lowercase(html);
+    StyleScan style;
+    std::unordered_set<std::string> ids;
+    std::unordered_set<std::string> label_targets;
+    std::vector<std::string> inputs_by_id;
+    std::vector<int> headings;
+    bool saw_html_close = false;
+    int label_depth = 0;
+
+    bool in_link = false;
+    bool link_has_img = false;
+    std::string link_text;
+
+    size_t pos = 0;
+    while (pos < html.size()) {
+        size_t lt = html.find('<', pos);
+        if (in_link) link_text += html.substr(pos, lt == std::string::npos ? std::string::npos : lt - pos);
+        if (lt == std::string::npos) break;
+
+        if (lower.compare(lt, 4, "<!--") == 0) {
+            size_t end = lower.find("-->", lt + 4);
+            pos = end == std::string::npos ? html.size() : end + 3;
+            continue;
+        }
+        if (lt + 1 < html.size() && (html[lt + 1] == '!' || html[lt + 1] == '?')) {
+            size_t end = html.find('>', lt);
+            pos = end == std::string::npos ? html.size() : end + 1;
+            continue;
+        }
+        if (lt + 1 >= html.size() || !(std::isalpha(static_cast<unsigned char>(html[lt + 1])) || html[lt + 1] == '/')) {
+            if (in_link) link_text += '<';
+            pos = lt + 1;
+            continue;
+        }
+
+        auto tag = read_tag(html, lt);
+        if (!tag) break;
+        pos = tag->end;
+        const std::string& name = tag->name;
+
+        if (tag->closing) {
+            if (name == "html") saw_html_close = true;
+            if (name == "label" && label_depth > 0) label_depth--;
+            if (name == "a" && in_link) {
+                std::string text = lowercase(trim(link_text));
+                if (text.empty() && !link_has_img) {
+                    report("2.4.4", "A", IssueSeverity::Error, "Empty link without text content");
+                } else if (kGenericLinkText.count(text)) {
+                    report("2.4.4", "A", IssueSeverity::Warning, "Generic link text: \"" + text + "\"");
+                }
+                in_link = false;
+            }
+            continue;
+        }
+
+        if (name == "style" || name == "script") {
+            size_t close = lower.find("</" + name, pos);
+            size_t content_end = close == std::string::npos ? html.size() : close;
+            if (name == "style") style.scan_stylesheet(html.substr(pos, content_end - pos));
+            if (close == std::string::npos) {
+                pos = html.size();
+            } else {
+                size_t gt = html.find('>', close);
+                pos = gt == std::string::npos ? html.size() : gt + 1;
+            }
+            continue;
+        }
+
+        if (tag->has("id")) {
+            std::string id = tag->get("id");
+            if (!ids.insert(id).second) {
+                report("4.1.1", "A", IssueSeverity::Error, "Duplicate ID: " + id);
+            }
+        }
+        if (tag->has("style")) {
+            style.apply(name, tag->get("style"));
+        }
+        if (tag->has("role")) {
+            std::string role = lowercase(trim(tag->get("role")));
+            if (!kAriaRoles.count(role)) {
+                report("4.1.2", "A", IssueSeverity::Warning, "Potentially invalid ARIA role: \"" + role + "\"");
+            }
+        }
+
+        if (name == "html") {
+            if (!tag->has("lang")) {
+                report("3.1.1", "A", IssueSeverity::Warning, "Missing lang attribute in <html> tag");
+            }
+        } else if (name == "img") {
+            if (in_link) link_has_img = true;
+            if (!tag->has("alt")) {
+                report("1.1.1", "A", IssueSeverity::Error, "Image missing alt text");
+            }
+        } else if (name.size() == 2 && name[0] == 'h' && name[1] >= '1' && name[1] <= '6') {
+            headings.push_back(name[1] - '0');
+        } else if (name == "a") {
+            in_link = true;
+            link_has_img = false;
+            link_text.clear();
+        } else if (name == "label") {
+            label_depth++;
+            if (tag->has("for")) label_targets.insert(tag->get("for"));
+        } else if (name == "input" || name == "select" || name == "textarea") {
+            std::string type = lowercase(tag->get("type"));
+            bool needs_label = !(type == "hidden" || type == "submit" || type == "button" ||
+                                 type == "reset" || type == "image");
+            bool labeled = label_depth > 0 || tag->has("aria-label") || tag->has("aria-labelledby");
+            if (needs_label && !labeled) {
+                if (tag->has("id")) {
+                    inputs_by_id.push_back(tag->get("id"));
+                } else {
+                    report("3.3.2", "A", IssueSeverity::Warning, "Form input without label or ARIA label");
+                }
+            }
+            if (name == "select" && lowercase(tag->get("onchange")).find("submit") != std::string::npos) {
+                report("3.2.2", "A", IssueSeverity::Warning, "Select element submits the form on change");
+            }
+        }
+    }
+
+    for (const auto& id : inputs_by_id) {
+        if (!label_targets.count(id)) {
+            report("3.3.2", "A", IssueSeverity::Warning, "Form input without associated label: " + id);
+        }
+    }
+
+    for (size_t i = 1; i < headings.size(); ++i) {
+        if (headings[i] - headings[i - 1] > 1) {
+            report("1.3.1", "A", IssueSeverity::Warning,
+                   "Skipped heading level: from h" + std::to_string(headings[i - 1]) +
+                   " to h" + std::to_string(headings[i]));
+        }
+    }
+    auto h1_count = std::count(headings.begin(), headings.end(), 1);
+    if (h1_count > 1) {
+        report("1.3.1", "A", IssueSeverity::Warning, "Multiple h1 headings found (" + std::to_string(h1_count) + ")");
+    }
+
+    std::string text_color = style.body_color.value_or("#000000");
+    std::string background = style.body_background.value_or("#ffffff");
+    double ratio = contrast_ratio(text_color, background);
+    if (ratio > 0.0 && ratio < 4.5) {
+        report("1.4.3", "AA", IssueSeverity::Error,
+               "Body text contrast " + std::to_string(ratio).substr(0, 4) + ":1 is below 4.5:1");
+    }
+    for (double px : style.small_font_px) {
+        report("1.4.3", "AA", IssueSeverity::Warning,
+               "Very small text (" + std::to_string(static_cast<int>(px)) + "px) may affect readability");
+    }
+
+    if (style.outline_suppressed && !style.focus_outline) {
+        report("2.4.7", "AA", IssueSeverity::Warning, "Focus outline removed without a visible :focus style");
+    }
+
+    if (!saw_html_close) {
+        report("4.1.1", "A", IssueSeverity::Error, "Document is truncated (missing </html>)");
+    }
+    return result;
+}
+
+void to_json(json& j, const ValidationIssue& issue) {
+    const char* type = "error";
+    if (issue.severity == IssueSeverity::Warning) type = "warning";
+    if (issue.severity == IssueSeverity::Info) type = "info";
+    j = {
+        {"criterion", issue.criterion},
+        {"level", issue.level},
+        {"type", type},
+        {"description", issue.description}
+    };
+}
+
+void to_json(json& j, const PageValidation& validation) {
+    j = {
+        {"valid", validation.valid},
+        {"errors", validation.count(IssueSeverity::Error)},
+        {"warnings", validation.count(IssueSeverity::Warning)},
+        {"issues", validation.issues}
+    };
+}
+
+} // namespace EMPI
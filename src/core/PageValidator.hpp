@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+enum class IssueSeverity { Error, Warning, Info };
+
+/**
+ * @struct ValidationIssue
+ * @brief A single finding, tagged with its WCAG 2.1 success criterion.
+ */
+struct ValidationIssue {
+    std::string criterion;   ///< e.g. "1.1.1"
+    std::string level;       ///< "A" or "AA"
+    IssueSeverity severity = IssueSeverity::Error;
+    std::string description;
+};
+
+/**
+ * @struct PageValidation
+ * @brief Result of validating a generated page.
+ */
+struct PageValidation {
+    /// True when no issue has IssueSeverity::Error.
+    bool valid = true;
+    std::vector<ValidationIssue> issues;
+
+    size_t count(IssueSeverity severity) const;
+};
+
+/**
+ * @brief Validates a page in-process against the README's WCAG criteria.
+ *
+ * A single-pass tag scanner mirrors tests/test_accesibility.js without a DOM
+ * or network access, so it is cheap enough to run on every generated page.
+ * Errors (which make the page invalid):
+ *   - 1.1.1 image without alt
+ *   - 1.4.3 body text/background contrast below 4.5:1 (declared hex colors)
+ *   - 2.4.4 link without text or image
+ *   - 4.1.1 duplicate id, or a truncated document (missing `</html>`)
+ * Warnings cover skipped heading levels, multiple h1, small text, generic
+ * link text, suppressed focus outlines, unlabeled inputs, select elements
+ * that submit on change and unknown ARIA roles.
+ */
+PageValidation validate_page(const std::string& html);
+
+/**
+ * @brief WCAG contrast ratio of two "#rgb"/"#rrggbb" colors; 0 if either is not parseable.
+ */
+double contrast_ratio(const std::string& foreground, const std::string& background);
+
+void to_json(json& j, const ValidationIssue& issue);
+void to_json(json& j, const PageValidation& validation);
+
+} // namespace EMPI
@@ -0,0 +1,34 @@
+/**
+ * @file Payloads.cpp
+ * @brief JSON conversions for typed EMPI payloads
+ */
+
+#include "Payloads.hpp"
+
+namespace EMPI {
+
+void to_json(json& j, const TextMetricsData& data) {
+    payload_codec::fields_to_json(j, data);
+}
+
+void from_json(const json& j, TextMetricsData& data) {
+    payload_codec::fields_from_json(j, data);
+}
+
+void to_json(json& j, const FeedbackAnalysisData& data) {
+    payload_codec::fields_to_json(j, data);
+}
+
+void from_json(const json& j, FeedbackAnalysisData& data) {
+    payload_codec::fields_from_json(j, data);
+}
+
+void to_json(json& j, const HTMLGenerationData& data) {
+    payload_codec::fields_to_json(j, data);
+}
+
+void from_json(const json& j, HTMLGenerationData& data) {
+    payload_codec::fields_from_json(j, data);
+}
+
+} // namespace EMPI
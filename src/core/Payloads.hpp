@@ -0,0 +1,403 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct TextMetricsData
+ * @brief Typed `metrics` payload produced by TextAnalyzer (task_type="text_metrics").
+ *
+ * Field names match the keys emitted by integrations/text_analyzer.py.
+ * Metrics are optional because the Python side drops groups whose
+ * dependencies (textstat, spaCy) are missing. Keys that are not modelled
+ * here (e.g. "metadata") are preserved in `extra`.
+ */
+struct TextMetricsData {
+    // Readability (textstat)
+    std::optional<double> flesch_kincaid_grade;
+    std::optional<double> flesch_reading_ease;
+    std::optional<double> gunning_fog_index;
+    std::optional<double> smog_index;
+    std::optional<double> automated_readability_index;
+    std::optional<double> coleman_liau_index;
+    std::optional<double> dale_chall_score;
+    std::optional<double> linsear_write_score;
+    std::optional<int64_t> difficult_word_count;
+    std::optional<std::string> text_standard;
+
+    // Basic statistics
+    std::optional<int64_t> character_count;
+    std::optional<int64_t> letter_count;
+    std::optional<int64_t> syllable_count;
+    std::optional<int64_t> word_count;
+    std::optional<int64_t> sentence_count;
+    std::optional<int64_t> polysyllable_count;
+
+    // Structure
+    std::optional<int64_t> paragraph_count;
+    std::optional<double> paragraph_sentence_ratio;
+    std::optional<bool> has_headings;
+    std::optional<bool> has_lists;
+    std::optional<int64_t> list_item_count;
+    std::optional<double> average_paragraph_length_words;
+
+    // Lexical diversity
+    std::optional<double> type_token_ratio;
+    std::optional<int64_t> unique_word_count;
+    std::optional<double> unique_word_ratio;
+    std::optional<double> lexical_diversity_score;
+
+    // Autism support metrics (spaCy)
+    std::optional<double> pronoun_density;
+    std::optional<double> determiner_density;
+    std::optional<double> anaphora_density;
+    std::optional<int64_t> content_token_count;
+
+    json extra = json::object();
+
+    template <typename Self, typename Visitor>
+    static void visit_fields(Self& self, Visitor&& v) {
+        v("flesch_kincaid_grade", self.flesch_kincaid_grade);
+        v("flesch_reading_ease", self.flesch_reading_ease);
+        v("gunning_fog_index", self.gunning_fog_index);
+        v("smog_index", self.smog_index);
+        v("automated_readability_index", self.automated_readability_index);
+        v("coleman_liau_index", self.coleman_liau_index);
+        v("dale_chall_score", self.dale_chall_score);
+        v("linsear_write_score", self.linsear_write_score);
+        v("difficult_word_count", self.difficult_word_count);
+        v("text_standard", self.text_standard);
+        v("character_count", self.character_count);
+        v("letter_count", self.letter_count);
+        v("syllable_count", self.syllable_count);
+        v("word_count", self.word_count);
+        v("sentence_count", self.sentence_count);
+        v("polysyllable_count", self.polysyllable_count);
+        v("paragraph_count", self.paragraph_count);
+        v("paragraph_sentence_ratio", self.paragraph_sentence_ratio);
+        v("has_headings", self.has_headings);
+        v("has_lists", self.has_lists);
+        v("list_item_count", self.list_item_count);
+        v("average_paragraph_length_words", self.average_paragraph_length_words);
+        v("type_token_ratio", self.type_token_ratio);
+        v("unique_word_count", self.unique_word_count);
+        v("unique_word_ratio", self.unique_word_ratio);
+        v("lexical_diversity_score", self.lexical_diversity_score);
+        v("pronoun_density", self.pronoun_density);
+        v("determiner_density", self.determiner_density);
+        v("anaphora_density", self.anaphora_density);
+        v("content_token_count", self.content_token_count);
+    }
+};
+
+/**
+ * @struct FeedbackAnalysisData
+ * @brief Typed `analysis` payload produced by FeedbackAgent (task_type="feedback_analysis").
+ *
+ * The LLM does not always respect the requested schema, so values of an
+ * unexpected type fall back to the field default and are kept verbatim in
+ * `extra` for inspection; serialization emits the typed value.
+ */
+struct FeedbackAnalysisData {
+    std::string sentiment = "neutral";
+    std::vector<std::string> topics;
+    double satisfaction_score = 0.5;
+    std::vector<std::string> complaints;
+    std::string feedback_summary;
+
+    json extra = json::object();
+
+    template <typename Self, typename Visitor>
+    static void visit_fields(Self& self, Visitor&& v) {
+        v("sentiment", self.sentiment);
+        v("topics", self.topics);
+        v("satisfaction_score", self.satisfaction_score);
+        v("complaints", self.complaints);
+        v("feedback_summary", self.feedback_summary);
+    }
+};
+
+/**
+ * @struct HTMLGenerationData
+ * @brief Typed result of InterfaceGenerator (task_type="html_generation").
+ */
+struct HTMLGenerationData {
+    std::string html;
+    int64_t html_size = 0;
+
+    json extra = json::object();
+
+    template <typename Self, typename Visitor>
+    static void visit_fields(Self& self, Visitor&& v) {
+        v("html", self.html);
+        v("html_size", self.html_size);
+    }
+};
+
+void to_json(json& j, const TextMetricsData& data);
+void from_json(const json& j, TextMetricsData& data);
+void to_json(json& j, const FeedbackAnalysisData& data);
+void from_json(const json& j, FeedbackAnalysisData& data);
+void to_json(json& j, const HTMLGenerationData& data);
+void from_json(const json& j, HTMLGenerationData& data);
+
+namespace payload_codec {
+
+/**
+ * @brief Appends fields in a compact little-endian layout.
+ *
+ * Layout is positional (no field names): payloads are decoded with the
+ * same visit_fields() list they were encoded with.
+ */
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string& out) : out_(out) {}
+
+    void write(bool value) { out_.push_back(value ? '\1' : '\0'); }
+    void write(int64_t value) { write_raw(&value, sizeof(value)); }
+    void write(double value) { write_raw(&value, sizeof(value)); }
+
+    void write(const std::string& value) {
+        write_size(value.size());
+        out_.append(value);
+    }
+
+    void write(const std::vector<std::string>& values) {
+        write_size(values.size());
+        for (const auto& value : values) write(value);
+    }
+
+    void write(const json& value) {
+        auto bytes = json::to_msgpack(value);
+        write_size(bytes.size());
+        out_.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    template <typename T>
+    void write(const std::optional<T>& value) {
+        write(value.has_value());
+        if (value) write(*value);
+    }
+
+    void write_size(uint64_t size) { write_raw(&size, sizeof(size)); }
+
+private:
+    void write_raw(const void* data, size_t size) {
+        // Hosts we deploy on are little-endian; the raw copy is the wire format.
+        out_.append(static_cast<const char*>(data), size);
+    }
+
+    std::string& out_;
+};
+
+/**
+ * @brief Reads fields written by BinaryWriter; throws std::runtime_error on truncated input.
+ */
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    void read(bool& value) { value = take(1)[0] != '\0'; }
+    void read(int64_t& value) { std::memcpy(&value, take(sizeof(value)), sizeof(value)); }
+    void read(double& value) { std::memcpy(&value, take(sizeof(value)), sizeof(value)); }
+
+    void read(std::string& value) {
+        size_t n = read_size();
+        value.assign(take(n), n);
+    }
+
+    void read(std::vector<std::string>& values) {
+        size_t n = read_size();
+        values.clear();
+        values.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            std::string value;
+            read(value);
+            values.push_back(std::move(value));
+        }
+    }
+
+    void read(json& value) {
+        size_t n = read_size();
+        const auto* bytes = reinterpret_cast<const uint8_t*>(take(n));
+        value = json::from_msgpack(bytes, bytes + n);
+    }
+
+    template <typename T>
+    void read(std::optional<T>& value) {
+        bool present = false;
+        read(present);
+        if (present) {
+            T inner{};
+            read(inner);
+            value = std::move(inner);
+        } else {
+            value.reset();
+        }
+    }
+
+    size_t read_size() {
+        uint64_t size = 0;
+        std::memcpy(&size, take(sizeof(size)), sizeof(size));
+        if (size > size_ - pos_) {
+            throw std::runtime_error("Binary payload length exceeds buffer");
+        }
+        return static_cast<size_t>(size);
+    }
+
+    bool at_end() const { return pos_ == size_; }
+
+private:
+    const char* take(size_t n) {
+        if (n > size_ - pos_) {
+            throw std::runtime_error("Binary payload truncated");
+        }
+        const char* p = data_ + pos_;
+        pos_ += n;
+        return p;
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+template <typename T>
+struct is_optional : std::false_type {};
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+/**
+ * @brief Converts a JSON value into a field, tolerating loose LLM output.
+ *
+ * Arrays of non-strings are stringified element-wise. Returns false when the
+ * value cannot be represented by the field type.
+ */
+template <typename T>
+bool assign_field(const json& value, T& field) {
+    if constexpr (is_optional<T>::value) {
+        if (value.is_null()) {
+            field.reset();
+            return true;
+        }
+        typename T::value_type inner{};
+        if (!assign_field(value, inner)) return false;
+        field = std::move(inner);
+        return true;
+    } else if constexpr (std::is_same_v<T, std::vector<std::string>>) {
+        if (!value.is_array()) return false;
+        field.clear();
+        for (const auto& item : value) {
+            field.push_back(item.is_string() ? item.get<std::string>() : item.dump());
+        }
+        return true;
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        if (!value.is_string()) return false;
+        field = value.get<std::string>();
+        return true;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        if (!value.is_boolean()) return false;
+        field = value.get<bool>();
+        return true;
+    } else {
+        if (!value.is_number()) return false;
+        field = value.get<T>();
+        return true;
+    }
+}
+
+template <typename T>
+void fields_to_json(json& j, const T& data) {
+    j = data.extra.is_object() ? data.extra : json::object();
+    T::visit_fields(data, [&j](const char* name, const auto& field) {
+        using F = std::decay_t<decltype(field)>;
+        if constexpr (is_optional<F>::value) {
+            if (field) j[name] = *field;
+        } else {
+            j[name] = field;
+        }
+    });
+}
+
+template <typename T>
+void fields_from_json(const json& j, T& data) {
+    if (j.is_null()) {
+        data = T{};
+        return;
+    }
+    if (!j.is_object()) {
+        throw std::invalid_argument("Payload must be a JSON object");
+    }
+    data = T{};
+    json extra = j;
+    T::visit_fields(data, [&j, &extra](const char* name, auto& field) {
+        auto it = j.find(name);
+        if (it == j.end()) return;
+        if (assign_field(*it, field)) {
+            extra.erase(name);
+        }
+    });
+    data.extra = std::move(extra);
+}
+
+constexpr uint8_t kBinaryVersion = 1;
+
+template <typename T>
+std::string fields_to_binary(const T& data) {
+    std::string out;
+    out.push_back(static_cast<char>(kBinaryVersion));
+    BinaryWriter writer(out);
+    T::visit_fields(data, [&writer](const char*, const auto& field) { writer.write(field); });
+    writer.write(data.extra);
+    return out;
+}
+
+template <typename T>
+T fields_from_binary(const std::string& bytes) {
+    if (bytes.empty() || static_cast<uint8_t>(bytes[0]) != kBinaryVersion) {
+        throw std::runtime_error("Unsupported binary payload version");
+    }
+    T data;
+    BinaryReader reader(bytes.data() + 1, bytes.size() - 1);
+    T::visit_fields(data, [&reader](const char*, auto& field) { reader.read(field); });
+    reader.read(data.extra);
+    if (!reader.at_end()) {
+        throw std::runtime_error("Trailing bytes after binary payload");
+    }
+    return data;
+}
+
+} // namespace payload_codec
+
+/**
+ * @brief Serializes a typed payload into the compact binary form.
+ *
+ * Use at process boundaries (caches, capture logs, IPC); JSON remains the
+ * EMPI wire format.
+ */
+template <typename T>
+std::string to_binary(const T& data) {
+    return payload_codec::fields_to_binary(data);
+}
+
+/**
+ * @brief Deserializes a typed payload written by to_binary().
+ *
+ * @throws std::runtime_error On version mismatch or malformed input.
+ */
+template <typename T>
+T from_binary(const std::string& bytes) {
+    return payload_codec::fields_from_binary<T>(bytes);
+}
+
+} // namespace EMPI
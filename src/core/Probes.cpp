@@ -0,0 +1,41 @@
+/**
+ * @file Probes.cpp
+ * @brief Request ids and USDT probe semaphores
+ */
+
+#include "Probes.hpp"
+#include <atomic>
+
+#ifdef EMPI_USDT_ACTIVE
+// Tracers increment a probe's semaphore while attached (see EMPI_PROBE_ENABLED)
+#define EMPI_DEFINE_PROBE_SEMAPHORE(name) \
+    extern "C" { unsigned short empi_##name##_semaphore __attribute__((unused, section(".probes"))) = 0; }
+EMPI_PROBE_LIST(EMPI_DEFINE_PROBE_SEMAPHORE)
+#undef EMPI_DEFINE_PROBE_SEMAPHORE
+#endif
+
+namespace EMPI {
+
+namespace {
+
+std::atomic<uint64_t> next_request_id{1};
+thread_local uint64_t thread_request_id = 0;
+
+} // namespace
+
+uint64_t current_request_id() {
+    return thread_request_id;
+}
+
+ProbeRequestScope::ProbeRequestScope()
+    : id_(next_request_id.fetch_add(1, std::memory_order_relaxed))
+    , previous_(thread_request_id)
+{
+    thread_request_id = id_;
+}
+
+ProbeRequestScope::~ProbeRequestScope() {
+    thread_request_id = previous_;
+}
+
+} // namespace EMPI
@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file Probes.hpp
+ * @brief USDT (SystemTap SDT) probes for production tracing.
+ *
+ * Probes live under the "empi" provider and are compiled in when
+ * EMPI_ENABLE_USDT is defined and <sys/sdt.h> is available. An unattached
+ * probe is a single nop; arguments that are expensive to compute (payload
+ * sizes) are guarded by EMPI_PROBE_ENABLED, which reads the probe's
+ * semaphore and is only non-zero while a tracer is attached.
+ *
+ * Probe                 Arguments
+ *   request__start      request_id, agent_id (char*), task_type (char*), input bytes
+ *   request__end        request_id, status (0 ok, 1 error, 2 no handler), output bytes
+ *   phi__start/end      request_id
+ *   psi__start/end      request_id
+ *   python__dispatch    request_id, input bytes (text bytes for a fork-server call)
+ *   python__return      request_id, exit code (-1: fork-server call failed, retried one-shot)
+ *   prefill__start/end  request_id, prompt tokens
+ *   decode__step        request_id, step, token
+ *
+ * See tools/bpftrace/ for latency breakdown scripts.
+ */
+
+#include <cstdint>
+
+#if defined(EMPI_ENABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define EMPI_USDT_ACTIVE 1
+#endif
+#endif
+
+#define EMPI_PROBE_LIST(X) \
+    X(request__start)      \
+    X(request__end)        \
+    X(phi__start)          \
+    X(phi__end)            \
+    X(psi__start)          \
+    X(psi__end)            \
+    X(python__dispatch)    \
+    X(python__return)      \
+    X(prefill__start)      \
+    X(prefill__end)        \
+    X(decode__step)
+
+#ifdef EMPI_USDT_ACTIVE
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define EMPI_DECLARE_PROBE_SEMAPHORE(name) extern "C" unsigned short empi_##name##_semaphore;
+EMPI_PROBE_LIST(EMPI_DECLARE_PROBE_SEMAPHORE)
+#undef EMPI_DECLARE_PROBE_SEMAPHORE
+
+#define EMPI_PROBE_ENABLED(name) __builtin_expect(empi_##name##_semaphore != 0, 0)
+#define EMPI_PROBE1(name, a1) DTRACE_PROBE1(empi, name, a1)
+#define EMPI_PROBE2(name, a1, a2) DTRACE_PROBE2(empi, name, a1, a2)
+#define EMPI_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(empi, name, a1, a2, a3)
+#define EMPI_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(empi, name, a1, a2, a3, a4)
+
+#else
+
+// sizeof keeps the arguments unevaluated but referenced
+#define EMPI_PROBE_ENABLED(name) false
+#define EMPI_PROBE1(name, a1) ((void)sizeof(a1))
+#define EMPI_PROBE2(name, a1, a2) ((void)sizeof(a1), (void)sizeof(a2))
+#define EMPI_PROBE3(name, a1, a2, a3) ((void)sizeof(a1), (void)sizeof(a2), (void)sizeof(a3))
+#define EMPI_PROBE4(name, a1, a2, a3, a4) ((void)sizeof(a1), (void)sizeof(a2), (void)sizeof(a3), (void)sizeof(a4))
+
+#endif
+
+namespace EMPI {
+
+/**
+ * @brief Id of the request being processed on this thread (0 outside a request).
+ *
+ * Lets deep call sites (Python dispatch, decode loops) tag probes without
+ * threading the id through every signature.
+ */
+uint64_t current_request_id();
+
+/**
+ * @class ProbeRequestScope
+ * @brief Assigns a process-unique request id for the lifetime of the scope.
+ *
+ * Restores the enclosing id on exit, so an agent calling another agent keeps
+ * its own id afterwards.
+ */
+class ProbeRequestScope {
+public:
+    ProbeRequestScope();
+    ~ProbeRequestScope();
+
+    ProbeRequestScope(const ProbeRequestScope&) = delete;
+    ProbeRequestScope& operator=(const ProbeRequestScope&) = delete;
+
+    uint64_t id() const { return id_; }
+
+private:
+    uint64_t id_;
+    uint64_t previous_;
+};
+
+} // namespace EMPI
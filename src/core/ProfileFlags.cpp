@@ -0,0 +1,216 @@
+/**
+ * @file ProfileFlags.cpp
+ * @brief Derivation and serialization of compact user profiles
+ */
+
+#include "ProfileFlags.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace EMPI {
+
+namespace {
+
+const char* const kNeedNames[kNeedCount] = {
+    "adhd", "dyslexia", "asd", "low_vision", "epilepsy", "anxiety", "child", "senior"
+};
+
+struct NeedKeywords {
+    Need need;
+    std::vector<const char*> stems;
+};
+
+// Stems are matched at word starts, so "autis" covers "autism" and "autistic".
+const std::vector<NeedKeywords> kNeedKeywords = {
+    {Need::ADHD,      {"adhd", "attention deficit", "hyperactiv"}},
+    {Need::Dyslexia,  {"dyslexi", "opendyslexic"}},
+    {Need::ASD,       {"autis", "asd", "asperger", "on the spectrum", "on the autism spectrum"}},
+    {Need::LowVision, {"low vision", "vision issue", "visually impaired", "visual impairment",
+                       "magnification", "partially sighted"}},
+    {Need::Epilepsy,  {"epilep", "seizure", "photosensitiv"}},
+    {Need::Anxiety,   {"anxiety", "anxious", "panic", "stressed"}},
+    {Need::Child,     {"child", "kids", "my son", "my daughter", "elementary school", "primary school"}},
+    {Need::Senior,    {"senior", "elderly", "older adult", "retired", "grandparent", "grandmother",
+                       "grandfather", "grandma", "grandpa", "aging eyes"}}
+};
+
+const std::vector<const char*> kLargerText = {
+    "larger font", "larger text", "large text", "large font", "bigger font", "bigger text",
+    "increase font", "increase text", "make text larger", "font size", "small text"
+};
+const std::vector<const char*> kHighContrast = {"high contrast", "increase contrast", "good contrast"};
+const std::vector<const char*> kLowContrast = {"low-contrast", "low contrast", "not bright white",
+                                               "reduce blue light"};
+const std::vector<const char*> kShortText = {
+    "short paragraph", "shorter", "bullet point", "concise", "small chunks", "scannable",
+    "short text", "keep text short", "long paragraphs", "long texts"
+};
+const std::vector<const char*> kMinimalText = {
+    "one thing at a time", "only what's essential", "too much information", "broken down"
+};
+const std::vector<const char*> kPlainLanguage = {
+    "simple language", "simple sentences", "simpler words", "plain english", "plain language",
+    "literal language", "no metaphors", "no idioms", "avoid jargon"
+};
+const std::vector<const char*> kReduceMotion = {
+    "flashing", "animation", "blink", "flicker", "moving elements", "transitions", "auto-playing"
+};
+const std::vector<const char*> kCalmColors = {
+    "calm colors", "muted colors", "avoid bright", "calm"
+};
+
+bool is_word_char(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) != 0;
+}
+
+bool contains_term(const std::string& haystack, const char* term) {
+    std::string needle(term);
+    size_t pos = haystack.find(needle);
+    while (pos != std::string::npos) {
+        if (pos == 0 || !is_word_char(haystack[pos - 1])) {
+            return true;
+        }
+        pos = haystack.find(needle, pos + 1);
+    }
+    return false;
+}
+
+bool contains_any(const std::string& haystack, const std::vector<const char*>& terms) {
+    return std::any_of(terms.begin(), terms.end(),
+                       [&haystack](const char* term) { return contains_term(haystack, term); });
+}
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+} // namespace
+
+const char* need_name(Need need) {
+    auto index = static_cast<size_t>(need);
+    return index < kNeedCount ? kNeedNames[index] : "unknown";
+}
+
+uint32_t ProfileFlags::key() const {
+    return static_cast<uint32_t>(needs)
+         | (static_cast<uint32_t>(font_scale & 0x3u) << 8)
+         | (static_cast<uint32_t>(static_cast<uint8_t>(contrast) & 0x3u) << 10)
+         | (static_cast<uint32_t>(density & 0x3u) << 12)
+         | (static_cast<uint32_t>(plain_language) << 14)
+         | (static_cast<uint32_t>(reduce_motion) << 15)
+         | (static_cast<uint32_t>(calm_colors) << 16);
+}
+
+ProfileFlags ProfileFlags::from_key(uint32_t key) {
+    ProfileFlags flags;
+    flags.needs = static_cast<uint8_t>(key & 0xFFu);
+    flags.font_scale = static_cast<uint8_t>((key >> 8) & 0x3u);
+    flags.contrast = static_cast<Contrast>((key >> 10) & 0x3u);
+    flags.density = static_cast<uint8_t>((key >> 12) & 0x3u);
+    flags.plain_language = (key >> 14) & 1u;
+    flags.reduce_motion = (key >> 15) & 1u;
+    flags.calm_colors = (key >> 16) & 1u;
+    return flags;
+}
+
+std::vector<std::string> ProfileFlags::need_names() const {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < kNeedCount; ++i) {
+        if (has(static_cast<Need>(i))) {
+            names.emplace_back(kNeedNames[i]);
+        }
+    }
+    return names;
+}
+
+ProfileFlags implied_profile(uint8_t needs) {
+    ProfileFlags flags;
+    flags.needs = needs;
+    if (flags.has(Need::LowVision)) {
+        flags.font_scale = 2;
+        flags.contrast = Contrast::High;
+    }
+    if (flags.has(Need::Senior)) flags.font_scale = std::max<uint8_t>(flags.font_scale, 1);
+    if (flags.has(Need::ADHD)) flags.density = 1;
+    if (flags.has(Need::ASD) || flags.has(Need::Child)) flags.plain_language = true;
+    if (flags.has(Need::Epilepsy)) flags.reduce_motion = true;
+    if (flags.has(Need::Anxiety)) flags.calm_colors = true;
+    return flags;
+}
+
+ProfileFlags derive_profile_flags(const json& dialog_history, const FeedbackAnalysisData& analysis) {
+    // Only the user's own words describe their needs; assistant turns often
+    // echo every option and would produce false positives.
+    std::string corpus;
+    if (dialog_history.is_array()) {
+        for (const auto& msg : dialog_history) {
+            if (msg.is_object() && msg.value("role", "") == "user") {
+                corpus += msg.value("content", "");
+                corpus += '\n';
+            }
+        }
+    }
+    for (const auto& topic : analysis.topics) corpus += topic + '\n';
+    for (const auto& complaint : analysis.complaints) corpus += complaint + '\n';
+    corpus += analysis.feedback_summary;
+    corpus = lowercase(std::move(corpus));
+
+    uint8_t needs = 0;
+    for (const auto& entry : kNeedKeywords) {
+        if (contains_any(corpus, entry.stems)) {
+            needs |= static_cast<uint8_t>(1u << static_cast<uint8_t>(entry.need));
+        }
+    }
+
+    ProfileFlags flags = implied_profile(needs);
+
+    // Explicit preferences
+    if (contains_any(corpus, kLargerText)) {
+        flags.font_scale = static_cast<uint8_t>(std::min(flags.font_scale + 1, 3));
+    }
+    if (contains_any(corpus, kHighContrast)) {
+        flags.contrast = Contrast::High;
+    } else if (contains_any(corpus, kLowContrast)) {
+        flags.contrast = Contrast::Low;
+    }
+    if (contains_any(corpus, kMinimalText)) {
+        flags.density = 2;
+    } else if (contains_any(corpus, kShortText)) {
+        flags.density = std::max<uint8_t>(flags.density, 1);
+    }
+    if (contains_any(corpus, kPlainLanguage)) flags.plain_language = true;
+    if (contains_any(corpus, kReduceMotion)) flags.reduce_motion = true;
+    if (contains_any(corpus, kCalmColors)) flags.calm_colors = true;
+
+    return flags;
+}
+
+void to_json(json& j, const ProfileFlags& flags) {
+    const char* contrast = "normal";
+    if (flags.contrast == Contrast::High) contrast = "high";
+    if (flags.contrast == Contrast::Low) contrast = "low";
+
+    j = {
+        {"key", flags.key()},
+        {"needs", flags.need_names()},
+        {"font_scale", flags.font_scale},
+        {"contrast", contrast},
+        {"density", flags.density},
+        {"plain_language", flags.plain_language},
+        {"reduce_motion", flags.reduce_motion},
+        {"calm_colors", flags.calm_colors}
+    };
+}
+
+void from_json(const json& j, ProfileFlags& flags) {
+    // The packed key is authoritative; the expanded fields are for readers.
+    if (j.is_number_unsigned() || j.is_number_integer()) {
+        flags = ProfileFlags::from_key(j.get<uint32_t>());
+    } else {
+        flags = ProfileFlags::from_key(j.at("key").get<uint32_t>());
+    }
+}
+
+} // namespace EMPI
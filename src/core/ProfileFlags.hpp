@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Payloads.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @enum Need
+ * @brief Accessibility needs recognised in user dialogs (bit index in ProfileFlags::needs).
+ */
+enum class Need : uint8_t {
+    ADHD = 0,
+    Dyslexia,
+    ASD,
+    LowVision,
+    Epilepsy,
+    Anxiety,
+    Child,
+    Senior,
+    Count
+};
+
+constexpr size_t kNeedCount = static_cast<size_t>(Need::Count);
+
+/**
+ * @brief Lowercase identifier of a need ("adhd", "low_vision", ...).
+ */
+const char* need_name(Need need);
+
+enum class Contrast : uint8_t { Normal = 0, High = 1, Low = 2 };
+
+/**
+ * @struct ProfileFlags
+ * @brief Normalized, fixed-size user profile derived from feedback analysis.
+ *
+ * The free-form analysis json is expensive to compare and hash. ProfileFlags
+ * reduces it to a need bitset plus quantized presentation preferences that
+ * pack into a single 32-bit key, so equality and hashing are O(1).
+ *
+ * Key layout (LSB first):
+ *   bits 0-7   needs bitset (Need)
+ *   bits 8-9   font_scale (0 = default .. 3 = largest)
+ *   bits 10-11 contrast (Contrast)
+ *   bits 12-13 density (0 = normal, 1 = short paragraphs, 2 = one idea per screen)
+ *   bit  14    plain_language
+ *   bit  15    reduce_motion
+ *   bit  16    calm_colors
+ */
+struct ProfileFlags {
+    uint8_t needs = 0;
+    uint8_t font_scale = 0;
+    Contrast contrast = Contrast::Normal;
+    uint8_t density = 0;
+    bool plain_language = false;
+    bool reduce_motion = false;
+    bool calm_colors = false;
+
+    bool has(Need need) const { return (needs >> static_cast<uint8_t>(need)) & 1u; }
+    void set(Need need) { needs |= static_cast<uint8_t>(1u << static_cast<uint8_t>(need)); }
+
+    /**
+     * @brief Packs the profile into its 32-bit key.
+     */
+    uint32_t key() const;
+
+    /**
+     * @brief Rebuilds a profile from a key produced by key().
+     */
+    static ProfileFlags from_key(uint32_t key);
+
+    /**
+     * @brief Names of the set needs, in Need order.
+     */
+    std::vector<std::string> need_names() const;
+
+    bool operator==(const ProfileFlags& other) const { return key() == other.key(); }
+    bool operator!=(const ProfileFlags& other) const { return key() != other.key(); }
+};
+
+/**
+ * @brief Profile holding only the preferences a need set implies.
+ *
+ * E.g. low vision implies font_scale 2 and high contrast, epilepsy implies
+ * reduce_motion. Explicit preferences from the dialog are layered on top.
+ */
+ProfileFlags implied_profile(uint8_t needs);
+
+/**
+ * @brief Derives normalized flags from a dialog and its LLM analysis.
+ *
+ * User messages, topics, complaints and the summary are matched against a
+ * keyword table; preferences implied by a need (e.g. low vision -> large,
+ * high-contrast text) are filled in so that differently worded dialogs
+ * describing the same needs map to the same key.
+ *
+ * @param dialog_history Array of {"role", "content"} messages (may be empty)
+ * @param analysis FeedbackAgent analysis of the dialog
+ */
+ProfileFlags derive_profile_flags(const json& dialog_history, const FeedbackAnalysisData& analysis);
+
+void to_json(json& j, const ProfileFlags& flags);
+void from_json(const json& j, ProfileFlags& flags);
+
+} // namespace EMPI
+
+namespace std {
+template <>
+struct hash<EMPI::ProfileFlags> {
+    size_t operator()(const EMPI::ProfileFlags& flags) const noexcept {
+        return std::hash<uint32_t>{}(flags.key());
+    }
+};
+} // namespace std
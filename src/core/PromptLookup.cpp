@@ -0,0 +1,71 @@
+/**
+ * @file PromptLookup.cpp
+ * @brief N-gram index for prompt-lookup speculative decoding
+ */
+
+#include "PromptLookup.hpp"
+#include <algorithm>
+
+namespace EMPI {
+
+void to_json(json& j, const SpeculationStats& stats) {
+    j = {
+        {"drafted", stats.drafted},
+        {"accepted", stats.accepted},
+        {"acceptance_rate", stats.acceptance_rate()},
+        {"decode_calls", stats.decode_calls}
+    };
+}
+
+PromptLookup::PromptLookup(PromptLookupConfig config)
+    : config_(config)
+{
+    config_.min_ngram = std::max<size_t>(1, config_.min_ngram);
+    config_.max_ngram = std::max(config_.min_ngram, config_.max_ngram);
+    indexes_.resize(config_.max_ngram - config_.min_ngram + 1);
+}
+
+uint64_t PromptLookup::ngram_key(size_t end, size_t n) const {
+    uint64_t key = 14695981039346656037ull;
+    for (size_t i = end - n; i < end; ++i) {
+        key ^= static_cast<uint32_t>(history_[i]);
+        key *= 1099511628211ull;
+        key ^= key >> 29;
+    }
+    return key;
+}
+
+void PromptLookup::index_before(size_t end) {
+    // Registers the n-grams ending at `end`; their continuation starts at history_[end]
+    for (size_t n = config_.min_ngram; n <= config_.max_ngram && n <= end; ++n) {
+        indexes_[n - config_.min_ngram][ngram_key(end, n)] = end;
+    }
+}
+
+void PromptLookup::reset(const std::vector<int32_t>& prompt) {
+    history_.clear();
+    for (auto& index : indexes_) index.clear();
+    history_.reserve(prompt.size() + 512);
+    for (int32_t token : prompt) push(token);
+}
+
+void PromptLookup::push(int32_t token) {
+    history_.push_back(token);
+    index_before(history_.size() - 1);
+}
+
+std::vector<int32_t> PromptLookup::draft() const {
+    size_t length = history_.size();
+    for (size_t n = std::min(config_.max_ngram, length); n >= config_.min_ngram; --n) {
+        const auto& index = indexes_[n - config_.min_ngram];
+        auto it = index.find(ngram_key(length, n));
+        if (it == index.end()) continue;
+
+        size_t begin = it->second;
+        size_t end = std::min(length, begin + config_.max_draft);
+        return std::vector<int32_t>(history_.begin() + begin, history_.begin() + end);
+    }
+    return {};
+}
+
+} // namespace EMPI
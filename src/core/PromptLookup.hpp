@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct PromptLookupConfig
+ * @brief N-gram sizes and draft length for prompt-lookup speculation.
+ */
+struct PromptLookupConfig {
+    size_t min_ngram = 2;
+    size_t max_ngram = 4;
+    /// Longest continuation proposed per step
+    size_t max_draft = 8;
+};
+
+/**
+ * @struct SpeculationStats
+ * @brief Draft/acceptance counters of one generation.
+ */
+struct SpeculationStats {
+    uint64_t drafted = 0;
+    uint64_t accepted = 0;
+    /// Batched decode calls after prefill (one per emitted token without speculation)
+    uint64_t decode_calls = 0;
+
+    double acceptance_rate() const {
+        return drafted ? static_cast<double>(accepted) / static_cast<double>(drafted) : 0.0;
+    }
+};
+
+void to_json(json& j, const SpeculationStats& stats);
+
+/**
+ * @class PromptLookup
+ * @brief Draft-free speculation: proposes continuations copied from earlier context.
+ *
+ * Keeps the token history (prompt + generated) and, per n-gram size, an
+ * index from n-gram to the position after its most recent occurrence. The
+ * draft for the next step is what followed the latest earlier occurrence of
+ * the longest matching suffix n-gram. Adapted text copies terms and clauses
+ * of the source, so these drafts are often accepted verbatim.
+ *
+ * Tokens are plain int32_t (llama_token) to keep this independent of llama.cpp.
+ */
+class PromptLookup {
+public:
+    explicit PromptLookup(PromptLookupConfig config = {});
+
+    /**
+     * @brief Starts a new sequence with the given prompt tokens.
+     */
+    void reset(const std::vector<int32_t>& prompt);
+
+    /**
+     * @brief Appends an accepted token.
+     */
+    void push(int32_t token);
+
+    /**
+     * @brief Proposed continuation of the current history (may be empty).
+     */
+    std::vector<int32_t> draft() const;
+
+    size_t size() const { return history_.size(); }
+
+private:
+    uint64_t ngram_key(size_t end, size_t n) const;
+    void index_before(size_t end);
+
+    PromptLookupConfig config_;
+    std::vector<int32_t> history_;
+    /// indexes_[n - min_ngram]: key of n-gram ending at e -> e (a continuation exists at e)
+    std::vector<std::unordered_map<uint64_t, size_t>> indexes_;
+};
+
+} // namespace EMPI
@@ -0,0 +1,119 @@
+/**
+ * @file RequestCost.cpp
+ * @brief Thread-local request cost scopes
+ */
+
+#include "RequestCost.hpp"
+#include <chrono>
+#include <ctime>
+
+namespace EMPI {
+
+namespace {
+
+thread_local RequestCostScope* thread_scope = nullptr;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t to_us(double ms) {
+    return ms > 0.0 ? static_cast<uint64_t>(ms * 1000.0) : 0;
+}
+
+} // namespace
+
+void to_json(json& j, const RequestCost& cost) {
+    j = {
+        {"wall_ms", cost.wall_ms},
+        {"cpu_ms", cost.cpu_ms},
+        {"prompt_tokens", cost.prompt_tokens},
+        {"generated_tokens", cost.generated_tokens},
+        {"cache_hits", cost.cache_hits},
+        {"python_ms", cost.python_ms},
+        {"queue_wait_ms", cost.queue_wait_ms}
+    };
+}
+
+double thread_cpu_ms() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    }
+#endif
+    return 0.0;
+}
+
+RequestCostScope::RequestCostScope()
+    : start_ns_(now_ns())
+    , start_cpu_ms_(thread_cpu_ms())
+    , previous_(thread_scope)
+{
+    thread_scope = this;
+}
+
+RequestCostScope::~RequestCostScope() {
+    thread_scope = previous_;
+    if (previous_) {
+        previous_->prompt_tokens_ += prompt_tokens_;
+        previous_->generated_tokens_ += generated_tokens_;
+        previous_->cache_hits_ += cache_hits_;
+        previous_->python_us_ += python_us_;
+        previous_->queue_wait_us_ += queue_wait_us_;
+    }
+}
+
+RequestCost RequestCostScope::snapshot() const {
+    RequestCost cost;
+    cost.wall_ms = (now_ns() - start_ns_) / 1e6;
+    cost.cpu_ms = thread_cpu_ms() - start_cpu_ms_;
+    cost.prompt_tokens = prompt_tokens_;
+    cost.generated_tokens = generated_tokens_;
+    cost.cache_hits = cache_hits_;
+    cost.python_ms = python_us_ / 1e3;
+    cost.queue_wait_ms = queue_wait_us_ / 1e3;
+    return cost;
+}
+
+RequestCostBinding::RequestCostBinding(RequestCostScope* scope)
+    : previous_(thread_scope)
+{
+    thread_scope = scope;
+}
+
+RequestCostBinding::~RequestCostBinding() {
+    thread_scope = previous_;
+}
+
+RequestCostScope* current_request_cost() {
+    return thread_scope;
+}
+
+void record_tokens(uint64_t prompt_tokens, uint64_t generated_tokens) {
+    if (thread_scope) {
+        thread_scope->prompt_tokens_ += prompt_tokens;
+        thread_scope->generated_tokens_ += generated_tokens;
+    }
+}
+
+void record_cache_hit() {
+    if (thread_scope) {
+        thread_scope->cache_hits_++;
+    }
+}
+
+void record_python_ms(double ms) {
+    if (thread_scope) {
+        thread_scope->python_us_ += to_us(ms);
+    }
+}
+
+void record_queue_wait_ms(double ms) {
+    if (thread_scope) {
+        thread_scope->queue_wait_us_ += to_us(ms);
+    }
+}
+
+} // namespace EMPI
@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file RequestCost.hpp
+ * @brief Per-request CPU time, token and wait accounting.
+ *
+ * UniversalAgent::process_raw opens a RequestCostScope around each request
+ * and writes its totals to `payload.metadata.cost`. Code deep in a request
+ * (decode loops, caches, the Python bridge, the context pool) adds to the
+ * current scope through the record_* functions, which do nothing outside a
+ * request. Worker threads started by a request join its scope with a
+ * RequestCostBinding.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct RequestCost
+ * @brief What one request consumed; the "cost" object of the response metadata.
+ */
+struct RequestCost {
+    double wall_ms = 0.0;
+    /// CPU time of the request thread (CLOCK_THREAD_CPUTIME_ID); worker threads are not included
+    double cpu_ms = 0.0;
+    uint64_t prompt_tokens = 0;
+    uint64_t generated_tokens = 0;
+    uint64_t cache_hits = 0;
+    /// Wall time spent in Python subprocesses, summed over parallel workers
+    double python_ms = 0.0;
+    /// Time spent waiting for a free llama context, fork-server worker or CPU cores
+    double queue_wait_ms = 0.0;
+};
+
+void to_json(json& j, const RequestCost& cost);
+
+/**
+ * @brief CPU time consumed by the calling thread so far, in milliseconds.
+ */
+double thread_cpu_ms();
+
+/**
+ * @class RequestCostScope
+ * @brief Collects the cost of the request running on this thread.
+ *
+ * Scopes nest like ProbeRequestScope: an agent calling another agent gets
+ * the inner request's cost in its response, and the inner counters are also
+ * added to the outer request when the inner scope closes. Wall and CPU time
+ * are measured by each scope itself, so they are not added twice.
+ */
+class RequestCostScope {
+public:
+    RequestCostScope();
+    ~RequestCostScope();
+
+    RequestCostScope(const RequestCostScope&) = delete;
+    RequestCostScope& operator=(const RequestCostScope&) = delete;
+
+    /**
+     * @brief The cost so far, with wall and CPU time measured up to now.
+     */
+    RequestCost snapshot() const;
+
+private:
+    friend class RequestCostBinding;
+    friend void record_tokens(uint64_t, uint64_t);
+    friend void record_cache_hit();
+    friend void record_python_ms(double);
+    friend void record_queue_wait_ms(double);
+
+    // Updated from worker threads, hence atomic; times are kept in microseconds
+    std::atomic<uint64_t> prompt_tokens_{0};
+    std::atomic<uint64_t> generated_tokens_{0};
+    std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> python_us_{0};
+    std::atomic<uint64_t> queue_wait_us_{0};
+
+    int64_t start_ns_;
+    double start_cpu_ms_;
+    RequestCostScope* previous_;
+};
+
+/**
+ * @class RequestCostBinding
+ * @brief Makes a worker thread record into the scope of the request that started it.
+ *
+ * Construct it at the top of the worker with the value of
+ * current_request_cost() taken on the request thread.
+ */
+class RequestCostBinding {
+public:
+    explicit RequestCostBinding(RequestCostScope* scope);
+    ~RequestCostBinding();
+
+    RequestCostBinding(const RequestCostBinding&) = delete;
+    RequestCostBinding& operator=(const RequestCostBinding&) = delete;
+
+private:
+    RequestCostScope* previous_;
+};
+
+/**
+ * @brief Scope of the request on this thread, or nullptr outside a request.
+ */
+RequestCostScope* current_request_cost();
+
+void record_tokens(uint64_t prompt_tokens, uint64_t generated_tokens);
+void record_cache_hit();
+void record_python_ms(double ms);
+void record_queue_wait_ms(double ms);
+
+} // namespace EMPI
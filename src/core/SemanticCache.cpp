@@ -0,0 +1,224 @@
+/**
+ * @file SemanticCache.cpp
+ * @brief Exact and nearest-profile page cache
+ */
+
+#include "SemanticCache.hpp"
+#include <cmath>
+#include <limits>
+
+namespace EMPI {
+
+namespace {
+
+float l1_distance(const float* a, const float* b) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < SemanticCache::kDims; ++i) {
+        sum += std::fabs(a[i] - b[i]);
+    }
+    return sum;
+}
+
+} // namespace
+
+SemanticCache::SemanticCache(SemanticCacheConfig config)
+    : config_(config)
+{
+}
+
+SemanticCache::Embedding SemanticCache::profile_embedding(const ProfileFlags& profile) {
+    Embedding e{};
+    for (size_t i = 0; i < kNeedCount; ++i) {
+        e[i] = profile.has(static_cast<Need>(i)) ? 4.0f : 0.0f;
+    }
+    e[8] = static_cast<float>(profile.font_scale);
+    e[9] = profile.contrast == Contrast::High ? 1.0f : 0.0f;
+    e[10] = profile.contrast == Contrast::Low ? 1.0f : 0.0f;
+    e[11] = static_cast<float>(profile.density);
+    e[12] = profile.plain_language ? 1.0f : 0.0f;
+    e[13] = profile.reduce_motion ? 4.0f : 0.0f;
+    e[14] = profile.calm_colors ? 1.0f : 0.0f;
+    return e;
+}
+
+uint64_t SemanticCache::hash_text(const std::string& text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::optional<SemanticCache::Hit> SemanticCache::lookup(uint64_t text_hash, const ProfileFlags& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!config_.enabled) {
+        return std::nullopt;
+    }
+    lookups_++;
+
+    auto bucket_it = buckets_.find(text_hash);
+    if (bucket_it == buckets_.end()) {
+        record_nearest(std::nullopt);
+        return std::nullopt;
+    }
+    Bucket& bucket = bucket_it->second;
+
+    uint32_t key = profile.key();
+    Embedding query = profile_embedding(profile);
+    size_t best = bucket.entries.size();
+    float best_distance = std::numeric_limits<float>::max();
+
+    for (size_t i = 0; i < bucket.entries.size(); ++i) {
+        if (bucket.entries[i].profile_key == key) {
+            best = i;
+            best_distance = 0.0f;
+            break;
+        }
+        float d = l1_distance(query.data(), bucket.rows.data() + i * kDims);
+        if (d < best_distance) {
+            best_distance = d;
+            best = i;
+        }
+    }
+
+    record_nearest(best < bucket.entries.size() ? std::optional<float>(best_distance) : std::nullopt);
+    if (best == bucket.entries.size() || best_distance > config_.max_distance) {
+        return std::nullopt;
+    }
+
+    Entry& entry = bucket.entries[best];
+    entry.last_used = ++clock_;
+
+    Hit hit;
+    hit.value = entry.value;
+    hit.distance = best_distance;
+    hit.profile = ProfileFlags::from_key(entry.profile_key);
+    if (entry.profile_key == key) {
+        hit.tier = Tier::Exact;
+        exact_hits_++;
+    } else {
+        hit.tier = Tier::Approximate;
+        approximate_hits_++;
+    }
+    return hit;
+}
+
+void SemanticCache::insert(uint64_t text_hash, const ProfileFlags& profile, std::string value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!config_.enabled || config_.max_entries == 0) {
+        return;
+    }
+
+    uint32_t key = profile.key();
+    auto existing = buckets_.find(text_hash);
+    if (existing != buckets_.end()) {
+        for (auto& entry : existing->second.entries) {
+            if (entry.profile_key == key) {
+                entry.value = std::move(value);
+                entry.last_used = ++clock_;
+                return;
+            }
+        }
+    }
+
+    if (entry_count_ >= config_.max_entries) {
+        evict_one();
+    }
+
+    Bucket& bucket = buckets_[text_hash];
+    Embedding row = profile_embedding(profile);
+    bucket.rows.insert(bucket.rows.end(), row.begin(), row.end());
+    bucket.entries.push_back(Entry{key, ++clock_, std::move(value)});
+    entry_count_++;
+}
+
+void SemanticCache::evict_one() {
+    auto victim_bucket = buckets_.end();
+    size_t victim_index = 0;
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+
+    for (auto it = buckets_.begin(); it != buckets_.end(); ++it) {
+        for (size_t i = 0; i < it->second.entries.size(); ++i) {
+            if (it->second.entries[i].last_used < oldest) {
+                oldest = it->second.entries[i].last_used;
+                victim_bucket = it;
+                victim_index = i;
+            }
+        }
+    }
+    if (victim_bucket == buckets_.end()) {
+        return;
+    }
+
+    Bucket& bucket = victim_bucket->second;
+    bucket.entries.erase(bucket.entries.begin() + victim_index);
+    bucket.rows.erase(bucket.rows.begin() + victim_index * kDims,
+                      bucket.rows.begin() + (victim_index + 1) * kDims);
+    entry_count_--;
+    if (bucket.entries.empty()) {
+        buckets_.erase(victim_bucket);
+    }
+}
+
+void SemanticCache::record_nearest(std::optional<float> distance) {
+    if (!distance) {
+        return;
+    }
+    auto index = static_cast<size_t>(std::lround(*distance));
+    if (index >= kHistogramSize) {
+        index = kHistogramSize - 1;
+    }
+    nearest_histogram_[index]++;
+}
+
+void SemanticCache::configure(const SemanticCacheConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    while (entry_count_ > config_.max_entries) {
+        evict_one();
+    }
+}
+
+SemanticCacheConfig SemanticCache::config() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+}
+
+void SemanticCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buckets_.clear();
+    entry_count_ = 0;
+}
+
+json SemanticCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto rate = [this](uint64_t hits) {
+        return lookups_ ? static_cast<double>(hits) / static_cast<double>(lookups_) : 0.0;
+    };
+
+    json by_threshold = json::object();
+    uint64_t cumulative = 0;
+    for (size_t d = 0; d + 1 < kHistogramSize; ++d) {
+        cumulative += nearest_histogram_[d];
+        if (d == 0 || d == 1 || d == 2 || d == 4 || d == 8 || d == 16) {
+            by_threshold[std::to_string(d)] = rate(cumulative);
+        }
+    }
+
+    uint64_t hits = exact_hits_ + approximate_hits_;
+    return {
+        {"enabled", config_.enabled},
+        {"max_distance", config_.max_distance},
+        {"entries", entry_count_},
+        {"lookups", lookups_},
+        {"exact_hits", exact_hits_},
+        {"approximate_hits", approximate_hits_},
+        {"misses", lookups_ - hits},
+        {"hit_rate", rate(hits)},
+        {"hit_rate_by_threshold", by_threshold}
+    };
+}
+
+} // namespace EMPI
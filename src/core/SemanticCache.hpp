@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ProfileFlags.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct SemanticCacheConfig
+ * @brief Tuning knobs for SemanticCache.
+ */
+struct SemanticCacheConfig {
+    bool enabled = true;
+    /// Maximum profile distance for an approximate hit; 0 disables the approximate tier.
+    float max_distance = 1.0f;
+    /// Total entries across all texts before least-recently-used eviction.
+    size_t max_entries = 4096;
+};
+
+/**
+ * @class SemanticCache
+ * @brief Two-tier page cache keyed by text hash and user profile.
+ *
+ * Tier 1 is an exact match on (text hash, ProfileFlags key). Tier 2 scans
+ * the profile embeddings stored for the same text and returns the nearest
+ * page when it lies within `max_distance`. Embeddings are small fixed-width
+ * rows kept contiguous per text, so the flat scan is cheap and vectorizable.
+ *
+ * Distances are integral by construction (see profile_embedding()), which
+ * lets stats() report the exact hit rate that any other threshold would
+ * have produced on the same traffic.
+ *
+ * Thread-safe.
+ */
+class SemanticCache {
+public:
+    static constexpr size_t kDims = 16;
+    using Embedding = std::array<float, kDims>;
+
+    enum class Tier { Miss, Exact, Approximate };
+
+    struct Hit {
+        std::string value;
+        Tier tier = Tier::Miss;
+        float distance = 0.0f;
+        /// Profile the cached value was stored for; differs from the query on an approximate hit
+        ProfileFlags profile;
+    };
+
+    explicit SemanticCache(SemanticCacheConfig config = {});
+
+    /**
+     * @brief Maps a profile to its embedding.
+     *
+     * Weights: a differing need costs 4, reduce_motion (seizure safety) costs 4,
+     * every other preference step costs 1. With the default max_distance of 1
+     * only a single preference step is tolerated.
+     */
+    static Embedding profile_embedding(const ProfileFlags& profile);
+
+    /**
+     * @brief 64-bit FNV-1a hash used for text keys.
+     */
+    static uint64_t hash_text(const std::string& text);
+
+    std::optional<Hit> lookup(uint64_t text_hash, const ProfileFlags& profile);
+    void insert(uint64_t text_hash, const ProfileFlags& profile, std::string value);
+
+    void configure(const SemanticCacheConfig& config);
+    SemanticCacheConfig config() const;
+    void clear();
+
+    /**
+     * @brief Hit/miss counters plus hit rate at alternative distance thresholds.
+     */
+    json stats() const;
+
+private:
+    struct Entry {
+        uint32_t profile_key;
+        uint64_t last_used;
+        std::string value;
+    };
+
+    struct Bucket {
+        std::vector<float> rows;   // entries.size() * kDims, row-major
+        std::vector<Entry> entries;
+    };
+
+    void evict_one();
+    void record_nearest(std::optional<float> distance);
+
+    static constexpr size_t kHistogramSize = 33;
+
+    mutable std::mutex mutex_;
+    SemanticCacheConfig config_;
+    std::unordered_map<uint64_t, Bucket> buckets_;
+    size_t entry_count_ = 0;
+    uint64_t clock_ = 0;
+
+    uint64_t lookups_ = 0;
+    uint64_t exact_hits_ = 0;
+    uint64_t approximate_hits_ = 0;
+    // nearest_histogram_[d] counts lookups whose nearest entry was at distance d
+    // (last bucket: d >= kHistogramSize - 1); lookups with no candidate are not counted.
+    std::array<uint64_t, kHistogramSize> nearest_histogram_{};
+};
+
+} // namespace EMPI
@@ -0,0 +1,301 @@
+/**
+ * @file TextAggregates.cpp
+ * @brief Merge and finalize steps of chunked text analysis
+ */
+
+#include "TextAggregates.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace EMPI {
+
+namespace {
+
+void add_optional(std::optional<int64_t>& sum, const std::optional<int64_t>& value) {
+    if (value) sum = sum.value_or(0) + *value;
+}
+
+template <typename T>
+void read_optional(const json& j, const char* key, std::optional<T>& field) {
+    auto it = j.find(key);
+    if (it != j.end() && it->is_number()) field = it->get<T>();
+}
+
+/**
+ * @brief textstat's _legacy_round: halves away from zero.
+ */
+double legacy_round(double number, int points = 0) {
+    double p = std::pow(10.0, points);
+    return std::floor(number * p + std::copysign(0.5, number)) / p;
+}
+
+/// Python's `%`, which is never negative for a positive divisor
+int py_mod(int value, int divisor) {
+    return ((value % divisor) + divisor) % divisor;
+}
+
+std::string grade_suffix(int grade) {
+    int last_two = py_mod(grade, 100);
+    if (last_two >= 11 && last_two <= 13) return "th";
+    switch (py_mod(grade, 10)) {
+        case 1: return "st";
+        case 2: return "nd";
+        case 3: return "rd";
+        default: return "th";
+    }
+}
+
+/**
+ * @brief Grades textstat.text_standard() derives from a Flesch Reading Ease score.
+ */
+std::vector<int> reading_ease_grades(double score) {
+    if (score < 100 && score >= 90) return {5};
+    if (score < 90 && score >= 80) return {6};
+    if (score < 80 && score >= 70) return {7};
+    if (score < 70 && score >= 60) return {8, 9};
+    if (score < 60 && score >= 50) return {10};
+    if (score < 50 && score >= 40) return {11};
+    if (score < 40 && score >= 30) return {12};
+    return {13};
+}
+
+/**
+ * @brief textstat.text_standard(): the most common of the rounded and ceiled grades, first one on ties.
+ */
+std::string text_standard(double flesch_kincaid, double reading_ease, const std::vector<double>& grades) {
+    std::vector<int> votes = {static_cast<int>(legacy_round(flesch_kincaid)),
+                              static_cast<int>(std::ceil(flesch_kincaid))};
+    for (int grade : reading_ease_grades(reading_ease)) votes.push_back(grade);
+    for (double grade : grades) {
+        votes.push_back(static_cast<int>(legacy_round(grade)));
+        votes.push_back(static_cast<int>(std::ceil(grade)));
+    }
+
+    std::vector<std::pair<int, int>> counts;
+    for (int grade : votes) {
+        auto it = std::find_if(counts.begin(), counts.end(), [grade](const auto& c) { return c.first == grade; });
+        if (it == counts.end()) {
+            counts.push_back({grade, 1});
+        } else {
+            it->second++;
+        }
+    }
+    auto best = counts.front();
+    for (const auto& count : counts) {
+        if (count.second > best.second) best = count;
+    }
+    int lower = best.first - 1;
+    int upper = lower + 1;
+    return std::to_string(lower) + grade_suffix(lower) + " and " +
+           std::to_string(upper) + grade_suffix(upper) + " grade";
+}
+
+} // namespace
+
+void TextAggregates::merge(const TextAggregates& next) {
+    if (chunks == 0) {
+        linsear_write_score = next.linsear_write_score;
+    }
+    chunks += next.chunks;
+
+    character_count += next.character_count;
+    add_optional(letter_count, next.letter_count);
+    add_optional(syllable_count, next.syllable_count);
+    word_count += next.word_count;
+    sentence_count += next.sentence_count;
+    add_optional(polysyllable_count, next.polysyllable_count);
+    if (next.difficult_words) {
+        if (!difficult_words) difficult_words.emplace();
+        difficult_words->insert(next.difficult_words->begin(), next.difficult_words->end());
+    }
+
+    words.insert(words.end(), next.words.begin(), next.words.end());
+    sentence_lengths.insert(sentence_lengths.end(), next.sentence_lengths.begin(), next.sentence_lengths.end());
+    paragraph_count += next.paragraph_count;
+    list_item_count += next.list_item_count;
+    has_headings = has_headings || next.has_headings;
+    has_lists = has_lists || next.has_lists;
+
+    add_optional(pronoun_count, next.pronoun_count);
+    add_optional(determiner_count, next.determiner_count);
+    add_optional(anaphora_count, next.anaphora_count);
+    add_optional(content_token_count, next.content_token_count);
+    add_optional(spacy_sentence_count, next.spacy_sentence_count);
+}
+
+TextMetricsData TextAggregates::finalize() const {
+    TextMetricsData metrics;
+
+    metrics.character_count = character_count;
+    metrics.letter_count = letter_count;
+    metrics.syllable_count = syllable_count;
+    metrics.word_count = word_count;
+    metrics.polysyllable_count = polysyllable_count;
+
+    // textstat's formulas and rounding on whole-document counts; without textstat the count is a plain split
+    bool textstat = syllable_count.has_value();
+    int64_t sentences = textstat ? std::max<int64_t>(1, sentence_count) : sentence_count;
+    metrics.sentence_count = sentences;
+
+    if (textstat && letter_count && polysyllable_count && word_count > 0) {
+        double words_n = static_cast<double>(word_count);
+        double sentences_n = static_cast<double>(sentences);
+        double asl = legacy_round(words_n / sentences_n, 1);
+        double asw = legacy_round(static_cast<double>(*syllable_count) / words_n, 1);
+
+        double fkg = legacy_round(0.39 * asl + 11.8 * asw - 15.59, 1);
+        double fre = legacy_round(206.835 - 1.015 * asl - 84.6 * asw, 2);
+        double smog = sentences >= 3
+            ? legacy_round(1.043 * std::pow(30.0 * (static_cast<double>(*polysyllable_count) / sentences_n), 0.5) +
+                               3.1291, 1)
+            : 0.0;
+        double letters = legacy_round(legacy_round(static_cast<double>(character_count) / words_n, 2) * 100.0, 2);
+        double sentences_per_100 = legacy_round(legacy_round(sentences_n / words_n, 2) * 100.0, 2);
+        double coleman = legacy_round(0.058 * letters - 0.296 * sentences_per_100 - 15.8, 2);
+        double ari = legacy_round(4.71 * legacy_round(static_cast<double>(character_count) / words_n, 2) +
+                                  0.5 * legacy_round(words_n / sentences_n, 2) - 21.43, 1);
+
+        metrics.flesch_kincaid_grade = fkg;
+        metrics.flesch_reading_ease = fre;
+        metrics.smog_index = smog;
+        metrics.automated_readability_index = ari;
+        metrics.coleman_liau_index = coleman;
+        metrics.linsear_write_score = linsear_write_score;
+
+        if (difficult_words) {
+            // textstat counts each distinct word once, against a per-formula syllable threshold
+            auto difficult = [this](int64_t syllable_threshold) {
+                int64_t count = 0;
+                for (const auto& [word, syllables] : *difficult_words) {
+                    if (syllables >= syllable_threshold) count++;
+                }
+                return static_cast<double>(count);
+            };
+            double dale_chall_pct = 100.0 - (words_n - difficult(0)) / words_n * 100.0;
+            double dale_chall = 0.1579 * dale_chall_pct + 0.0496 * asl;
+            if (dale_chall_pct > 5.0) dale_chall += 3.6365;
+            double fog = legacy_round(0.4 * (asl + difficult(3) / words_n * 100.0), 2);
+
+            metrics.dale_chall_score = legacy_round(dale_chall, 2);
+            metrics.gunning_fog_index = fog;
+            metrics.difficult_word_count = static_cast<int64_t>(difficult(2));
+            if (linsear_write_score) {
+                metrics.text_standard = text_standard(
+                    fkg, fre, {smog, coleman, ari, *metrics.dale_chall_score, *linsear_write_score, fog});
+            }
+        }
+    }
+
+    // Structure
+    if (!sentence_lengths.empty()) {
+        double sentences_n = static_cast<double>(sentence_lengths.size());
+        metrics.paragraph_count = paragraph_count;
+        metrics.paragraph_sentence_ratio = static_cast<double>(paragraph_count) / sentences_n;
+        metrics.has_headings = has_headings;
+        metrics.has_lists = has_lists;
+        metrics.list_item_count = list_item_count;
+        metrics.average_paragraph_length_words = paragraph_count > 0
+            ? static_cast<double>(words.size()) / static_cast<double>(paragraph_count)
+            : 0.0;
+    }
+
+    // Lexical diversity over the concatenated word sequence
+    if (!words.empty()) {
+        std::unordered_set<std::string> unique(words.begin(), words.end());
+        double ratio = static_cast<double>(unique.size()) / static_cast<double>(words.size());
+        metrics.type_token_ratio = ratio;
+        metrics.unique_word_count = static_cast<int64_t>(unique.size());
+        metrics.unique_word_ratio = ratio;
+
+        if (words.size() >= 50) {
+            constexpr size_t kSegment = 10;
+            double sum = 0.0;
+            size_t segments = 0;
+            for (size_t i = 0; i < words.size(); i += kSegment) {
+                size_t end = std::min(words.size(), i + kSegment);
+                std::unordered_set<std::string> segment(words.begin() + i, words.begin() + end);
+                sum += static_cast<double>(segment.size()) / static_cast<double>(end - i);
+                segments++;
+            }
+            metrics.lexical_diversity_score = sum / static_cast<double>(segments);
+        }
+    }
+
+    // Autism support metrics
+    if (content_token_count && *content_token_count > 0) {
+        double tokens = static_cast<double>(*content_token_count);
+        metrics.pronoun_density = static_cast<double>(pronoun_count.value_or(0)) / tokens;
+        metrics.determiner_density = static_cast<double>(determiner_count.value_or(0)) / tokens;
+        metrics.anaphora_density = static_cast<double>(anaphora_count.value_or(0)) / tokens;
+        metrics.content_token_count = content_token_count;
+    }
+    // The whole-text analyzer reports spaCy's sentence segmentation whenever the model is loaded
+    if (spacy_sentence_count) metrics.sentence_count = spacy_sentence_count;
+
+    metrics.extra["metadata"] = {
+        {"text_length_words", words.size()},
+        {"chunks", chunks},
+        {"spacy_available", content_token_count.has_value()}
+    };
+    return metrics;
+}
+
+void from_json(const json& j, TextAggregates& aggregates) {
+    aggregates = TextAggregates{};
+    aggregates.chunks = 1;
+
+    aggregates.character_count = j.value("character_count", int64_t{0});
+    read_optional(j, "letter_count", aggregates.letter_count);
+    read_optional(j, "syllable_count", aggregates.syllable_count);
+    aggregates.word_count = j.value("word_count", int64_t{0});
+    aggregates.sentence_count = j.value("sentence_count", int64_t{0});
+    read_optional(j, "polysyllable_count", aggregates.polysyllable_count);
+    read_optional(j, "linsear_write_score", aggregates.linsear_write_score);
+    if (j.contains("difficult_words")) {
+        aggregates.difficult_words = j["difficult_words"].get<std::map<std::string, int64_t>>();
+    }
+
+    aggregates.words = j.value("words", std::vector<std::string>{});
+    aggregates.sentence_lengths = j.value("sentence_lengths", std::vector<int64_t>{});
+    aggregates.paragraph_count = j.value("paragraph_count", int64_t{0});
+    aggregates.list_item_count = j.value("list_item_count", int64_t{0});
+    aggregates.has_headings = j.value("has_headings", false);
+    aggregates.has_lists = j.value("has_lists", false);
+
+    read_optional(j, "pronoun_count", aggregates.pronoun_count);
+    read_optional(j, "determiner_count", aggregates.determiner_count);
+    read_optional(j, "anaphora_count", aggregates.anaphora_count);
+    read_optional(j, "content_token_count", aggregates.content_token_count);
+    read_optional(j, "spacy_sentence_count", aggregates.spacy_sentence_count);
+}
+
+std::vector<std::string> split_paragraph_chunks(const std::string& text, size_t target_chars) {
+    const std::string separator = "\n\n";
+    auto ends_sentence = [&text](size_t pos) {
+        size_t last = pos == 0 ? std::string::npos : text.find_last_not_of(" \t\r\n", pos - 1);
+        return last != std::string::npos && (text[last] == '.' || text[last] == '!' || text[last] == '?');
+    };
+
+    std::vector<std::string> chunks;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t cut = text.size();
+        if (text.size() - begin > target_chars) {
+            for (size_t pos = text.find(separator, begin + target_chars); pos != std::string::npos;
+                 pos = text.find(separator, pos + 1)) {
+                size_t end = pos + separator.size();
+                if (text.find_first_not_of(" \t\r\n", end) == std::string::npos) break;
+                if (ends_sentence(pos)) {
+                    cut = end;
+                    break;
+                }
+            }
+        }
+        chunks.push_back(text.substr(begin, cut - begin));
+        begin = cut;
+    }
+    return chunks;
+}
+
+} // namespace EMPI
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Payloads.hpp"
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace EMPI {
+
+/**
+ * @struct TextAggregates
+ * @brief Additive statistics of a text, the map output of chunked analysis.
+ *
+ * Produced per chunk by text_analyzer.py (`"mode": "aggregate"`) and merged
+ * in document order. Counts are summed, difficult words are unioned and the
+ * word and sentence-length sequences are concatenated. finalize() applies
+ * textstat's formulas, including its intermediate rounding, to the merged
+ * counts, so a chunked analysis reports what text_analyzer.py's analyze()
+ * reports for the whole text (spaCy tag counts aside, see below). Merging
+ * in a fixed order makes the result independent of how many workers
+ * produced the chunks.
+ *
+ * The counts are additive only for chunks cut by split_paragraph_chunks(),
+ * which never splits a sentence. spaCy tags tokens near a chunk boundary
+ * without the context across it, so the autism-support densities may differ
+ * slightly from a whole-text parse.
+ */
+struct TextAggregates {
+    int64_t chunks = 0;
+
+    // textstat counts (absent without textstat)
+    int64_t character_count = 0;
+    std::optional<int64_t> letter_count;
+    std::optional<int64_t> syllable_count;
+    int64_t word_count = 0;
+    /// Sentences of more than two words, before textstat's floor of 1
+    int64_t sentence_count = 0;
+    std::optional<int64_t> polysyllable_count;
+    /// Distinct words outside textstat's easy-word list, with their syllables
+    std::optional<std::map<std::string, int64_t>> difficult_words;
+    /// Linsear Write reads only the first 100 words, so it comes from the first chunk
+    std::optional<double> linsear_write_score;
+
+    // Structure and lexical sequences
+    std::vector<std::string> words;
+    std::vector<int64_t> sentence_lengths;
+    int64_t paragraph_count = 0;
+    int64_t list_item_count = 0;
+    bool has_headings = false;
+    bool has_lists = false;
+
+    // spaCy token counts (absent without spaCy)
+    std::optional<int64_t> pronoun_count;
+    std::optional<int64_t> determiner_count;
+    std::optional<int64_t> anaphora_count;
+    std::optional<int64_t> content_token_count;
+    std::optional<int64_t> spacy_sentence_count;
+
+    /**
+     * @brief Appends the aggregates of the following chunk.
+     */
+    void merge(const TextAggregates& next);
+
+    /**
+     * @brief Applies textstat's formulas (0.7.x) to the merged counts.
+     */
+    TextMetricsData finalize() const;
+};
+
+void from_json(const json& j, TextAggregates& aggregates);
+
+/**
+ * @brief Splits a text into chunks of at least `target_chars`, cutting only at
+ *        paragraph breaks ("\n\n").
+ *
+ * A break is only cut when the text before it ends a sentence ('.', '!' or
+ * '?') and text follows it, so no sentence and no paragraph spans two chunks
+ * and no chunk is blank. A text without such breaks stays one chunk. The separator stays attached to the end of the
+ * preceding chunk, so the chunks concatenate back to the input.
+ */
+std::vector<std::string> split_paragraph_chunks(const std::string& text, size_t target_chars);
+
+} // namespace EMPI
@@ -0,0 +1,114 @@
+/**
+ * @file TrafficCapture.cpp
+ * @brief Binary request log for deterministic replay
+ */
+
+#include "TrafficCapture.hpp"
+#include "Payloads.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+namespace EMPI {
+
+namespace {
+
+const char kMagic[] = "EMPICAP1";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+
+} // namespace
+
+TrafficCapture::TrafficCapture(const std::string& path)
+    : out_(path, std::ios::binary | std::ios::trunc)
+    , start_(std::chrono::steady_clock::now())
+{
+    if (!out_.is_open()) {
+        throw std::runtime_error("Cannot open capture file: " + path);
+    }
+    out_.write(kMagic, kMagicSize);
+    out_.flush();
+}
+
+void TrafficCapture::record(const CapturedRequest& request) {
+    std::string frame;
+    payload_codec::BinaryWriter writer(frame);
+    writer.write(request.arrival_ns);
+    writer.write(request.latency_ns);
+    writer.write(request.agent_id);
+    writer.write(request.task_type);
+    writer.write(request.input);
+
+    std::string framed;
+    payload_codec::BinaryWriter(framed).write_size(frame.size());
+    framed += frame;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.write(framed.data(), static_cast<std::streamsize>(framed.size()));
+    out_.flush();
+    records_++;
+}
+
+int64_t TrafficCapture::now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+}
+
+uint64_t TrafficCapture::records() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+}
+
+std::shared_ptr<TrafficCapture> TrafficCapture::from_environment() {
+    static std::once_flag once;
+    static std::shared_ptr<TrafficCapture> capture;
+    std::call_once(once, [] {
+        const char* path = std::getenv("EMPI_CAPTURE");
+        if (!path || !*path) {
+            return;
+        }
+        try {
+            capture = std::make_shared<TrafficCapture>(path);
+        } catch (const std::exception& e) {
+            std::cerr << "EMPI capture disabled: " << e.what() << "\n";
+        }
+    });
+    return capture;
+}
+
+std::vector<CapturedRequest> TrafficCapture::read_log(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Cannot open capture file: " + path);
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.compare(0, kMagicSize, kMagic) != 0) {
+        throw std::runtime_error("Not an EMPI capture file: " + path);
+    }
+
+    std::vector<CapturedRequest> requests;
+    size_t pos = kMagicSize;
+    while (pos < data.size()) {
+        try {
+            payload_codec::BinaryReader header(data.data() + pos, data.size() - pos);
+            size_t frame_size = header.read_size();
+            size_t frame_begin = pos + sizeof(uint64_t);
+
+            payload_codec::BinaryReader reader(data.data() + frame_begin, frame_size);
+            CapturedRequest request;
+            reader.read(request.arrival_ns);
+            reader.read(request.latency_ns);
+            reader.read(request.agent_id);
+            reader.read(request.task_type);
+            reader.read(request.input);
+            requests.push_back(std::move(request));
+            pos = frame_begin + frame_size;
+        } catch (const std::exception&) {
+            // Truncated tail from an interrupted capture
+            break;
+        }
+    }
+    return requests;
+}
+
+} // namespace EMPI
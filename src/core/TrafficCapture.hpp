@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace EMPI {
+
+/**
+ * @struct CapturedRequest
+ * @brief One incoming EMPI request as seen by UniversalAgent::process_raw.
+ */
+struct CapturedRequest {
+    int64_t arrival_ns = 0;   ///< Arrival time relative to the start of the capture
+    int64_t latency_ns = 0;   ///< Time process_raw took in the captured build
+    std::string agent_id;
+    std::string task_type;
+    json input;
+};
+
+/**
+ * @class TrafficCapture
+ * @brief Append-only binary log of incoming EMPI requests for replay.
+ *
+ * File layout: the magic "EMPICAP1", then length-prefixed records encoded
+ * with payload_codec::BinaryWriter (arrival, latency, agent id, task type,
+ * msgpack input). A truncated last record, e.g. after a crash, is ignored
+ * on read. One capture may be shared by several agents; record() is
+ * thread-safe.
+ */
+class TrafficCapture {
+public:
+    /**
+     * @brief Opens (truncates) a capture file.
+     * @throws std::runtime_error if the file cannot be opened
+     */
+    explicit TrafficCapture(const std::string& path);
+
+    /**
+     * @brief Appends a request and flushes it to disk.
+     */
+    void record(const CapturedRequest& request);
+
+    /**
+     * @brief Nanoseconds since the capture was opened (steady clock).
+     */
+    int64_t now_ns() const;
+
+    uint64_t records() const;
+
+    /**
+     * @brief Process-wide capture opened from the EMPI_CAPTURE environment variable.
+     *
+     * Returns nullptr when the variable is unset or the file cannot be opened,
+     * so capture can be switched on in production without a rebuild.
+     */
+    static std::shared_ptr<TrafficCapture> from_environment();
+
+    /**
+     * @brief Reads every complete record of a capture file, in file order.
+     * @throws std::runtime_error if the file is missing or not a capture
+     */
+    static std::vector<CapturedRequest> read_log(const std::string& path);
+
+private:
+    mutable std::mutex mutex_;
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t records_ = 0;
+};
+
+} // namespace EMPI
@@ -1,4 +1,8 @@
 #include "UniversalAgent.hpp"
+#include "BlobStore.hpp"
+#include "Probes.hpp"
+#include "RequestCost.hpp"
+#include "TrafficCapture.hpp"
 #include <stdexcept>
 
 namespace EMPI {
@@ -8,12 +12,20 @@ UniversalAgent::UniversalAgent(const std::string& agent_id,
     : agent_id_(agent_id)
     , default_task_type_(default_task_type.empty() ? agent_id : default_task_type)
     , state_(json::object())
+    , capture_(TrafficCapture::from_environment())
 {
     // Initialize with empty state
 }
 
 json UniversalAgent::process_raw(const json& input, const std::string& task_type) {
     std::string task = task_type.empty() ? default_task_type_ : task_type;
+    int64_t arrival_ns = capture_ ? capture_->now_ns() : 0;
+    
+    ProbeRequestScope request;
+    RequestCostScope cost;
+    if (EMPI_PROBE_ENABLED(request__start)) {
+        EMPI_PROBE4(request__start, request.id(), agent_id_.c_str(), task.c_str(), input.dump().size());
+    }
     
     // 1. Create EMPI header
     json empi_message = create_empi_message(task);
@@ -27,6 +39,11 @@ json UniversalAgent::process_raw(const json& input, const std::string& task_type
         error_result["error_type"] = "handler_not_found";
         
         empi_message["payload"]["data"] = error_result;
+        empi_message["payload"]["metadata"]["cost"] = cost.snapshot();
+        EMPI_PROBE3(request__end, request.id(), 2, 0);
+        if (capture_) {
+            capture_->record({arrival_ns, capture_->now_ns() - arrival_ns, agent_id_, task, captured_input(input)});
+        }
         return empi_message;
     }
     
@@ -36,10 +53,21 @@ json UniversalAgent::process_raw(const json& input, const std::string& task_type
 
     try {
         // Execute φ-function (data extraction)
-        json extracted = phi_function(input, json{}, state_);
+        // φ updates the shared state; ψ (the slow part) reads this request's copy of it
+        EMPI_PROBE1(phi__start, request.id());
+        json extracted;
+        json request_state;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            extracted = phi_function(input, json{}, state_);
+            request_state = state_;
+        }
+        EMPI_PROBE1(phi__end, request.id());
         
         // Execute ψ-function (data processing)
-        json data_result = psi_function(extracted, json{}, state_);
+        EMPI_PROBE1(psi__start, request.id());
+        json data_result = psi_function(extracted, json{}, request_state);
+        EMPI_PROBE1(psi__end, request.id());
         
         // 3. Place result in data field
         empi_message["payload"]["data"] = data_result;
@@ -53,10 +81,31 @@ json UniversalAgent::process_raw(const json& input, const std::string& task_type
         
         empi_message["payload"]["data"] = error_result;
     }
+    empi_message["payload"]["metadata"]["cost"] = cost.snapshot();
     
+    if (EMPI_PROBE_ENABLED(request__end)) {
+        const json& data = empi_message["payload"]["data"];
+        int status = data.is_object() && data.value("status", "") == "error" ? 1 : 0;
+        EMPI_PROBE3(request__end, request.id(), status, data.dump().size());
+    }
+    if (capture_) {
+        capture_->record({arrival_ns, capture_->now_ns() - arrival_ns, agent_id_, task, captured_input(input)});
+    }
     return empi_message;
 }
 
+json UniversalAgent::captured_input(const json& input) const {
+    if (!blob_store_) {
+        return input;
+    }
+    // Replays run without this process's blobs, so the log gets the content
+    try {
+        return blob_store_->materialize(input);
+    } catch (const std::exception&) {
+        return input;
+    }
+}
+
 void UniversalAgent::register_handler(
     const std::string& task_type,
     std::function<json(const json&, const json&, json&)> phi_function,
@@ -73,6 +122,23 @@ void UniversalAgent::register_handler(
     handlers_[task_type] = HandlerPair{std::move(phi_function), std::move(psi_function)};
 }
 
+json UniversalAgent::share_text(std::string value) const {
+    return blob_store_ ? blob_store_->wrap(std::move(value)) : json(std::move(value));
+}
+
+std::shared_ptr<const std::string> UniversalAgent::read_text(const json& value) const {
+    if (value.is_string()) {
+        return std::make_shared<const std::string>(value.get_ref<const std::string&>());
+    }
+    if (!BlobRef::is_ref(value)) {
+        throw std::invalid_argument("Expected a string or a blob reference");
+    }
+    if (!blob_store_) {
+        throw std::invalid_argument("Blob reference received but no blob store is set");
+    }
+    return blob_store_->get(value.get<BlobRef>());
+}
+
 json UniversalAgent::create_empi_message(const std::string& task_type) const {
     json empi_message;
     
@@ -2,12 +2,18 @@
 
 #include <string>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
 namespace EMPI {
 
+class TrafficCapture;
+class BlobStore;
+
 /**
  * @class UniversalAgent
  * @brief Base class for all EMPI agents implementing φ-ψ handler architecture.
@@ -33,6 +39,10 @@ public:
     /**
      * @brief Process input data using EMPI protocol with φ-ψ functions.
      * 
+     * Safe to call from several threads. φ runs on the agent state under a
+     * lock, so state updates belong there; ψ runs unlocked on a copy of the
+     * state as that φ left it, and its changes to the copy are discarded.
+     * 
      * @param input Raw input data in JSON format
      * @param task_type Specific task type to execute (uses default if empty)
      * @return json Complete EMPI message with processed data
@@ -58,19 +68,52 @@ public:
      * 
      * @return json Current agent state
      */
-    json get_agent_state() const { return state_; }
+    json get_agent_state() const {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        return state_;
+    }
     
     /**
      * @brief Set the agent's state.
      * 
      * @param state New state to set
      */
-    void set_agent_state(const json& state) { state_ = state; }
+    void set_agent_state(const json& state) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state_ = state;
+    }
     
     /**
      * @brief Reset agent state to empty.
      */
-    void reset_state() { state_ = json::object(); }
+    void reset_state() {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state_ = json::object();
+    }
+    
+    /**
+     * @brief Records every request passed to process_raw into a capture log.
+     * 
+     * Agents start with the capture named by EMPI_CAPTURE, if any
+     * (see TrafficCapture::from_environment()). Pass nullptr to stop.
+     * 
+     * @param capture Capture to append to; may be shared between agents
+     */
+    void set_capture(std::shared_ptr<TrafficCapture> capture) { capture_ = std::move(capture); }
+    
+    /**
+     * @brief Lets the agent exchange large strings (pages, source texts) as blob references.
+     * 
+     * With a store, large outputs are returned as {"$blob": ...} references
+     * into it and inputs may carry such references. Agents that pass data to
+     * each other must share the same store. Without one (the default) every
+     * string travels inline, as before.
+     * 
+     * @param store Blob store; may be shared between agents, nullptr to disable
+     */
+    void set_blob_store(std::shared_ptr<BlobStore> store) { blob_store_ = std::move(store); }
+    
+    std::shared_ptr<BlobStore> get_blob_store() const { return blob_store_; }
     
 protected:
     /**
@@ -93,8 +136,23 @@ protected:
      * @return json EMPI message with header
      */
     json create_empi_message(const std::string& task_type) const;
+    
+    /**
+     * @brief `value` for an output payload: a blob reference if it is large and a store is set.
+     */
+    json share_text(std::string value) const;
+    
+    /**
+     * @brief The string behind an input field holding a string or a blob reference.
+     * 
+     * @throws std::invalid_argument If `value` is neither, or is a reference and no store is set
+     * @throws std::runtime_error If the referenced blob is no longer available
+     */
+    std::shared_ptr<const std::string> read_text(const json& value) const;
 
 private:
+    json captured_input(const json& input) const;
+    
     struct HandlerPair {
         std::function<json(const json&, const json&, json&)> phi_function;
         std::function<json(const json&, const json&, json&)> psi_function;
@@ -103,7 +161,10 @@ private:
     std::string agent_id_;
     std::string default_task_type_;
     json state_;
+    mutable std::mutex state_mutex_;
     std::unordered_map<std::string, HandlerPair> handlers_;
+    std::shared_ptr<TrafficCapture> capture_;
+    std::shared_ptr<BlobStore> blob_store_;
 };
 
 } // namespace EMPI
@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * @file TestCheck.hpp
+ * @brief CHECK macro and test runner shared by the unit tests.
+ *
+ * Unlike assert(), CHECK is evaluated in every build type and reports a
+ * failure by throwing, so run_tests() can name the failing test and go on
+ * with the next one.
+ */
+
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace EMPI {
+
+/**
+ * @brief Thrown by CHECK when its condition is false.
+ */
+class CheckFailure : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] inline void check_failed(const char* expression, const char* file, int line) {
+    throw CheckFailure(std::string(file) + ":" + std::to_string(line) + ": CHECK(" + expression + ") failed");
+}
+
+/// Checks a condition in every build type; throws CheckFailure with its location if false
+#define CHECK(...) \
+    ((__VA_ARGS__) ? static_cast<void>(0) : ::EMPI::check_failed(#__VA_ARGS__, __FILE__, __LINE__))
+
+using TestCase = std::pair<std::string, std::function<void()>>;
+
+/**
+ * @brief Runs every test, printing "[OK] name" or "[FAIL] name: reason".
+ *
+ * @return Process exit code: 0 if all tests passed, 1 otherwise
+ */
+inline int run_tests(const std::vector<TestCase>& tests) {
+    int tests_failed = 0;
+    for (const auto& [test_name, test_func] : tests) {
+        try {
+            test_func();
+            std::cout << "[OK] " << test_name << "\n";
+        } catch (const std::exception& e) {
+            std::cout << "[FAIL] " << test_name << ": " << e.what() << "\n";
+            tests_failed++;
+        }
+    }
+    return tests_failed > 0 ? 1 : 0;
+}
+
+} // namespace EMPI
@@ -0,0 +1,270 @@
+/**
+ * @file test_blob_store.cpp
+ * @brief Unit tests for out-of-band blob references
+ */
+
+#include "../src/core/BlobStore.hpp"
+#include "../src/core/UniversalAgent.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+/// Emits a large page by reference and echoes the length of a text it receives
+class PageAgent : public UniversalAgent {
+public:
+    PageAgent() : UniversalAgent("page_agent") {
+        register_handler("page_agent",
+            [](const json& input, const json&, json&) { return input; },
+            [this](const json& input, const json&, json&) {
+                auto text = read_text(input.at("text"));
+                return json{
+                    {"status", "success"},
+                    {"length", text->size()},
+                    {"html", share_text("<main>" + *text + "</main>")}
+                };
+            });
+    }
+};
+
+void test_put_get_and_dedup() {
+    BlobStore store;
+    std::string page(10000, 'x');
+    BlobRef ref = store.put(page);
+    CHECK(ref.size == page.size());
+    CHECK(ref.hash.size() == 16);
+
+    auto first = store.get(ref);
+    auto second = store.get(ref);
+    CHECK(*first == page);
+    // Readers share the stored buffer
+    CHECK(first.get() == second.get());
+
+    BlobRef again = store.put(page);
+    CHECK(again.handle == ref.handle);
+    CHECK(store.stats()["blobs"] == 1);
+    CHECK(store.stats()["dedup_hits"] == 1);
+
+    store.erase(ref.handle);
+    CHECK(!store.contains(ref.handle));
+    bool threw = false;
+    try {
+        store.get(ref);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+void test_wrap_and_read() {
+    BlobStoreConfig config;
+    config.inline_limit = 100;
+    BlobStore store(config);
+    json small = store.wrap("short");
+    CHECK(small.is_string());
+
+    json large = store.wrap(std::string(500, 'a'));
+    CHECK(BlobRef::is_ref(large));
+    CHECK(large["size"] == 500);
+    CHECK(*store.read(large) == std::string(500, 'a'));
+    CHECK(*store.read(small) == "short");
+
+    json doc = {{"html", large}, {"parts", json::array({large, "inline"})}, {"n", 3}};
+    json materialized = store.materialize(doc);
+    CHECK(materialized["html"] == std::string(500, 'a'));
+    CHECK(materialized["parts"][0] == std::string(500, 'a'));
+    CHECK(materialized["parts"][1] == "inline");
+    CHECK(materialized["n"] == 3);
+}
+
+void test_eviction_spills_by_default() {
+    BlobStoreConfig config;
+    config.max_memory_bytes = 2500;
+    BlobStore store(config);
+    BlobRef a = store.put(std::string(1000, 'a'));
+    auto held = store.get(a);
+    store.put(std::string(1000, 'b'));
+    store.put(std::string(1000, 'c'));
+
+    // Still referenced, so still readable past the memory budget
+    CHECK(store.contains(a.handle));
+    CHECK(store.stats()["dropped"] == 0);
+    CHECK(store.stats()["spilled_bytes"] == 1000);
+    CHECK(store.stats()["memory_bytes"] == 2000);
+    CHECK(*store.get(a) == std::string(1000, 'a'));
+    // A reader holding the buffer keeps it
+    CHECK(*held == std::string(1000, 'a'));
+
+    // Storing it again brings it back into memory under the same handle
+    CHECK(store.put(std::string(1000, 'a')).handle == a.handle);
+    CHECK(store.stats()["spilled_bytes"] == 1000);
+    CHECK(store.stats()["blobs"] == 3);
+}
+
+void test_get_checks_reference() {
+    BlobStore store;
+    BlobRef ref = store.put(std::string(5000, 'x'));
+
+    // A reference to other content under the same handle is rejected, not answered with this blob
+    BlobRef other_size = ref;
+    other_size.size = 4999;
+    BlobRef other_hash = ref;
+    other_hash.hash = "0000000000000000";
+    for (const BlobRef& wrong : {other_size, other_hash}) {
+        bool threw = false;
+        try {
+            store.get(wrong);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+    CHECK(*store.get(ref) == std::string(5000, 'x'));
+}
+
+void test_spill_and_reload() {
+    fs::path dir = fs::temp_directory_path() / "empi_blob_test";
+    fs::remove_all(dir);
+
+    BlobStoreConfig config;
+    config.max_memory_bytes = 1500;
+    config.spill_dir = dir.string();
+    BlobStore store(config);
+    BlobRef a = store.put(std::string(1000, 'a'));
+    BlobRef b = store.put(std::string(1000, 'b'));
+
+    CHECK(store.contains(a.handle));
+    CHECK(store.stats()["spilled_bytes"] == 1000);
+    CHECK(*store.get(a) == std::string(1000, 'a'));
+    CHECK(*store.get(b) == std::string(1000, 'b'));
+
+    // A spilled file that no longer matches its reference is rejected
+    CHECK(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+    std::ofstream(fs::directory_iterator(dir)->path(), std::ios::trunc) << "tampered";
+    bool threw = false;
+    try {
+        store.get(a);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    fs::remove_all(dir);
+
+    // A store in a caller's directory removes its own files
+    {
+        BlobStore scoped(config);
+        scoped.put(std::string(1000, 'c'));
+        scoped.put(std::string(1000, 'd'));
+        CHECK(scoped.stats()["spilled_bytes"] == 1000);
+    }
+    CHECK(fs::is_empty(dir));
+    fs::remove_all(dir);
+}
+
+void test_blobs_expire() {
+    BlobStoreConfig config;
+    config.max_memory_bytes = 1500;
+    config.ttl = std::chrono::milliseconds(50);
+    BlobStore store(config);
+    BlobRef a = store.put(std::string(1000, 'a'));
+    BlobRef b = store.put(std::string(1000, 'b'));
+    CHECK(store.stats()["spilled_bytes"] == 1000);
+
+    // Reading keeps a blob alive; one left alone expires from memory or disk
+    for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        store.get(b);
+    }
+    BlobRef c = store.put(std::string(1000, 'c'));
+    CHECK(!store.contains(a.handle));
+    CHECK(store.contains(b.handle) && store.contains(c.handle));
+    CHECK(store.stats()["expired"] == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    store.put(std::string(10, 'd'));
+    CHECK(store.stats()["blobs"] == 1);
+    CHECK(store.stats()["spilled_bytes"] == 0);
+    CHECK(store.stats()["memory_bytes"] == 10);
+}
+
+void test_concurrent_spills() {
+    BlobStoreConfig config;
+    config.max_memory_bytes = 4000;
+    BlobStore store(config);
+    std::vector<std::thread> workers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&store, &mismatches, t] {
+            for (int i = 0; i < 200; ++i) {
+                // Overlapping contents across threads, so dedup races with spilling
+                std::string data(1000 + (i + t) % 7, static_cast<char>('a' + (i + t) % 7));
+                BlobRef ref = store.put(data);
+                if (*store.get(ref) != data) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CHECK(mismatches == 0);
+    CHECK(store.stats()["blobs"] == 7);
+    CHECK(store.stats()["dropped"] == 0);
+    CHECK(store.stats()["memory_bytes"].get<uint64_t>() + store.stats()["spilled_bytes"].get<uint64_t>() ==
+          7 * 1000 + 21);
+}
+
+void test_agents_exchange_references() {
+    BlobStoreConfig config;
+    config.inline_limit = 64;
+    auto store = std::make_shared<BlobStore>(config);
+    PageAgent producer;
+    PageAgent consumer;
+    producer.set_blob_store(store);
+    consumer.set_blob_store(store);
+
+    std::string text(200, 't');
+    json first = producer.process_raw({{"text", text}});
+    json html = first["payload"]["data"]["html"];
+    CHECK(BlobRef::is_ref(html));
+    CHECK(html["size"] == text.size() + 13);
+
+    // The next agent receives the page as a reference and reads it on demand
+    json second = consumer.process_raw({{"text", html}});
+    CHECK(second["payload"]["data"]["status"] == "success");
+    CHECK(second["payload"]["data"]["length"] == text.size() + 13);
+
+    // Without a store strings stay inline and references are rejected
+    PageAgent plain;
+    json inline_result = plain.process_raw({{"text", text}});
+    CHECK(inline_result["payload"]["data"]["html"].is_string());
+    json rejected = plain.process_raw({{"text", html}});
+    CHECK(rejected["payload"]["data"]["status"] == "error");
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Put Get And Dedup", test_put_get_and_dedup},
+        {"Wrap And Read", test_wrap_and_read},
+        {"Eviction Spills By Default", test_eviction_spills_by_default},
+        {"Get Checks Reference", test_get_checks_reference},
+        {"Spill And Reload", test_spill_and_reload},
+        {"Blobs Expire", test_blobs_expire},
+        {"Concurrent Spills", test_concurrent_spills},
+        {"Agents Exchange References", test_agents_exchange_references}
+    };
+
+    return run_tests(tests);
+}
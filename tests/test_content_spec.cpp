@@ -0,0 +1,264 @@
+/**
+ * @file test_content_spec.cpp
+ * @brief Unit tests for content-spec parsing and native rendering
+ */
+
+#include "../src/core/ContentSpec.hpp"
+#include "../src/core/PageValidator.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+const std::string kOutput = R"( {"t": "The Water Cycle",
+ "s": [{"h": "Where water goes", "p": ["The sun warms the sea.", "Water rises as vapor."]},
+       {"h": "Rain", "p": ["Clouds get heavy. Rain falls."]}],
+ "k": ["Water moves in a circle.", "The sun drives it."],
+ "g": [["vapor", "water as a gas"], ["condense", "turn from gas to liquid"]],
+ "n": "Short sentences and a word list for a young reader."}
+)";
+
+void test_parse() {
+    ContentSpec spec = parse_content_spec("Here is the spec:\n" + kOutput + "\nDone.");
+    CHECK(spec.title == "The Water Cycle");
+    CHECK(spec.sections.size() == 2);
+    CHECK(spec.sections[0].paragraphs.size() == 2);
+    CHECK(spec.key_points.size() == 2);
+    CHECK(spec.glossary.size() == 2 && spec.glossary[1].term == "condense");
+    CHECK(spec.adaptation_note.find("young reader") != std::string::npos);
+
+    // Round trip through the compact form
+    ContentSpec again = json(spec).get<ContentSpec>();
+    CHECK(json(again) == json(spec));
+}
+
+void test_parse_rejects_truncated() {
+    for (const std::string& output : {std::string("no json here"),
+                                      kOutput.substr(0, kOutput.size() / 2),
+                                      std::string(R"({"t": "Empty", "s": [], "k": [], "g": [], "n": ""})")}) {
+        bool threw = false;
+        try {
+            parse_content_spec(output);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+}
+
+void test_render_escapes() {
+    ContentSpec spec;
+    spec.title = "Less <than> & \"more\"";
+    spec.sections.push_back({"A < B", {"<script>alert(1)</script>"}});
+    std::string html = render_content_spec(spec, ProfileFlags{});
+
+    CHECK(html.find("<script>") == std::string::npos);
+    CHECK(html.find("&lt;script&gt;") != std::string::npos);
+    CHECK(html.find("<h1>Less &lt;than&gt; &amp; &quot;more&quot;</h1>") != std::string::npos);
+}
+
+void test_render_profiles_valid() {
+    ContentSpec spec = parse_content_spec(kOutput);
+    for (uint32_t needs = 0; needs < 256; ++needs) {
+        ProfileFlags profile = implied_profile(static_cast<uint8_t>(needs));
+        std::string html = render_content_spec(spec, profile);
+
+        PageValidation validation = validate_page(html);
+        CHECK(validation.valid);
+        CHECK(html.find("id=\"empi-preset\"") != std::string::npos);
+    }
+}
+
+void test_key_points_placement() {
+    ContentSpec spec = parse_content_spec(kOutput);
+
+    ProfileFlags adhd;
+    adhd.set(Need::ADHD);
+    std::string first = render_content_spec(spec, adhd);
+    CHECK(first.find("Key points") < first.find("Where water goes"));
+
+    ProfileFlags child;
+    child.set(Need::Child);
+    std::string last = render_content_spec(spec, child);
+    CHECK(last.find("Key points") > last.find("Where water goes"));
+    CHECK(last.find("Words to know") != std::string::npos);
+}
+
+void test_outline_and_sections() {
+    PageOutline outline = parse_outline(
+        R"(Outline: {"t": "Rivers", "o": [["What a river is", "define it"], ["", "dropped"], ["Why rivers matter", "uses"]], "k": ["Rivers move water"]})");
+    CHECK(outline.title == "Rivers");
+    CHECK(outline.items.size() == 2);
+    CHECK(outline.items[1].heading == "Why rivers matter");
+    CHECK(outline.key_points.size() == 1);
+
+    bool threw = false;
+    try {
+        parse_outline(R"({"t": "Empty", "o": [], "k": []})");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    ContentSection section = section_from_text("What a river is",
+        "What a river is\n\n## Heading\nA river is moving water.  \n- It flows to the sea.\n\n");
+    CHECK(section.heading == "What a river is");
+    CHECK(section.paragraphs.size() == 2);
+    CHECK(section.paragraphs[0] == "A river is moving water.");
+    CHECK(section.paragraphs[1] == "It flows to the sea.");
+}
+
+/**
+ * @brief Longest text a GBNF grammar accepts, in characters; SIZE_MAX if unbounded.
+ *
+ * Covers the subset the spec grammars use: literals, character classes,
+ * rule references, groups, alternatives and the ?, *, + and {m,n} suffixes.
+ */
+class GrammarBound {
+public:
+    explicit GrammarBound(const std::string& grammar) {
+        std::istringstream lines(grammar);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t sep = line.find("::=");
+            if (sep == std::string::npos) continue;
+            std::string name = line.substr(0, line.find_first_of(' '));
+            rules_[name] = line.substr(sep + 3);
+        }
+    }
+
+    size_t longest(const std::string& rule) {
+        auto known = memo_.find(rule);
+        if (known != memo_.end()) return known->second;
+        const std::string& body = rules_.at(rule);
+        size_t pos = 0;
+        size_t n = alternatives(body, pos);
+        memo_[rule] = n;
+        return n;
+    }
+
+private:
+    static size_t add(size_t a, size_t b) { return (a == SIZE_MAX || b == SIZE_MAX) ? SIZE_MAX : a + b; }
+    static size_t mul(size_t a, size_t b) { return (a == SIZE_MAX && b) ? SIZE_MAX : a * b; }
+
+    static void skip_space(const std::string& s, size_t& pos) {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t')) ++pos;
+    }
+
+    size_t alternatives(const std::string& s, size_t& pos) {
+        size_t best = sequence(s, pos);
+        while (pos < s.size() && s[pos] == '|') {
+            ++pos;
+            best = std::max(best, sequence(s, pos));
+        }
+        return best;
+    }
+
+    size_t sequence(const std::string& s, size_t& pos) {
+        size_t total = 0;
+        for (skip_space(s, pos); pos < s.size() && s[pos] != '|' && s[pos] != ')'; skip_space(s, pos)) {
+            total = add(total, repeated(s, pos, item(s, pos)));
+        }
+        return total;
+    }
+
+    size_t item(const std::string& s, size_t& pos) {
+        char c = s[pos];
+        if (c == '"') {
+            size_t n = 0;
+            for (++pos; s[pos] != '"'; ++pos, ++n) {
+                if (s[pos] == '\\') ++pos;
+            }
+            ++pos;
+            return n;
+        }
+        if (c == '[') {
+            for (++pos; s[pos] != ']'; ++pos) {
+                if (s[pos] == '\\') ++pos;
+            }
+            ++pos;
+            return 1;
+        }
+        if (c == '(') {
+            ++pos;
+            size_t n = alternatives(s, pos);
+            ++pos;
+            return n;
+        }
+        size_t end = pos;
+        while (end < s.size() && (std::isalnum(static_cast<unsigned char>(s[end])) || s[end] == '_' || s[end] == '-')) ++end;
+        std::string name = s.substr(pos, end - pos);
+        pos = end;
+        return longest(name);
+    }
+
+    static size_t repeated(const std::string& s, size_t& pos, size_t n) {
+        if (pos >= s.size()) return n;
+        if (s[pos] == '?') { ++pos; return n; }
+        if (s[pos] == '*' || s[pos] == '+') { ++pos; return n ? SIZE_MAX : 0; }
+        if (s[pos] == '{') {
+            size_t close = s.find('}', pos);
+            std::string range = s.substr(pos + 1, close - pos - 1);
+            pos = close + 1;
+            size_t comma = range.find(',');
+            std::string upper = comma == std::string::npos ? range : range.substr(comma + 1);
+            return upper.empty() ? (n ? SIZE_MAX : 0) : mul(n, std::stoul(upper));
+        }
+        return n;
+    }
+
+    std::map<std::string, std::string> rules_;
+    std::map<std::string, size_t> memo_;
+};
+
+void test_grammars_fit_budget() {
+    size_t spec = GrammarBound(kContentSpecGrammar).longest("root");
+    size_t outline = GrammarBound(kOutlineGrammar).longest("root");
+    CHECK(spec <= static_cast<size_t>(kContentSpecMaxTokens));
+    CHECK(outline <= static_cast<size_t>(kOutlineMaxTokens));
+
+    // The longest spec and outline the grammars allow parse
+    auto text = [](size_t n) { return "\"" + std::string(n, 'x') + "\""; };
+    auto list = [](size_t n, const std::string& item) {
+        std::string out = "[";
+        for (size_t i = 0; i < n; ++i) out += (i ? ", " : "") + item;
+        return out + "]";
+    };
+    std::string section = "{\"h\": " + text(40) + ", \"p\": " + list(3, text(88)) + "}";
+    std::string longest_spec = "{\"t\": " + text(48) + ", \"s\": " + list(4, section)
+        + ", \"k\": " + list(4, text(56)) + ", \"g\": " + list(3, "[" + text(24) + ", " + text(56) + "]")
+        + ", \"n\": " + text(80) + "}";
+    CHECK(longest_spec.size() <= spec);
+    ContentSpec parsed = parse_content_spec(longest_spec);
+    CHECK(parsed.sections.size() == 4 && parsed.glossary.size() == 3);
+
+    std::string longest_outline = "{\"t\": " + text(48) + ", \"o\": " + list(4, "[" + text(40) + ", " + text(64) + "]")
+        + ", \"k\": " + list(3, text(48)) + "}";
+    CHECK(longest_outline.size() <= outline);
+    CHECK(parse_outline(longest_outline).items.size() == 4);
+
+    // Unbounded strings are reported as such
+    CHECK(GrammarBound("root ::= \"\\\"\" [a-z]* \"\\\"\"").longest("root") == SIZE_MAX);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Parse", test_parse},
+        {"Parse Rejects Truncated", test_parse_rejects_truncated},
+        {"Render Escapes", test_render_escapes},
+        {"Render Profiles Valid", test_render_profiles_valid},
+        {"Key Points Placement", test_key_points_placement},
+        {"Outline And Sections", test_outline_and_sections},
+        {"Grammars Fit Budget", test_grammars_fit_budget}
+    };
+
+    return run_tests(tests);
+}
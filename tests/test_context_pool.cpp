@@ -0,0 +1,154 @@
+/**
+ * @file test_context_pool.cpp
+ * @brief Unit tests for the size-classed llama context pool
+ */
+
+#include "../src/core/ContextPool.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+/// Stand-in contexts: the factory hands out distinct fake pointers and records sizes
+struct FakeContexts {
+    std::vector<uint32_t> created;
+    std::atomic<int> alive{0};
+
+    ContextPool make_pool(ContextPoolConfig config) {
+        return ContextPool(config,
+            [this](uint32_t n_ctx) {
+                created.push_back(n_ctx);
+                alive++;
+                return reinterpret_cast<llama_context*>(new char[1]);
+            },
+            [this](llama_context* ctx) {
+                alive--;
+                delete[] reinterpret_cast<char*>(ctx);
+            });
+    }
+};
+
+void test_select_class() {
+    std::vector<uint32_t> classes = {1024, 2048, 4096};
+    CHECK(ContextPool::select_class(classes, 0) == 0);
+    CHECK(ContextPool::select_class(classes, 1024) == 0);
+    CHECK(ContextPool::select_class(classes, 1025) == 1);
+    CHECK(ContextPool::select_class(classes, 4096) == 2);
+    CHECK(ContextPool::select_class(classes, 100000) == 2);
+}
+
+void test_lazy_creation_and_reuse() {
+    FakeContexts fake;
+    {
+        ContextPool pool = fake.make_pool({{1024, 2048, 4096}, 2});
+        CHECK(fake.created.empty());
+
+        llama_context* first = nullptr;
+        {
+            auto lease = pool.acquire(700);
+            CHECK(lease && lease.n_ctx() == 1024);
+            first = lease.get();
+        }
+        // Returned contexts are reused, not recreated
+        auto again = pool.acquire(300);
+        CHECK(again.get() == first);
+        CHECK(fake.created == std::vector<uint32_t>({1024}));
+
+        auto big = pool.acquire(3000);
+        CHECK(big.n_ctx() == 4096);
+
+        json stats = pool.stats();
+        CHECK(stats["classes"][0]["leases"] == 2);
+        CHECK(stats["classes"][1]["contexts"] == 0);
+        CHECK(stats["allocated_kv_tokens"] == 1024 + 4096);
+    }
+    CHECK(fake.alive == 0);
+}
+
+void test_upgrade_when_class_is_full() {
+    FakeContexts fake;
+    ContextPool pool = fake.make_pool({{1024, 2048}, 1});
+
+    auto a = pool.acquire(500);
+    auto b = pool.acquire(500);
+    CHECK(a.n_ctx() == 1024);
+    CHECK(b.n_ctx() == 2048);
+    CHECK(pool.stats()["classes"][0]["upgraded"] == 1);
+}
+
+void test_waits_for_release() {
+    FakeContexts fake;
+    ContextPool pool = fake.make_pool({{1024}, 1});
+
+    auto held = pool.acquire(100);
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&] {
+        auto lease = pool.acquire(100);
+        acquired = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!acquired);
+    held.release();
+    waiter.join();
+    CHECK(acquired);
+    CHECK(fake.created.size() == 1);
+}
+
+void test_trim_frees_idle_contexts() {
+    FakeContexts fake;
+    ContextPool pool = fake.make_pool({{1024, 2048}, 2});
+
+    auto held = pool.acquire(100);
+    pool.acquire(2000);
+    pool.acquire(100).release();
+    CHECK(fake.alive == 2);
+
+    // Only the leased context survives
+    CHECK(pool.trim() == 1);
+    CHECK(fake.alive == 1);
+    CHECK(pool.stats()["trimmed"] == 1);
+
+    held.release();
+    CHECK(pool.trim() == 1);
+    CHECK(fake.alive == 0);
+
+    // The pool stays usable and recreates contexts lazily
+    auto again = pool.acquire(100);
+    CHECK(again && fake.alive == 1);
+}
+
+void test_factory_failure() {
+    ContextPool pool({{1024}, 1}, [](uint32_t) { return static_cast<llama_context*>(nullptr); },
+                     [](llama_context*) {});
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool threw = false;
+        try {
+            pool.acquire(10);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        // The failed slot is released, so the next attempt tries again instead of waiting
+        CHECK(threw);
+    }
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Select Class", test_select_class},
+        {"Lazy Creation And Reuse", test_lazy_creation_and_reuse},
+        {"Upgrade When Class Is Full", test_upgrade_when_class_is_full},
+        {"Waits For Release", test_waits_for_release},
+        {"Trim Frees Idle Contexts", test_trim_frees_idle_contexts},
+        {"Factory Failure", test_factory_failure}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file test_cpu_budget.cpp
+ * @brief Unit tests for the process-wide CPU core budget
+ */
+
+#include "../src/core/CpuBudget.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+void test_lease_returns_cores() {
+    CpuBudget budget(8);
+    {
+        CpuLease lease = budget.acquire("llama", 8);
+        CHECK(lease.cores() == 8);
+        CHECK(budget.stats()["free"] == 0);
+
+        CpuLease moved = std::move(lease);
+        CHECK(!lease);
+        CHECK(moved.cores() == 8);
+    }
+    CHECK(budget.stats()["free"] == 8);
+    CHECK(budget.stats()["consumers"]["llama"]["leases"] == 0);
+
+    // Requests beyond the budget are capped
+    CpuLease all = budget.acquire("llama", 64, 32);
+    CHECK(all.cores() == 8);
+}
+
+void test_consumers_share_by_pressure() {
+    CpuBudget budget(8);
+    CpuLease a = budget.acquire("analyzer", 1);
+    CpuLease b = budget.acquire("analyzer", 1);
+    CpuLease c = budget.acquire("analyzer", 1);
+    // llama: 1 lease against 3 analyzer leases -> a quarter of the cores
+    CpuLease llama = budget.acquire("llama", 8);
+    CHECK(llama.cores() == 2);
+    CHECK(budget.stats()["free"] == 3);
+
+    // Alone again, the lease grows back to what it asked for
+    a.release();
+    b.release();
+    c.release();
+    CHECK(llama.refresh());
+    CHECK(llama.cores() == 8);
+}
+
+void test_waiters_make_holders_yield() {
+    CpuBudget budget(4);
+    CpuLease llama = budget.acquire("llama", 4);
+    CHECK(llama.cores() == 4);
+
+    std::atomic<bool> started{false};
+    std::atomic<size_t> granted{0};
+    std::thread analyzer([&] {
+        started = true;
+        CpuLease lease = budget.acquire("analyzer", 2);
+        granted = lease.cores();
+    });
+    while (!started || budget.stats()["consumers"]["analyzer"]["waiting"] != 1) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // The decode loop refreshes between steps and gives up half the cores
+    CHECK(llama.refresh());
+    CHECK(llama.cores() == 2);
+    analyzer.join();
+    CHECK(granted == 2);
+    CHECK(budget.stats()["consumers"]["llama"]["yielded"] == 2);
+    CHECK(budget.stats()["consumers"]["analyzer"]["wait_ms"].get<double>() > 0.0);
+}
+
+void test_same_consumer_leases_share() {
+    CpuBudget budget(4);
+    CpuLease first = budget.acquire("llama", 4);
+    CHECK(first.cores() == 4);
+
+    std::atomic<bool> started{false};
+    std::atomic<size_t> granted{0};
+    std::thread second([&] {
+        started = true;
+        CpuLease lease = budget.acquire("llama", 4);
+        granted = lease.cores();
+    });
+    while (!started || budget.stats()["consumers"]["llama"]["waiting"] != 1) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // A second generation does not wait for the first to finish: the two split the cores
+    CHECK(first.refresh());
+    CHECK(first.cores() == 2);
+    second.join();
+    CHECK(granted == 2);
+    CHECK(budget.stats()["consumers"]["llama"]["yielded"] == 2);
+
+    // Alone again, the first grows back
+    CHECK(first.refresh());
+    CHECK(first.cores() == 4);
+}
+
+void test_never_oversubscribes() {
+    CpuBudget budget(3);
+    std::atomic<int> in_use{0};
+    std::atomic<int> peak{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 12; ++i) {
+        workers.emplace_back([&, i] {
+            CpuLease lease = budget.acquire(i % 2 ? "analyzer" : "orchestration", 1 + i % 3);
+            int now = in_use += static_cast<int>(lease.cores());
+            int seen = peak;
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            in_use -= static_cast<int>(lease.cores());
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CHECK(peak <= 3);
+    CHECK(budget.stats()["free"] == 3);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Lease Returns Cores", test_lease_returns_cores},
+        {"Consumers Share By Pressure", test_consumers_share_by_pressure},
+        {"Waiters Make Holders Yield", test_waiters_make_holders_yield},
+        {"Same Consumer Leases Share", test_same_consumer_leases_share},
+        {"Never Oversubscribes", test_never_oversubscribes}
+    };
+
+    return run_tests(tests);
+}
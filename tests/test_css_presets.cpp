@@ -0,0 +1,78 @@
+/**
+ * @file test_css_presets.cpp
+ * @brief Unit tests for the compile-time need preset stylesheets
+ */
+
+#include "../src/core/CssPresets.hpp"
+#include "../src/core/InterfacePatcher.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+bool contains(std::string_view haystack, std::string_view needle) {
+    return haystack.find(needle) != std::string_view::npos;
+}
+
+void test_every_combination_is_composed() {
+    for (size_t needs = 0; needs < kCssPresetCount; ++needs) {
+        std::string_view css = need_preset_css(static_cast<uint8_t>(needs));
+        CHECK(contains(css, "body{"));
+        // Needs sharing a rule (epilepsy, anxiety) emit it once
+        CHECK(css.find("animation:none") == css.rfind("animation:none"));
+    }
+    CHECK(need_preset_css(0) != need_preset_css(1));
+}
+
+void test_conflict_resolution() {
+    ProfileFlags flags;
+    flags.set(Need::Dyslexia);
+    flags.set(Need::Anxiety);
+    std::string_view css = need_preset_css(flags.needs);
+    CHECK(contains(css, "OpenDyslexic"));
+    CHECK(contains(css, "background:#fdf6e3"));
+    CHECK(!contains(css, "background:#f4f6f4"));
+
+    flags.set(Need::LowVision);
+    css = need_preset_css(flags.needs);
+    CHECK(contains(css, "color:#000000;background:#fdf6e3"));
+    CHECK(contains(css, "font-size:150%"));
+}
+
+void test_profile_stylesheet_overrides() {
+    ProfileFlags implied = implied_profile(static_cast<uint8_t>(1u << static_cast<uint8_t>(Need::ADHD)));
+    CHECK(profile_stylesheet(implied) == std::string(need_preset_css(implied.needs)));
+
+    ProfileFlags larger = implied;
+    larger.font_scale = 3;
+    CHECK(contains(profile_stylesheet(larger), "font-size:175%"));
+}
+
+void test_apply_replaces_block() {
+    std::string html = "<html><head><title>t</title></head><body><p>x</p></body></html>";
+    ProfileFlags first;
+    first.set(Need::Senior);
+    apply_profile_stylesheet(html, first);
+
+    ProfileFlags second;
+    second.set(Need::Epilepsy);
+    apply_profile_stylesheet(html, second);
+
+    CHECK(html.find("empi-preset") == html.rfind("empi-preset"));
+    CHECK(contains(html, "animation:none"));
+    CHECK(html.find("empi-preset") < html.find("</head>"));
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Every Combination Composed", test_every_combination_is_composed},
+        {"Conflict Resolution", test_conflict_resolution},
+        {"Profile Stylesheet Overrides", test_profile_stylesheet_overrides},
+        {"Apply Replaces Block", test_apply_replaces_block}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,278 @@
+/**
+ * @file test_fork_server.cpp
+ * @brief Unit tests for the zygote fork-server worker pool
+ */
+
+#include "../src/core/ForkServer.hpp"
+#include "../src/core/CpuBudget.hpp"
+#include "TestCheck.hpp"
+#include <algorithm>
+#include <iostream>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>  // For mkstemps
+#include <unistd.h>
+
+using namespace EMPI;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+/// Minimal zygote speaking the analyzer_server.py protocol: echoes requests with the worker pid
+static const char* kZygote = R"(
+import json, os, select, signal, socket, sys, time
+listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+listener.bind(sys.argv[1])
+listener.listen(16)
+signal.signal(signal.SIGCHLD, signal.SIG_IGN)
+print('loading model...')
+print('ready', flush=True)
+while True:
+    readable, _, _ = select.select([listener, sys.stdin], [], [])
+    if sys.stdin in readable and not os.read(0, 1):
+        break
+    if listener not in readable:
+        continue
+    conn, _ = listener.accept()
+    if os.fork() == 0:
+        conn.sendall(b'ready\n')
+        for line in conn.makefile('rb'):
+            request = json.loads(line)
+            time.sleep(request.get('sleep', 0))
+            conn.sendall(json.dumps({'pid': os.getpid(), 'echo': request}).encode() + b'\n')
+        os._exit(0)
+    conn.close()
+os.unlink(sys.argv[1])
+)";
+
+/// kZygote written to a unique temp file, removed at exit
+class ZygoteScript {
+public:
+    ZygoteScript() {
+        path_ = (fs::temp_directory_path() / "empi_test_zygote_XXXXXX.py").string();
+        int fd = mkstemps(path_.data(), 3);
+        if (fd == -1) {
+            throw std::runtime_error("Cannot create zygote script: " + path_);
+        }
+        close(fd);
+        std::ofstream(path_) << kZygote;
+    }
+
+    ~ZygoteScript() {
+        std::error_code ec;
+        fs::remove(path_, ec);
+    }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+static std::vector<std::string> zygote_command() {
+    static ZygoteScript script;
+    return {"python3", script.path()};
+}
+
+/// Polls `condition` until it holds or `timeout` passes; returns whether it held
+static bool wait_until(const std::function<bool()>& condition,
+                       std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+void test_start_and_call() {
+    ForkServer server(zygote_command());
+    server.start();
+    CHECK(server.running());
+    CHECK(server.stats()["workers"] == 1);
+
+    json response = server.call({{"text", "hello"}});
+    CHECK(response["echo"]["text"] == "hello");
+    // The same worker serves consecutive calls
+    CHECK(server.call({{"n", 2}})["pid"] == response["pid"]);
+    CHECK(server.stats()["forked"] == 1);
+    CHECK(server.stats()["requests"] == 2);
+
+    server.stop();
+    CHECK(!server.running());
+    bool threw = false;
+    try {
+        server.call(json::object());
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+void test_grows_with_concurrent_callers() {
+    ForkServerConfig config;
+    config.max_workers = 3;
+    ForkServer server(zygote_command(), config);
+    server.start();
+
+    std::vector<std::thread> callers;
+    std::vector<int> pids(6);
+    for (size_t i = 0; i < pids.size(); ++i) {
+        callers.emplace_back([&server, &pids, i] {
+            pids[i] = server.call({{"sleep", 0.2}})["pid"].get<int>();
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    json stats = server.stats();
+    CHECK(stats["peak_workers"] == 3);
+    CHECK(stats["forked"] == 3);
+    CHECK(std::set<int>(pids.begin(), pids.end()).size() == 3);
+    CHECK(stats["last_fork_ms"].get<double>() > 0.0);
+}
+
+void test_idle_workers_shrink() {
+    ForkServerConfig config;
+    config.max_workers = 4;
+    config.idle_timeout = std::chrono::seconds(0);
+    ForkServer server(zygote_command(), config);
+    server.start();
+
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; ++i) {
+        callers.emplace_back([&server] { server.call({{"sleep", 0.1}}); });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    CHECK(server.stats()["workers"] == 4);
+
+    CHECK(server.trim() == 3);
+    CHECK(server.stats()["workers"] == 1);
+    CHECK(server.stats()["retired"] == 3);
+}
+
+void test_requests_lease_cores() {
+    ForkServerConfig config;
+    config.cpu_consumer = "fork_server_test";
+    ForkServer server(zygote_command(), config);
+    server.start();
+
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 3; ++i) {
+        callers.emplace_back([&server] { server.call({{"sleep", 0.05}}); });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+    json consumer = CpuBudget::global().stats()["consumers"]["fork_server_test"];
+    CHECK(consumer["grants"] == 3);
+    CHECK(consumer["held"] == 0);
+}
+
+void test_dead_worker_is_replaced() {
+    ForkServer server(zygote_command());
+    server.start();
+    int pid = server.call(json::object())["pid"].get<int>();
+    kill(pid, SIGKILL);
+    CHECK(wait_until([pid] { return kill(pid, 0) != 0; }));
+
+    json response = server.call({{"after", "crash"}});
+    CHECK(response["echo"]["after"] == "crash");
+    CHECK(response["pid"] != pid);
+    CHECK(server.stats()["failures"] == 1);
+}
+
+void test_short_lane_not_blocked_by_huge() {
+    ForkServerConfig config;
+    config.max_workers = 2;
+    config.lanes = {{100, 1}, {SIZE_MAX, 1}};
+    ForkServer server(zygote_command(), config);
+    server.start();
+
+    // Three huge requests share one slot: they cannot take the last short slot
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> huge_done(3);
+    std::vector<std::thread> huge;
+    for (size_t i = 0; i < huge_done.size(); ++i) {
+        huge.emplace_back([&server, &huge_done, i] {
+            server.call({{"sleep", 1.0}}, 100000);
+            huge_done[i] = Clock::now();
+        });
+    }
+    // One huge request runs, the other two queue in their lane
+    CHECK(wait_until([&server] { return server.stats()["lanes"][1]["waiting"] == 2; }));
+
+    for (int i = 0; i < 5; ++i) {
+        server.call({{"n", i}}, 50);
+    }
+    Clock::time_point short_done = Clock::now();
+    for (auto& thread : huge) {
+        thread.join();
+    }
+
+    // A short call queued behind a huge one could not finish before that huge one
+    CHECK(short_done < *std::min_element(huge_done.begin(), huge_done.end()));
+    CHECK(server.stats()["lanes"][1]["stolen"] == 0);
+    CHECK(server.stats()["lanes"][0]["requests"] == 5);
+}
+
+void test_short_requests_steal_idle_lane() {
+    ForkServerConfig config;
+    config.max_workers = 2;
+    config.lanes = {{100, 1}, {SIZE_MAX, 1}};
+    ForkServer server(zygote_command(), config);
+    server.start();
+
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 2; ++i) {
+        callers.emplace_back([&server] { server.call({{"sleep", 0.2}}, 10); });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    json stats = server.stats();
+    CHECK(stats["peak_workers"] == 2);
+    CHECK(stats["lanes"][0]["requests"] == 2);
+    CHECK(stats["lanes"][0]["stolen"] == 1);
+}
+
+void test_start_failure() {
+    ForkServerConfig config;
+    config.start_timeout = std::chrono::seconds(5);
+    ForkServer server({"python3", "-c", "import sys; sys.exit(1)"}, config);
+    bool threw = false;
+    try {
+        server.start();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(!server.running());
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Start And Call", test_start_and_call},
+        {"Grows With Concurrent Callers", test_grows_with_concurrent_callers},
+        {"Idle Workers Shrink", test_idle_workers_shrink},
+        {"Requests Lease Cores", test_requests_lease_cores},
+        {"Dead Worker Is Replaced", test_dead_worker_is_replaced},
+        {"Short Lane Not Blocked By Huge", test_short_lane_not_blocked_by_huge},
+        {"Short Requests Steal Idle Lane", test_short_requests_steal_idle_lane},
+        {"Start Failure", test_start_failure}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test_interface_patcher.cpp
+ * @brief Unit tests for deterministic interface patching
+ */
+
+#include "../src/core/InterfacePatcher.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+const std::string kPage =
+    "<!DOCTYPE html>\n<html lang=\"en\">\n<head><title>Water</title><style>body{font-size:14px}</style></head>\n"
+    "<body><main><h1>Water cycle</h1>"
+    "<p>Water evaporates. Vapour condenses into clouds. Rain falls. Rivers carry it back.</p>"
+    "</main></body>\n</html>";
+
+bool contains(const std::string& haystack, const std::string& needle) {
+    return haystack.find(needle) != std::string::npos;
+}
+
+void test_font_scale_is_css_only() {
+    ProfileFlags previous;
+    ProfileFlags current = previous;
+    current.font_scale = 1;
+
+    auto patch = patch_interface(kPage, previous, current);
+    CHECK(patch.applied == std::vector<std::string>{"font_scale"});
+    CHECK(patch.rewrite_instructions.empty());
+    CHECK(contains(patch.html, "<style id=\"empi-patch\" data-base-key=\"0\">"));
+    CHECK(contains(patch.html, "font-size:125%"));
+    CHECK(patch.html.find("empi-patch") < patch.html.find("</head>"));
+}
+
+void test_repeated_patches_replace_block() {
+    ProfileFlags base;
+    ProfileFlags step1 = base;
+    step1.font_scale = 1;
+    ProfileFlags step2 = step1;
+    step2.font_scale = 2;
+    step2.reduce_motion = true;
+
+    auto first = patch_interface(kPage, base, step1);
+    auto second = patch_interface(first.html, step1, step2);
+
+    CHECK(second.html.find("empi-patch") == second.html.rfind("empi-patch"));
+    CHECK(contains(second.html, "font-size:150%"));
+    CHECK(!contains(second.html, "font-size:125%"));
+    CHECK(contains(second.html, "animation:none"));
+
+    auto reverted = patch_interface(second.html, step2, base);
+    CHECK(!contains(reverted.html, "empi-patch"));
+}
+
+void test_normal_contrast_is_not_reported() {
+    ProfileFlags previous;
+    previous.contrast = Contrast::High;
+    ProfileFlags current = previous;
+    current.contrast = Contrast::Normal;
+
+    auto patch = patch_interface(kPage, previous, current);
+    CHECK(patch.applied.empty());
+    CHECK(!contains(patch.html, "empi-patch"));
+}
+
+void test_density_and_content_changes() {
+    ProfileFlags previous;
+    ProfileFlags current;
+    current.set(Need::ADHD);
+    current.density = 1;
+    current.plain_language = true;
+
+    auto patch = patch_interface(kPage, previous, current);
+    CHECK(contains(patch.html, "<p>Water evaporates. Vapour condenses into clouds.</p>\n<p>Rain falls."));
+    CHECK(patch.rewrite_instructions.size() == 2);
+
+    auto range = find_content_fragment(patch.html);
+    CHECK(range);
+    std::string fragment = patch.html.substr(range->begin, range->end - range->begin);
+    CHECK(fragment.rfind("<h1>", 0) == 0);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Font Scale CSS Only", test_font_scale_is_css_only},
+        {"Repeated Patches", test_repeated_patches_replace_block},
+        {"Normal Contrast Not Reported", test_normal_contrast_is_not_reported},
+        {"Density And Content", test_density_and_content_changes}
+    };
+
+    return run_tests(tests);
+}
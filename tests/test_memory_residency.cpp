@@ -0,0 +1,207 @@
+/**
+ * @file test_memory_residency.cpp
+ * @brief Unit tests for model/KV page residency helpers
+ */
+
+#include "../src/core/MemoryResidency.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+namespace fs = std::filesystem;
+
+const size_t kFileSize = 4 * 1024 * 1024;
+
+/// A file mapped read-only, like llama.cpp maps a GGUF
+struct MappedFile {
+    std::string path;
+    void* addr = MAP_FAILED;
+
+    MappedFile() {
+        path = (fs::temp_directory_path() / ("empi_residency_" + std::to_string(getpid()) + ".bin")).string();
+        std::ofstream(path, std::ios::binary) << std::string(kFileSize, 'x');
+        int fd = open(path.c_str(), O_RDONLY);
+        addr = mmap(nullptr, kFileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (addr != MAP_FAILED) munmap(addr, kFileSize);
+        fs::remove(path);
+    }
+};
+
+void test_file_mappings() {
+    MappedFile file;
+    CHECK(file.addr != MAP_FAILED);
+
+    auto ranges = file_mappings(file.path);
+    CHECK(ranges.size() == 1);
+    CHECK(ranges[0].begin == reinterpret_cast<uintptr_t>(file.addr));
+    CHECK(ranges[0].size() == kFileSize);
+
+    CHECK(file_mappings(file.path + ".missing").empty());
+}
+
+void test_prefetch_makes_resident() {
+    MappedFile file;
+    auto ranges = file_mappings(file.path);
+
+    ResidencyConfig config;
+    config.prefetch = true;
+    ResidencyReport report = apply_residency(ranges, config);
+
+    CHECK(report.mapped_bytes == kFileSize);
+    CHECK(report.resident_bytes <= report.mapped_bytes);
+    // The file was just written, so its pages are in the page cache
+    CHECK(report.resident_bytes > 0);
+    json j = report;
+    CHECK(j.contains("warnings") && j["warnings"].is_array());
+}
+
+void test_mlock_falls_back() {
+    MappedFile file;
+    ResidencyConfig config;
+    config.mlock = true;
+    config.huge_pages = true;
+
+    // Without CAP_IPC_LOCK and a small RLIMIT_MEMLOCK this warns instead of failing
+    ResidencyReport report = apply_residency(file_mappings(file.path), config);
+    CHECK(report.mapped_bytes == kFileSize);
+    CHECK(report.locked_bytes <= report.mapped_bytes);
+    if (report.locked_bytes < report.mapped_bytes) {
+        CHECK(!report.warnings.empty());
+    }
+    munlock(file.addr, kFileSize);
+}
+
+void test_new_anonymous_mappings() {
+    auto before = anonymous_mappings();
+    size_t size = 8 * 1024 * 1024;
+    void* buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(buffer != MAP_FAILED);
+    auto added = new_mappings(before, anonymous_mappings());
+
+    bool found = false;
+    for (const auto& range : added) {
+        found |= range.begin <= reinterpret_cast<uintptr_t>(buffer) &&
+                 reinterpret_cast<uintptr_t>(buffer) + size <= range.end;
+    }
+    CHECK(found);
+
+    ModelResidency residency;
+    residency.add_buffers(buffer, added);
+    json report = residency.report();
+    CHECK(report["kv"]["mapped_bytes"].get<uint64_t>() >= size);
+
+    residency.remove_buffers(buffer);
+    munmap(buffer, size);
+    CHECK(residency.report()["kv"]["mapped_bytes"] == 0);
+}
+
+void test_extended_mapping_is_new() {
+    size_t size = 8 * 1024 * 1024;
+    // Reserve twice the size, then give back the upper half so a new buffer can extend the lower one
+    auto* base = static_cast<char*>(mmap(nullptr, 2 * size, PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    CHECK(base != MAP_FAILED);
+    munmap(base + size, size);
+
+    auto before = anonymous_mappings(0);
+    void* extension = mmap(base + size, size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    CHECK(extension == base + size);
+    auto added = new_mappings(before, anonymous_mappings(0), 2 * 1024 * 1024);
+
+    // Whether or not the kernel merged the two, only the extension is new
+    uint64_t added_bytes = 0;
+    for (const auto& range : added) {
+        CHECK(range.end <= reinterpret_cast<uintptr_t>(base) ||
+               range.begin >= reinterpret_cast<uintptr_t>(base + size));
+        if (range.begin >= reinterpret_cast<uintptr_t>(base + size) &&
+            range.end <= reinterpret_cast<uintptr_t>(base + 2 * size)) {
+            added_bytes += range.size();
+        }
+    }
+    CHECK(added_bytes == size);
+
+    // Partial overlaps on both sides leave the uncovered middle
+    std::vector<MemoryRange> old = {{100, 200, ""}, {300, 400, ""}};
+    auto middle = new_mappings(old, {{150, 350, ""}, {400, 405, ""}}, 50);
+    CHECK(middle.size() == 1 && middle[0].begin == 200 && middle[0].end == 300);
+
+    // KV ranges are attributed heuristically, so mlock is never applied to them
+    ModelResidency residency;
+    ResidencyConfig config;
+    config.mlock = true;
+    config.prefetch = false;
+    residency.configure(config);
+    residency.add_buffers(extension, added);
+    CHECK(residency.report()["kv"]["locked_bytes"] == 0);
+    residency.remove_buffers(extension);
+    munmap(base, 2 * size);
+}
+
+bool contains(const std::vector<MemoryRange>& ranges, void* buffer) {
+    auto addr = reinterpret_cast<uintptr_t>(buffer);
+    for (const auto& range : ranges) {
+        if (range.begin <= addr && addr < range.end) return true;
+    }
+    return false;
+}
+
+void test_capture_is_serialized() {
+    size_t size = 8 * 1024 * 1024;
+    void* slow_buffer = nullptr;
+    void* fast_buffer = nullptr;
+    std::vector<MemoryRange> slow_added;
+    std::vector<MemoryRange> fast_added;
+
+    // The slow capture allocates, then waits while the other thread tries to capture its own allocation
+    std::thread slow([&] {
+        slow_added = capture_new_mappings([&] {
+            slow_buffer = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    fast_added = capture_new_mappings([&] {
+        fast_buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    });
+    slow.join();
+    CHECK(slow_buffer != MAP_FAILED && fast_buffer != MAP_FAILED);
+
+    CHECK(!contains(slow_added, fast_buffer));
+    CHECK(!contains(fast_added, slow_buffer));
+    munmap(slow_buffer, size);
+    munmap(fast_buffer, size);
+
+    ModelResidency residency;
+    CHECK(residency.report()["kv"]["attribution"] == "heuristic");
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"File Mappings", test_file_mappings},
+        {"Prefetch Makes Resident", test_prefetch_makes_resident},
+        {"Mlock Falls Back", test_mlock_falls_back},
+        {"New Anonymous Mappings", test_new_anonymous_mappings},
+        {"Extended Mapping Is New", test_extended_mapping_is_new},
+        {"Capture Is Serialized", test_capture_is_serialized}
+    };
+
+    return run_tests(tests);
+}
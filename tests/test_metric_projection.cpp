@@ -0,0 +1,96 @@
+/**
+ * @file test_metric_projection.cpp
+ * @brief Unit tests for requested-metric selection
+ */
+
+#include "../src/core/MetricProjection.hpp"
+#include "../src/core/TextAggregates.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+void test_metric_names_match_payload() {
+    const auto& names = text_metric_names();
+    CHECK(names.size() == 30);
+    CHECK(names.front() == "flesch_kincaid_grade");
+    CHECK(names.back() == "content_token_count");
+
+    // Every name round-trips through the typed payload
+    json all = json::object();
+    for (const auto& name : names) {
+        all[name] = name == "text_standard" ? json("8th grade")
+                  : (name == "has_headings" || name == "has_lists") ? json(true) : json(1);
+    }
+    TextMetricsData metrics = all.get<TextMetricsData>();
+    CHECK(metrics.extra.empty());
+}
+
+void test_resolve_orders_and_adds_required() {
+    auto selected = resolve_metrics(json::array({"word_count", "gunning_fog_index", "word_count"}));
+    CHECK((selected == std::vector<std::string>{
+        "flesch_kincaid_grade", "gunning_fog_index", "word_count"}));
+
+    // The complexity labels need the grade even when nothing else is asked for
+    CHECK(resolve_metrics(json::array()) == std::vector<std::string>{"flesch_kincaid_grade"});
+}
+
+void test_resolve_rejects_invalid_requests() {
+    for (const json& request : {json("word_count"), json::array({"word_count", 3}),
+                                json::array({"reading_time"})}) {
+        bool threw = false;
+        try {
+            resolve_metrics(request);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        CHECK(threw);
+    }
+}
+
+void test_project_clears_unselected() {
+    TextAggregates aggregates;
+    aggregates.character_count = 60;
+    aggregates.letter_count = 48;
+    aggregates.syllable_count = 14;
+    aggregates.word_count = 12;
+    aggregates.sentence_count = 2;
+    aggregates.polysyllable_count = 0;
+    aggregates.words = {"the", "cat", "sat", "on", "the", "mat", "it", "was", "a", "good", "cat", "indeed"};
+    aggregates.sentence_lengths = {6, 6};
+    aggregates.paragraph_count = 1;
+    // Difficult words with their syllables, as text_analyzer.py reports them
+    aggregates.difficult_words = std::map<std::string, int64_t>{{"indeed", 2}, {"good", 1}};
+
+    TextMetricsData metrics = aggregates.finalize();
+    CHECK(metrics.gunning_fog_index && metrics.type_token_ratio);
+
+    project_metrics(metrics, resolve_metrics(json::array({"word_count", "sentence_count"})));
+    CHECK(metrics.flesch_kincaid_grade);
+    CHECK(metrics.word_count == 12);
+    CHECK(metrics.sentence_count == 2);
+    CHECK(!metrics.gunning_fog_index);
+    CHECK(!metrics.type_token_ratio);
+    CHECK(!metrics.paragraph_count);
+
+    json j = metrics;
+    CHECK(j.contains("metadata"));
+    CHECK(!j.contains("smog_index"));
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Metric Names Match Payload", test_metric_names_match_payload},
+        {"Resolve Orders And Adds Required", test_resolve_orders_and_adds_required},
+        {"Resolve Rejects Invalid Requests", test_resolve_rejects_invalid_requests},
+        {"Project Clears Unselected", test_project_clears_unselected}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_minhash.cpp
+ * @brief Unit tests for MinHash near-duplicate clustering
+ */
+
+#include "../src/core/MinHash.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+const std::string kWater =
+    "Water evaporates from oceans and lakes when the sun heats the surface. The vapor rises, "
+    "cools in the upper atmosphere and condenses into clouds. When droplets grow heavy enough "
+    "they fall back to the ground as rain or snow, and rivers carry the water back to the sea.";
+
+const std::string kCells =
+    "Cells are the basic units of life. Every living organism is made of one or more cells, "
+    "and each cell contains genetic material that controls its growth, its division and the "
+    "proteins it produces to keep the organism alive.";
+
+void test_identical_and_reformatted() {
+    MinHashDeduplicator deduplicator;
+    std::string shouted = kWater;
+    for (char& c : shouted) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+    auto reps = deduplicator.add_batch({kWater, kCells, kWater, shouted + "  \n"});
+    CHECK(reps[0] == 0);
+    CHECK(reps[1] == 1);
+    CHECK(reps[2] == 0);
+    CHECK(reps[3] == 0);
+}
+
+void test_near_duplicate() {
+    MinHashDeduplicator deduplicator;
+    std::string edited = kWater;
+    edited.replace(edited.find("heavy"), 5, "large");
+
+    double similarity = MinHashDeduplicator::similarity(
+        deduplicator.signature(kWater), deduplicator.signature(edited));
+    CHECK(similarity > 0.8 && similarity < 1.0);
+    CHECK(MinHashDeduplicator::similarity(
+        deduplicator.signature(kWater), deduplicator.signature(kCells)) < 0.2);
+
+    deduplicator.add(kWater);
+    CHECK(deduplicator.add(edited) == 0);
+    CHECK(deduplicator.add(kCells) == 2);
+}
+
+void test_thread_count_independent() {
+    std::vector<std::string> corpus;
+    for (int i = 0; i < 64; ++i) {
+        corpus.push_back((i % 2 ? kWater : kCells) + " Variant " + std::to_string(i % 5) + ".");
+    }
+
+    MinHashConfig serial_config;
+    serial_config.threads = 1;
+    MinHashConfig parallel_config;
+    parallel_config.threads = 8;
+    MinHashDeduplicator serial(serial_config);
+    MinHashDeduplicator parallel(parallel_config);
+
+    CHECK(serial.add_batch(corpus) == parallel.add_batch(corpus));
+    CHECK(serial.report() == parallel.report());
+}
+
+void test_empty_texts_stay_separate() {
+    MinHashDeduplicator deduplicator;
+    auto reps = deduplicator.add_batch({"", "  ", "!!"});
+    CHECK(reps[0] == 0 && reps[1] == 1 && reps[2] == 2);
+}
+
+void test_report() {
+    MinHashDeduplicator deduplicator;
+    deduplicator.add_batch({kWater, kCells});
+    deduplicator.add_batch({kWater});
+
+    json report = deduplicator.report({"text_0001", "text_0002", "text_0003"});
+    CHECK(report["documents"] == 3);
+    CHECK(report["representatives"] == 2);
+    CHECK(report["duplicates"] == 1);
+    CHECK(report["clusters"].size() == 1);
+    CHECK(report["clusters"][0]["representative"] == "text_0001");
+    CHECK(report["clusters"][0]["duplicates"][0]["id"] == "text_0003");
+    CHECK(report["clusters"][0]["duplicates"][0]["similarity"] == 1.0);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Identical And Reformatted", test_identical_and_reformatted},
+        {"Near Duplicate", test_near_duplicate},
+        {"Thread Count Independent", test_thread_count_independent},
+        {"Empty Texts Stay Separate", test_empty_texts_stay_separate},
+        {"Report", test_report}
+    };
+
+    return run_tests(tests);
+}
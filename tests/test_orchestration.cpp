@@ -7,6 +7,7 @@
 #include "../src/agents/TextAnalyzer.hpp"
 #include "../src/agents/FeedbackAgent.hpp"
 #include "../src/agents/InterfaceGenerator.hpp"
+#include "../src/core/MinHash.hpp"
 #include <iostream>
 #include <fstream>
 #include <chrono>
@@ -66,12 +67,14 @@ void save_cache_to_file(const json& cache, const std::string& filename) {
 
 int main(int argc, char** argv) {
     std::string model_path = "models/Phi-3-mini-4k-instruct-q4.gguf";
+    bool dedup = true;
     
     // Parse command line for model path
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
             model_path = argv[++i];
-            break;
+        } else if (strcmp(argv[i], "--no-dedup") == 0) {
+            dedup = false;
         }
     }
     
@@ -184,6 +187,26 @@ int main(int argc, char** argv) {
     std::cout << "  Failed: " << feedback_errors << "\n";
     std::cout << "  Cache saved to: " << cache_file << "\n";
     
+    // Near-duplicate texts are analyzed and adapted once; their pages are
+    // copied from the cluster representative
+    std::vector<size_t> representatives(num_texts);
+    for (size_t i = 0; i < num_texts; ++i) representatives[i] = i;
+    if (dedup) {
+        std::vector<std::string> contents, ids;
+        for (const auto& text_item : texts) {
+            contents.push_back(text_item["content"]);
+            ids.push_back(text_item["id"]);
+        }
+        MinHashDeduplicator deduplicator;
+        deduplicator.add_batch(contents);
+        for (size_t i = 0; i < num_texts; ++i) representatives[i] = deduplicator.representative(i);
+
+        json report = deduplicator.report(ids);
+        std::ofstream("output/dedup_report.json") << report.dump(2);
+        std::cout << "\nDeduplication: " << report["representatives"] << " representatives for "
+                  << num_texts << " texts (report: output/dedup_report.json)\n";
+    }
+    
     // STEP 2: Generate interfaces for all combinations
     std::cout << "\n========================================\n";
     std::cout << "STEP 2: Generating interfaces (using cached feedback)\n";
@@ -192,6 +215,7 @@ int main(int argc, char** argv) {
     size_t interface_success = 0;
     size_t interface_errors = 0;
     size_t interface_skipped = 0;
+    size_t interface_copied = 0;
     
     // Check for existing HTML files
     std::unordered_map<std::string, bool> existing_html;
@@ -209,6 +233,23 @@ int main(int argc, char** argv) {
         std::string text_id = text_item["id"];
         std::string text_content = text_item["content"];
         
+        if (representatives[i] != i) {
+            std::string rep_num = extract_id(texts[representatives[i]]["id"].get<std::string>());
+            std::string text_num = extract_id(text_id);
+            for (size_t j = 0; j < num_dialogues; ++j) {
+                std::string dial_num = extract_id(dialogues[j]["id"].get<std::string>());
+                std::string source = "output/template_" + rep_num + "_" + dial_num + ".html";
+                std::string target = "output/template_" + text_num + "_" + dial_num + ".html";
+                std::error_code ec;
+                if (!std::filesystem::exists(target) && std::filesystem::copy_file(source, target, ec)) {
+                    interface_copied++;
+                }
+            }
+            std::cout << "\n>>> Text " << text_id << " duplicates "
+                      << texts[representatives[i]]["id"].get<std::string>() << ", pages copied\n";
+            continue;
+        }
+        
         std::cout << "\n>>> Processing text " << (i+1) << "/" << num_texts 
                   << " (ID: " << text_id << ")\n";
         std::cout << ">>> Text preview: " << text_content.substr(0, 50) << "...\n";
@@ -266,9 +307,12 @@ int main(int argc, char** argv) {
             
             try {
                 // Generate interface using cached feedback
+                ProfileFlags profile = derive_profile_flags(
+                    dialogue_item["history"], cache_it->second.get<FeedbackAnalysisData>());
                 json interface_input = {
                     {"text_metrics", text_metrics},
                     {"feedback_analysis", cache_it->second},
+                    {"profile_flags", profile},
                     {"original_text", text_content}
                 };
                 
@@ -308,8 +352,12 @@ int main(int argc, char** argv) {
     std::cout << "Feedback cached: " << feedback_success << " / " << num_dialogues << "\n";
     std::cout << "Interfaces generated: " << interface_success << " / " << num_texts * num_dialogues << "\n";
     std::cout << "Interfaces skipped (already exist): " << interface_skipped << "\n";
+    std::cout << "Interfaces copied from duplicate texts: " << interface_copied << "\n";
     std::cout << "Interface errors: " << interface_errors << "\n";
     std::cout << "Time: " << elapsed.count() << " seconds\n";
+    std::cout << "Page cache: " << interface_gen.get_cache_stats().dump() << "\n";
+    std::cout << "Contexts: feedback " << feedback_agent.get_context_stats().dump()
+              << ", interface " << interface_gen.get_context_stats().dump() << "\n";
     std::cout << "HTML files saved in 'output/' directory\n";
     std::cout << "Feedback cache saved in 'output/feedback_cache.json'\n";
     
@@ -0,0 +1,81 @@
+/**
+ * @file test_page_validator.cpp
+ * @brief Unit tests for in-process WCAG page validation
+ */
+
+#include "../src/core/PageValidator.hpp"
+#include "../src/core/CssPresets.hpp"
+#include "../src/core/InterfacePatcher.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+const std::string kPage =
+    "<!DOCTYPE html>\n<html lang=\"en\">\n<head><title>Water</title></head>\n"
+    "<body><main><h1>Water cycle</h1><h2>Steps</h2>"
+    "<p>Water evaporates.</p><img src=\"cycle.png\" alt=\"Diagram of the water cycle\">"
+    "<a href=\"#more\">Read about clouds</a>"
+    "<label for=\"q\">Question</label><input id=\"q\" type=\"text\">"
+    "</main></body>\n</html>";
+
+bool has_criterion(const PageValidation& validation, const std::string& criterion, IssueSeverity severity) {
+    for (const auto& issue : validation.issues) {
+        if (issue.criterion == criterion && issue.severity == severity) return true;
+    }
+    return false;
+}
+
+void test_valid_page() {
+    PageValidation validation = validate_page(kPage);
+    CHECK(validation.valid);
+    CHECK(validation.count(IssueSeverity::Warning) == 0);
+}
+
+void test_errors() {
+    std::string page = kPage;
+    page.replace(page.find(" alt=\"Diagram of the water cycle\""), 32, "");
+    page.replace(page.find("<h2>"), 4, "<h2 id=\"q\">");
+    PageValidation validation = validate_page(page);
+    CHECK(!validation.valid);
+    CHECK(has_criterion(validation, "1.1.1", IssueSeverity::Error));
+    CHECK(has_criterion(validation, "4.1.1", IssueSeverity::Error));
+
+    PageValidation truncated = validate_page(kPage.substr(0, kPage.size() / 2));
+    CHECK(!truncated.valid);
+
+    PageValidation empty_link = validate_page("<html lang=\"en\"><body><a href=\"/\"> </a></body></html>");
+    CHECK(has_criterion(empty_link, "2.4.4", IssueSeverity::Error));
+}
+
+void test_contrast() {
+    CHECK(std::fabs(contrast_ratio("#000", "#ffffff") - 21.0) < 1e-6);
+    CHECK(contrast_ratio("red", "#fff") == 0.0);
+
+    std::string page = kPage;
+    page.insert(page.find("</head>"), "<style>body{color:#999;background:#fff}</style>");
+    CHECK(has_criterion(validate_page(page), "1.4.3", IssueSeverity::Error));
+}
+
+void test_every_preset_passes() {
+    for (size_t needs = 0; needs < kCssPresetCount; ++needs) {
+        std::string page = kPage;
+        apply_profile_stylesheet(page, implied_profile(static_cast<uint8_t>(needs)));
+        CHECK(validate_page(page).valid);
+    }
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Valid Page", test_valid_page},
+        {"Errors", test_errors},
+        {"Contrast", test_contrast},
+        {"Every Preset Passes", test_every_preset_passes}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_payloads.cpp
+ * @brief Unit tests for typed EMPI payloads and their JSON/binary serializers
+ */
+
+#include "../src/core/Payloads.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+void test_text_metrics_json_roundtrip() {
+    json python_output = {
+        {"flesch_kincaid_grade", 9.23},
+        {"difficult_word_count", 74},
+        {"text_standard", "11th and 12th grade"},
+        {"has_lists", true},
+        {"metadata", {{"spacy_available", true}}}
+    };
+
+    auto metrics = python_output.get<TextMetricsData>();
+    CHECK(metrics.flesch_kincaid_grade && *metrics.flesch_kincaid_grade == 9.23);
+    CHECK(metrics.difficult_word_count && *metrics.difficult_word_count == 74);
+    CHECK(metrics.has_lists && *metrics.has_lists);
+    CHECK(!metrics.smog_index);
+    CHECK(metrics.extra.contains("metadata"));
+
+    json back = metrics;
+    CHECK(back == python_output);
+}
+
+void test_feedback_tolerates_loose_llm_output() {
+    json llm_output = {
+        {"sentiment", "negative"},
+        {"topics", {"ADHD", 3}},
+        {"satisfaction_score", "low"},
+        {"complaints", json::array()},
+        {"feedback_summary", "Too long"}
+    };
+
+    auto analysis = llm_output.get<FeedbackAnalysisData>();
+    CHECK(analysis.sentiment == "negative");
+    CHECK(analysis.topics.size() == 2 && analysis.topics[1] == "3");
+    CHECK(analysis.satisfaction_score == 0.5);
+    CHECK(analysis.extra["satisfaction_score"] == "low");
+
+    json back = analysis;
+    CHECK(back["satisfaction_score"] == 0.5);
+}
+
+void test_binary_roundtrip() {
+    TextMetricsData metrics;
+    metrics.flesch_kincaid_grade = 12.5;
+    metrics.word_count = 211;
+    metrics.text_standard = "college";
+    metrics.extra["metadata"] = {{"language", "en"}};
+
+    auto decoded = from_binary<TextMetricsData>(to_binary(metrics));
+    CHECK(json(decoded) == json(metrics));
+
+    FeedbackAnalysisData analysis;
+    analysis.topics = {"dyslexia", "fonts"};
+    analysis.feedback_summary = "Prefers larger fonts";
+    auto decoded_analysis = from_binary<FeedbackAnalysisData>(to_binary(analysis));
+    CHECK(json(decoded_analysis) == json(analysis));
+
+    HTMLGenerationData page{"<html></html>", 13};
+    std::string bytes = to_binary(page);
+    bytes.pop_back();
+    bool threw = false;
+    try {
+        from_binary<HTMLGenerationData>(bytes);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"TextMetrics JSON Roundtrip", test_text_metrics_json_roundtrip},
+        {"Feedback Loose LLM Output", test_feedback_tolerates_loose_llm_output},
+        {"Binary Roundtrip", test_binary_roundtrip}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_profile_flags.cpp
+ * @brief Unit tests for ProfileFlags derivation, packing and hashing
+ */
+
+#include "../src/core/ProfileFlags.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+json user_dialog(const std::string& text) {
+    return json::array({
+        {{"role", "user"}, {"content", text}},
+        {{"role", "assistant"}, {"content", "Sure, I can use high contrast, OpenDyslexic and calm colors."}}
+    });
+}
+
+void test_derives_needs_from_user_messages() {
+    FeedbackAnalysisData analysis;
+    auto flags = derive_profile_flags(
+        user_dialog("I have low vision and dyslexia. Large OpenDyslexic font, high contrast."), analysis);
+
+    CHECK(flags.has(Need::LowVision));
+    CHECK(flags.has(Need::Dyslexia));
+    CHECK(!flags.has(Need::Anxiety));
+    CHECK(flags.font_scale >= 2);
+    CHECK(flags.contrast == Contrast::High);
+    CHECK(!flags.calm_colors);
+}
+
+void test_rewording_maps_to_same_key() {
+    FeedbackAnalysisData analysis;
+    auto a = derive_profile_flags(user_dialog("I have ADHD. Please keep paragraphs short."), analysis);
+    auto b = derive_profile_flags(user_dialog("ADHD here - long paragraphs lose me."), analysis);
+    CHECK(a == b);
+    CHECK(std::hash<ProfileFlags>{}(a) == std::hash<ProfileFlags>{}(b));
+
+    auto c = derive_profile_flags(user_dialog("I have epilepsy. No flashing content at all."), analysis);
+    CHECK(a != c);
+    CHECK(c.reduce_motion);
+
+    std::unordered_set<ProfileFlags> seen = {a, b, c};
+    CHECK(seen.size() == 2);
+}
+
+void test_key_roundtrip() {
+    ProfileFlags flags;
+    flags.set(Need::ASD);
+    flags.set(Need::Senior);
+    flags.font_scale = 1;
+    flags.contrast = Contrast::Low;
+    flags.density = 2;
+    flags.plain_language = true;
+
+    CHECK(ProfileFlags::from_key(flags.key()) == flags);
+
+    json j = flags;
+    CHECK(j["needs"] == json::array({"asd", "senior"}));
+    CHECK(j["contrast"] == "low");
+    CHECK(j.get<ProfileFlags>() == flags);
+    CHECK(json(flags.key()).get<ProfileFlags>() == flags);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Derive Needs", test_derives_needs_from_user_messages},
+        {"Rewording Same Key", test_rewording_maps_to_same_key},
+        {"Key Roundtrip", test_key_roundtrip}
+    };
+
+    return run_tests(tests);
+}
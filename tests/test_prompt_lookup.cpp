@@ -0,0 +1,81 @@
+/**
+ * @file test_prompt_lookup.cpp
+ * @brief Unit tests for prompt-lookup draft proposal
+ */
+
+#include "../src/core/PromptLookup.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+void test_copies_continuation() {
+    // "the water cycle moves water around the earth" ... "the water"
+    PromptLookup lookup;
+    lookup.reset({1, 2, 3, 4, 2, 5, 1, 6, 9, 1, 2});
+
+    // Suffix (1, 2) occurred at the start, followed by 3 4 2 5 ...
+    std::vector<int32_t> draft = lookup.draft();
+    CHECK((draft == std::vector<int32_t>{3, 4, 2, 5, 1, 6, 9, 1}));
+}
+
+void test_prefers_longest_and_latest() {
+    PromptLookupConfig config;
+    config.max_draft = 2;
+    PromptLookup lookup(config);
+    // (7, 8) is followed by 10 early and by 20 later; (6, 7, 8) only by 30
+    lookup.reset({7, 8, 10, 0, 7, 8, 20, 0, 6, 7, 8, 30, 0, 6, 7, 8});
+    CHECK((lookup.draft() == std::vector<int32_t>{30, 0}));
+
+    lookup.reset({7, 8, 10, 0, 7, 8, 20, 0, 7, 8});
+    CHECK((lookup.draft() == std::vector<int32_t>{20, 0}));
+}
+
+void test_no_match() {
+    PromptLookup lookup;
+    lookup.reset({1, 2, 3, 4, 5});
+    CHECK(lookup.draft().empty());
+
+    lookup.reset({});
+    CHECK(lookup.draft().empty());
+    lookup.push(1);
+    CHECK(lookup.draft().empty());
+}
+
+void test_tracks_generated_tokens() {
+    PromptLookup lookup;
+    lookup.reset({11, 12, 13, 14, 15});
+    lookup.push(0);
+    lookup.push(11);
+    CHECK(lookup.draft().empty());
+    lookup.push(12);
+    // Generated (11, 12) matches the prompt; the draft stops at the end of history
+    CHECK((lookup.draft() == std::vector<int32_t>{13, 14, 15, 0, 11, 12}));
+    CHECK(lookup.size() == 8);
+}
+
+void test_stats_json() {
+    SpeculationStats stats;
+    stats.drafted = 40;
+    stats.accepted = 30;
+    stats.decode_calls = 25;
+    json j = stats;
+    CHECK(j["acceptance_rate"] == 0.75);
+    CHECK(j["decode_calls"] == 25);
+    CHECK(SpeculationStats{}.acceptance_rate() == 0.0);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Copies Continuation", test_copies_continuation},
+        {"Prefers Longest And Latest", test_prefers_longest_and_latest},
+        {"No Match", test_no_match},
+        {"Tracks Generated Tokens", test_tracks_generated_tokens},
+        {"Stats Json", test_stats_json}
+    };
+
+    return run_tests(tests);
+}
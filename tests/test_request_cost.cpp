@@ -0,0 +1,171 @@
+/**
+ * @file test_request_cost.cpp
+ * @brief Unit tests for per-request cost accounting
+ */
+
+#include "../src/core/RequestCost.hpp"
+#include "../src/core/UniversalAgent.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+/// Agent whose handler records a fixed cost and burns some CPU
+class CostlyAgent : public UniversalAgent {
+public:
+    CostlyAgent() : UniversalAgent("costly_agent") {
+        register_handler("costly_agent",
+            [](const json& input, const json&, json&) { return input; },
+            [](const json& input, const json&, json&) {
+                record_tokens(input.value("prompt", 0), input.value("generated", 0));
+                record_cache_hit();
+                volatile double sink = 0;
+                for (int i = 0; i < 2000000; ++i) sink = sink + i * 0.5;
+                return json{{"status", "success"}};
+            });
+    }
+};
+
+/// Agent that counts requests in φ and names each response after its count in ψ
+class CountingAgent : public UniversalAgent {
+public:
+    CountingAgent() : UniversalAgent("counting_agent") {
+        register_handler("counting_agent",
+            [](const json& input, const json&, json& state) {
+                state["requests"] = state.value("requests", 0) + 1;
+                return input;
+            },
+            [](const json&, const json&, json& state) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                return json{{"status", "success"}, {"id", state.value("requests", 0)}};
+            });
+    }
+};
+
+void test_records_outside_request_are_ignored() {
+    CHECK(current_request_cost() == nullptr);
+    record_tokens(10, 20);
+    record_cache_hit();
+    record_python_ms(5);
+    record_queue_wait_ms(5);
+}
+
+void test_scope_collects_counters() {
+    RequestCostScope scope;
+    CHECK(current_request_cost() == &scope);
+    record_tokens(100, 40);
+    record_tokens(10, 2);
+    record_cache_hit();
+    record_python_ms(12.5);
+    record_queue_wait_ms(3.25);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    RequestCost cost = scope.snapshot();
+    CHECK(cost.prompt_tokens == 110);
+    CHECK(cost.generated_tokens == 42);
+    CHECK(cost.cache_hits == 1);
+    CHECK(cost.python_ms == 12.5);
+    CHECK(cost.queue_wait_ms == 3.25);
+    CHECK(cost.wall_ms >= 20.0);
+    // Sleeping uses no CPU
+    CHECK(cost.cpu_ms < cost.wall_ms);
+}
+
+void test_nested_scopes_roll_up() {
+    RequestCostScope outer;
+    record_tokens(5, 5);
+    {
+        RequestCostScope inner;
+        record_tokens(1, 2);
+        CHECK(inner.snapshot().prompt_tokens == 1);
+        CHECK(outer.snapshot().prompt_tokens == 5);
+    }
+    CHECK(current_request_cost() == &outer);
+    RequestCost cost = outer.snapshot();
+    CHECK(cost.prompt_tokens == 6);
+    CHECK(cost.generated_tokens == 7);
+}
+
+void test_worker_binding() {
+    RequestCostScope scope;
+    RequestCostScope* cost = current_request_cost();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back([cost] {
+            RequestCostBinding binding(cost);
+            for (int n = 0; n < 1000; ++n) {
+                record_python_ms(1.0);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CHECK(scope.snapshot().python_ms == 4000.0);
+}
+
+void test_response_metadata() {
+    CostlyAgent agent;
+    json response = agent.process_raw({{"prompt", 300}, {"generated", 120}});
+    const json& cost = response["payload"]["metadata"]["cost"];
+    CHECK(cost["prompt_tokens"] == 300);
+    CHECK(cost["generated_tokens"] == 120);
+    CHECK(cost["cache_hits"] == 1);
+    CHECK(cost["cpu_ms"].get<double>() > 0.0);
+    CHECK(cost["wall_ms"].get<double>() >= cost["cpu_ms"].get<double>() * 0.5);
+    for (const char* key : {"python_ms", "queue_wait_ms"}) {
+        CHECK(cost.contains(key));
+    }
+
+    // Errors are accounted for as well
+    json error = agent.process_raw({}, "unknown_task");
+    CHECK(error["payload"]["metadata"].contains("cost"));
+    CHECK(current_request_cost() == nullptr);
+}
+
+void test_concurrent_requests() {
+    CountingAgent agent;
+    const int threads = 8;
+    const int per_thread = 200;
+    std::vector<std::vector<int>> ids(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&agent, &ids, t] {
+            for (int n = 0; n < per_thread; ++n) {
+                json response = agent.process_raw(json::object());
+                ids[t].push_back(response["payload"]["data"].value("id", 0));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Every increment survives and every request saw its own count
+    CHECK(agent.get_agent_state()["requests"] == threads * per_thread);
+    std::set<int> unique;
+    for (const auto& thread_ids : ids) {
+        unique.insert(thread_ids.begin(), thread_ids.end());
+    }
+    CHECK(unique.size() == static_cast<size_t>(threads * per_thread));
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Records Outside Request Are Ignored", test_records_outside_request_are_ignored},
+        {"Scope Collects Counters", test_scope_collects_counters},
+        {"Nested Scopes Roll Up", test_nested_scopes_roll_up},
+        {"Worker Binding", test_worker_binding},
+        {"Response Metadata", test_response_metadata},
+        {"Concurrent Requests", test_concurrent_requests}
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,97 @@
+/**
+ * @file test_semantic_cache.cpp
+ * @brief Unit tests for the exact/approximate InterfaceGenerator page cache
+ */
+
+#include "../src/core/SemanticCache.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+ProfileFlags adhd_profile() {
+    ProfileFlags flags;
+    flags.set(Need::ADHD);
+    flags.density = 1;
+    return flags;
+}
+
+void test_exact_and_approximate_tiers() {
+    SemanticCache cache;
+    uint64_t text = SemanticCache::hash_text("The water cycle describes the movement of water.");
+    ProfileFlags base = adhd_profile();
+    cache.insert(text, base, "<html>adhd</html>");
+
+    auto exact = cache.lookup(text, base);
+    CHECK(exact && exact->tier == SemanticCache::Tier::Exact && exact->value == "<html>adhd</html>");
+
+    ProfileFlags larger_font = base;
+    larger_font.font_scale = 1;
+    auto approximate = cache.lookup(text, larger_font);
+    CHECK(approximate && approximate->tier == SemanticCache::Tier::Approximate);
+    CHECK(approximate->distance == 1.0f);
+    CHECK(approximate->profile.key() == base.key());
+
+    ProfileFlags epilepsy = base;
+    epilepsy.reduce_motion = true;
+    CHECK(!cache.lookup(text, epilepsy));
+
+    ProfileFlags dyslexia = base;
+    dyslexia.set(Need::Dyslexia);
+    CHECK(!cache.lookup(text, dyslexia));
+
+    CHECK(!cache.lookup(SemanticCache::hash_text("Another text"), base));
+}
+
+void test_threshold_report() {
+    SemanticCacheConfig config;
+    config.max_distance = 0.0f;
+    SemanticCache cache(config);
+    uint64_t text = SemanticCache::hash_text("Photosynthesis");
+    cache.insert(text, adhd_profile(), "page");
+
+    ProfileFlags near = adhd_profile();
+    near.calm_colors = true;
+    ProfileFlags far = adhd_profile();
+    far.set(Need::Senior);
+
+    cache.lookup(text, adhd_profile());
+    cache.lookup(text, near);
+    cache.lookup(text, far);
+
+    json stats = cache.stats();
+    CHECK(stats["lookups"] == 3);
+    CHECK(stats["exact_hits"] == 1);
+    CHECK(stats["approximate_hits"] == 0);
+    CHECK(stats["hit_rate_by_threshold"]["1"].get<double>() > stats["hit_rate"].get<double>());
+}
+
+void test_lru_eviction() {
+    SemanticCacheConfig config;
+    config.max_entries = 2;
+    SemanticCache cache(config);
+
+    cache.insert(1, adhd_profile(), "a");
+    cache.insert(2, adhd_profile(), "b");
+    cache.lookup(1, adhd_profile());
+    cache.insert(3, adhd_profile(), "c");
+
+    CHECK(cache.lookup(1, adhd_profile()));
+    CHECK(!cache.lookup(2, adhd_profile()));
+    CHECK(cache.lookup(3, adhd_profile()));
+    CHECK(cache.stats()["entries"] == 2);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Exact And Approximate Tiers", test_exact_and_approximate_tiers},
+        {"Threshold Report", test_threshold_report},
+        {"LRU Eviction", test_lru_eviction}
+    };
+
+    return run_tests(tests);
+}
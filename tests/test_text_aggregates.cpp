@@ -0,0 +1,192 @@
+/**
+ * @file test_text_aggregates.cpp
+ * @brief Unit tests for chunked text analysis (split, merge, finalize)
+ */
+
+#include "../src/core/TextAggregates.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+/**
+ * @brief Stand-in for the Python aggregate mode: counts words, sentences and paragraphs.
+ */
+TextAggregates fake_aggregates(const std::string& text) {
+    json j;
+    std::vector<std::string> words;
+    std::istringstream stream(text);
+    for (std::string word; stream >> word;) words.push_back(word);
+
+    std::vector<int64_t> sentence_lengths;
+    int64_t current = 0;
+    for (const auto& word : words) {
+        current++;
+        if (word.back() == '.') {
+            sentence_lengths.push_back(current);
+            current = 0;
+        }
+    }
+    int64_t paragraphs = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find("\n\n", pos);
+        if (end == std::string::npos) end = text.size();
+        if (text.find_first_not_of(" \n", pos) < end) paragraphs++;
+        pos = end + 2;
+    }
+
+    j["words"] = words;
+    j["sentence_lengths"] = sentence_lengths;
+    j["paragraph_count"] = paragraphs;
+    j["character_count"] = text.size();
+    j["letter_count"] = text.size() / 2;
+    j["syllable_count"] = words.size() * 3 / 2;
+    j["word_count"] = words.size();
+    j["sentence_count"] = sentence_lengths.size();
+    j["polysyllable_count"] = words.size() / 10;
+    j["difficult_words"] = json::object();
+    for (const auto& word : words) {
+        if (word.size() > 9) j["difficult_words"][word] = static_cast<int64_t>(word.size() / 3);
+    }
+    // Like Linsear Write, depends only on the start of the text
+    j["linsear_write_score"] = words.empty() ? 0.0 : static_cast<double>(words.front().size());
+    return j.get<TextAggregates>();
+}
+
+std::string make_document(size_t paragraphs) {
+    const std::vector<std::string> sentences = {
+        "Water evaporates from the ocean surface.",
+        "Condensation forms clouds high above mountains.",
+        "Precipitation returns moisture to rivers.",
+        "Photosynthesis converts sunlight into chemical energy.",
+        "Roots absorb water and dissolved minerals."
+    };
+    std::string text;
+    for (size_t p = 0; p < paragraphs; ++p) {
+        for (size_t s = 0; s <= p % 4; ++s) {
+            text += sentences[(p + s) % sentences.size()] + " ";
+        }
+        text += "\n\n";
+    }
+    return text;
+}
+
+void test_split_roundtrip() {
+    std::string text = make_document(200);
+    auto chunks = split_paragraph_chunks(text, 1000);
+    CHECK(chunks.size() > 5);
+
+    std::string joined;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        joined += chunks[i];
+        if (i + 1 < chunks.size()) {
+            CHECK(chunks[i].size() >= 1000);
+            CHECK(chunks[i].compare(chunks[i].size() - 2, 2, "\n\n") == 0);
+        }
+    }
+    CHECK(joined == text);
+
+    // Only paragraph breaks after a sentence end are cut, and never before trailing blanks
+    std::string sentence = std::string(50, 'a') + ".";
+    CHECK(split_paragraph_chunks(sentence + "\n\n" + sentence, 10).size() == 2);
+    CHECK(split_paragraph_chunks(std::string(50, 'a') + "\n\n" + sentence, 10).size() == 1);
+    CHECK(split_paragraph_chunks(sentence + "\n" + sentence, 10).size() == 1);
+    CHECK(split_paragraph_chunks(sentence + "\n\n  \n", 10).size() == 1);
+    CHECK(split_paragraph_chunks(std::string(500, 'a'), 10).size() == 1);
+}
+
+void test_chunked_equals_whole() {
+    std::string text = make_document(150);
+    json whole;
+    {
+        TextAggregates single = fake_aggregates(text);
+        whole = single.finalize();
+    }
+
+    for (size_t target : {300, 1000, 4000}) {
+        TextAggregates merged;
+        for (const auto& chunk : split_paragraph_chunks(text, target)) {
+            merged.merge(fake_aggregates(chunk));
+        }
+        json chunked = merged.finalize();
+        chunked["metadata"].erase("chunks");
+        json expected = whole;
+        expected["metadata"].erase("chunks");
+
+        // Derived fake counts (letters, syllables) round per chunk; compare the exact ones
+        for (const char* key : {"word_count", "sentence_count", "paragraph_count", "type_token_ratio",
+                                "unique_word_count", "lexical_diversity_score", "paragraph_sentence_ratio",
+                                "average_paragraph_length_words", "difficult_word_count",
+                                "linsear_write_score", "metadata"}) {
+            CHECK(chunked[key] == expected[key]);
+        }
+    }
+}
+
+void test_merge_is_associative() {
+    std::string text = make_document(60);
+    auto chunks = split_paragraph_chunks(text, 500);
+    CHECK(chunks.size() >= 3);
+
+    TextAggregates left;
+    for (const auto& chunk : chunks) left.merge(fake_aggregates(chunk));
+
+    TextAggregates tail;
+    for (size_t i = 1; i < chunks.size(); ++i) tail.merge(fake_aggregates(chunks[i]));
+    TextAggregates right = fake_aggregates(chunks[0]);
+    right.merge(tail);
+
+    CHECK(json(left.finalize()) == json(right.finalize()));
+}
+
+void test_formulas_from_sums() {
+    json j = {
+        {"words", std::vector<std::string>(100, "word")},
+        {"sentence_lengths", std::vector<int64_t>(5, 20)},
+        {"paragraph_count", 2},
+        {"character_count", 500},
+        {"letter_count", 480},
+        {"syllable_count", 150},
+        {"word_count", 100},
+        {"sentence_count", 5},
+        {"polysyllable_count", 10},
+        {"difficult_words", {{"photosynthesis", 5}, {"precipitation", 5}, {"river", 2}, {"sun", 1}}},
+        {"linsear_write_score", 9.5}
+    };
+    TextMetricsData metrics = j.get<TextAggregates>().finalize();
+
+    // 0.39 * 20 + 11.8 * 1.5 - 15.59, rounded to one decimal like textstat
+    CHECK(*metrics.flesch_kincaid_grade == 9.9);
+    // 206.835 - 1.015 * 20 - 84.6 * 1.5
+    CHECK(*metrics.flesch_reading_ease == 59.64);
+    // Gunning Fog counts words of 3+ syllables, the difficult-word count 2+, Dale-Chall all of them
+    CHECK(*metrics.gunning_fog_index == 8.8);
+    CHECK(*metrics.difficult_word_count == 3);
+    // 4% difficult words stays under Dale-Chall's 5% adjustment
+    CHECK(*metrics.dale_chall_score == 1.62);
+    CHECK(*metrics.smog_index == 11.2);
+    // Coleman-Liau from characters and sentences per 100 words, each rounded first
+    CHECK(*metrics.coleman_liau_index == 11.72);
+    CHECK(*metrics.automated_readability_index == 12.1);
+    CHECK(*metrics.paragraph_count == 2);
+    CHECK(*metrics.type_token_ratio == 0.01);
+    CHECK(*metrics.text_standard == "9th and 10th grade");
+    CHECK(!metrics.pronoun_density);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Split Roundtrip", test_split_roundtrip},
+        {"Chunked Equals Whole", test_chunked_equals_whole},
+        {"Merge Is Associative", test_merge_is_associative},
+        {"Formulas From Sums", test_formulas_from_sums}
+    };
+
+    return run_tests(tests);
+}
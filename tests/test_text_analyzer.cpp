@@ -4,14 +4,18 @@
  */
 
 #include "../src/agents/TextAnalyzer.hpp"
+#include "../src/core/MetricProjection.hpp"
 #include "../src/core/UniversalAgent.hpp"
+#include "TestCheck.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <cassert>
 #include <filesystem>
 #include <chrono>
 #include <iomanip>
+#include <optional>
+#include <thread>
+#include <vector>
 
 using namespace EMPI;
 using json = nlohmann::json;
@@ -134,8 +138,8 @@ void test_empi_protocol() {
     logger.log_json("Response", result);
     
     // Validate structure
-    assert(result.contains("header"));
-    assert(result.contains("payload"));
+    CHECK(result.contains("header"));
+    CHECK(result.contains("payload"));
     
     auto& data = result["payload"]["data"];
     std::string status = data["status"];
@@ -426,6 +430,102 @@ void test_edge_cases() {
     }
 }
 
+void test_chunked_matches_whole() {
+    TestLogger logger("Chunked Analysis Matches Whole Text");
+    
+#ifndef EMPI_CHUNKED_ANALYSIS
+    logger.log(TestLogger::Level::WARNING, "Chunked analysis not enabled in this build");
+    return;
+#endif
+    TextAnalyzer analyzer;
+    
+    if (!analyzer.is_available()) {
+        logger.log(TestLogger::Level::WARNING, "Agent not available");
+        return;
+    }
+    
+    std::string filename = "tests/texts.json";
+    if (!fs::exists(filename)) {
+        filename = "../tests/texts.json";
+    }
+    if (!fs::exists(filename)) {
+        logger.log(TestLogger::Level::WARNING, "Texts not found: " + filename);
+        return;
+    }
+    
+    // Real paragraphs, repeated into a document of several chunks
+    json texts = json::parse(load_sample_text(filename));
+    std::string document;
+    while (document.size() < 40000) {
+        for (const auto& text : texts["texts"]) {
+            document += text["content"].get<std::string>() + "\n\n";
+        }
+    }
+    
+    // spaCy tags tokens at chunk edges without context, so its densities are left out
+    std::vector<std::string> metrics;
+    for (const auto& name : text_metric_names()) {
+        if (name != "pronoun_density" && name != "determiner_density" &&
+            name != "anaphora_density" && name != "content_token_count") {
+            metrics.push_back(name);
+        }
+    }
+    
+    analyzer.set_chunking(0);
+    json whole = analyzer.analyze(document, "en", metrics);
+    analyzer.set_chunking(6000, 3);
+    json chunked = analyzer.analyze(document, "en", metrics);
+    
+    CHECK(chunked["metadata"]["chunks"].get<int>() > 1);
+    whole.erase("metadata");
+    chunked.erase("metadata");
+    for (auto& [key, value] : whole.items()) {
+        if (chunked[key] != value) {
+            logger.log(TestLogger::Level::ERROR,
+                key + ": whole " + value.dump() + ", chunked " + chunked[key].dump());
+        }
+    }
+    CHECK(chunked == whole);
+    logger.log(TestLogger::Level::SUCCESS, 
+        "Identical metrics from " + std::to_string(document.size()) + " chars in chunks");
+}
+
+void test_stop_fork_server_while_analyzing() {
+    TestLogger logger("Stop Fork Server While Analyzing");
+    
+    TextAnalyzer analyzer;
+    
+    if (!analyzer.is_available()) {
+        logger.log(TestLogger::Level::WARNING, "Agent not available");
+        return;
+    }
+    if (!analyzer.start_fork_server()) {
+        logger.log(TestLogger::Level::WARNING, "Fork server not started: " + analyzer.get_last_error());
+        return;
+    }
+    
+    // Analyses in flight keep the server alive; later ones fall back to one-shot interpreters
+    std::vector<std::thread> threads;
+    std::vector<std::optional<double>> grades(4);
+    for (size_t i = 0; i < grades.size(); ++i) {
+        threads.emplace_back([&analyzer, &grades, i] {
+            TextMetricsData metrics = analyzer.analyze("The sun warms the sea. Water rises as vapor and falls as rain.", "en");
+            grades[i] = metrics.flesch_kincaid_grade;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    analyzer.stop_fork_server();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    for (const auto& grade : grades) {
+        CHECK(grade && grade == grades[0]);
+    }
+    CHECK(analyzer.fork_server_stats()["running"] == false);
+    logger.log(TestLogger::Level::SUCCESS, "All analyses completed across the stop");
+}
+
 // ============================================================================
 // ГЛАВНАЯ ФУНКЦИЯ
 // ============================================================================
@@ -437,14 +537,16 @@ int main() {
     
     auto overall_start = std::chrono::high_resolution_clock::now();
     
-    std::vector<std::pair<std::string, std::function<void()>>> tests = {
+    const std::vector<TestCase> tests = {
         {"Agent Creation", test_agent_creation},
         {"EMPI Protocol", test_empi_protocol},
         {"Error Handling", test_error_handling},
         {"Sample Text File", test_sample_text_file},
         {"Actual Analysis", test_actual_analysis},
         {"Agent State", test_agent_state},
-        {"Edge Cases", test_edge_cases}
+        {"Edge Cases", test_edge_cases},
+        {"Chunked Matches Whole", test_chunked_matches_whole},
+        {"Stop Fork Server While Analyzing", test_stop_fork_server_while_analyzing}
     };
     
     int tests_passed = 0;
@@ -0,0 +1,74 @@
+/**
+ * @file test_traffic_capture.cpp
+ * @brief Unit tests for the EMPI request capture log
+ */
+
+#include "../src/core/TrafficCapture.hpp"
+#include "TestCheck.hpp"
+#include <iostream>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EMPI;
+
+const std::string kPath = (std::filesystem::temp_directory_path() / "empi_capture_test.bin").string();
+
+void test_roundtrip() {
+    {
+        TrafficCapture capture(kPath);
+        capture.record({10, 2000, "text_analyzer", "text_metrics", {{"text", "Water evaporates."}}});
+        capture.record({25, 9000, "interface_generator", "html_generation",
+                        {{"text_metrics", json::object()}, {"feedback_analysis", {{"topics", {"water"}}}}}});
+        CHECK(capture.records() == 2);
+    }
+
+    auto requests = TrafficCapture::read_log(kPath);
+    CHECK(requests.size() == 2);
+    CHECK(requests[0].arrival_ns == 10 && requests[0].latency_ns == 2000);
+    CHECK(requests[0].agent_id == "text_analyzer" && requests[0].task_type == "text_metrics");
+    CHECK(requests[0].input["text"] == "Water evaporates.");
+    CHECK(requests[1].input["feedback_analysis"]["topics"][0] == "water");
+}
+
+void test_truncated_tail() {
+    {
+        TrafficCapture capture(kPath);
+        capture.record({1, 1, "text_analyzer", "text_metrics", {{"text", "a"}}});
+        capture.record({2, 1, "text_analyzer", "text_metrics", {{"text", "b"}}});
+    }
+    std::filesystem::resize_file(kPath, std::filesystem::file_size(kPath) - 3);
+
+    auto requests = TrafficCapture::read_log(kPath);
+    CHECK(requests.size() == 1);
+    CHECK(requests[0].input["text"] == "a");
+}
+
+void test_rejects_other_files() {
+    {
+        std::FILE* f = std::fopen(kPath.c_str(), "wb");
+        std::fputs("{\"not\": \"a capture\"}", f);
+        std::fclose(f);
+    }
+    bool threw = false;
+    try {
+        TrafficCapture::read_log(kPath);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main() {
+    const std::vector<TestCase> tests = {
+        {"Roundtrip", test_roundtrip},
+        {"Truncated Tail", test_truncated_tail},
+        {"Rejects Other Files", test_rejects_other_files}
+    };
+
+    int result = run_tests(tests);
+    std::remove(kPath.c_str());
+    return result;
+}
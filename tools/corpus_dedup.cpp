@@ -0,0 +1,122 @@
+/**
+ * @file corpus_dedup.cpp
+ * @brief Clusters near-duplicate texts of a corpus and writes a dedup report
+ *
+ * Accepts the tests/texts.json layout ({"texts": [{"id", "content"}]}) or
+ * JSON Lines with one {"id", "content"} object per line. JSON Lines input is
+ * streamed in batches, so corpora larger than memory only cost their
+ * signatures.
+ *
+ * Usage:
+ *   empi_dedup corpus.json|corpus.jsonl [--threshold 0.8] [--shingle 3]
+ *              [--threads N] [--batch 4096] [-o report.json]
+ */
+
+#include "../src/core/MinHash.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace EMPI;
+
+namespace {
+
+bool ends_with(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string corpus_path;
+    std::string report_path;
+    size_t batch_size = 4096;
+    MinHashConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            config.threshold = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--shingle") == 0 && i + 1 < argc) {
+            config.shingle_words = std::strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_size = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (argv[i][0] != '-') {
+            corpus_path = argv[i];
+        }
+    }
+    if (corpus_path.empty()) {
+        std::cerr << "Usage: empi_dedup corpus.json|corpus.jsonl [--threshold 0.8] [--shingle 3] "
+                     "[--threads N] [--batch 4096] [-o report.json]\n";
+        return 1;
+    }
+
+    std::ifstream in(corpus_path);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open file: " << corpus_path << "\n";
+        return 1;
+    }
+
+    MinHashDeduplicator deduplicator(config);
+    std::vector<std::string> ids;
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        if (ends_with(corpus_path, ".jsonl")) {
+            std::vector<std::string> batch;
+            std::string line;
+            auto flush = [&] {
+                deduplicator.add_batch(batch);
+                batch.clear();
+            };
+            while (std::getline(in, line)) {
+                if (line.empty()) continue;
+                json item = json::parse(line);
+                ids.push_back(item.value("id", std::to_string(ids.size())));
+                batch.push_back(item.value("content", ""));
+                if (batch.size() == batch_size) flush();
+            }
+            flush();
+        } else {
+            json corpus;
+            in >> corpus;
+            std::vector<std::string> batch;
+            for (const auto& item : corpus.at("texts")) {
+                ids.push_back(item.value("id", std::to_string(ids.size())));
+                batch.push_back(item.value("content", ""));
+            }
+            deduplicator.add_batch(batch);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error reading corpus: " << e.what() << "\n";
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    json report = deduplicator.report(ids);
+    report["seconds"] = elapsed;
+
+    std::cout << report["documents"] << " documents, " << report["representatives"] << " representatives, "
+              << report["duplicates"] << " duplicates in " << report["clusters"].size() << " clusters ("
+              << elapsed << " s)\n";
+    for (const auto& cluster : report["clusters"]) {
+        std::cout << "  " << cluster["representative"].get<std::string>() << ":";
+        for (const auto& duplicate : cluster["duplicates"]) {
+            std::cout << " " << duplicate["id"].get<std::string>();
+        }
+        std::cout << "\n";
+    }
+
+    if (!report_path.empty()) {
+        std::ofstream out(report_path);
+        out << report.dump(2) << "\n";
+        std::cout << "Report written to " << report_path << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file empi_replay.cpp
+ * @brief Replays a captured EMPI request log and compares latency distributions
+ *
+ * Requests are dispatched to fresh agents at their recorded arrival times
+ * scaled by --speed, each on its own thread, so requests that overlapped in
+ * production overlap in the replay. --speed 0 runs them one after another.
+ * For every agent/task the report gives the captured latency distribution
+ * and the replayed one: service time (process_raw only) and response time
+ * (from the scheduled arrival, so it includes any wait for the agent).
+ *
+ * Usage:
+ *   empi_replay capture.bin [-m model.gguf] [--speed 1.0]
+ *               [--baseline previous_report.json] [-o report.json]
+ *
+ * Record traffic with EMPI_CAPTURE=capture.bin in the environment of any
+ * program using the agents, or UniversalAgent::set_capture().
+ */
+
+#include "../src/agents/TextAnalyzer.hpp"
+#include "../src/agents/FeedbackAgent.hpp"
+#include "../src/agents/InterfaceGenerator.hpp"
+#include "../src/core/TrafficCapture.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+namespace {
+
+json latency_summary(std::vector<double> ms) {
+    if (ms.empty()) {
+        return {{"count", 0}};
+    }
+    std::sort(ms.begin(), ms.end());
+    auto pct = [&ms](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(ms.size() - 1) + 0.5);
+        return ms[std::min(index, ms.size() - 1)];
+    };
+    double sum = 0.0;
+    for (double v : ms) sum += v;
+    return {
+        {"count", ms.size()},
+        {"mean_ms", sum / static_cast<double>(ms.size())},
+        {"p50_ms", pct(0.50)},
+        {"p90_ms", pct(0.90)},
+        {"p99_ms", pct(0.99)},
+        {"max_ms", ms.back()}
+    };
+}
+
+std::unique_ptr<UniversalAgent> make_agent(const std::string& agent_id, const std::string& model_path) {
+    if (agent_id == "text_analyzer") return std::make_unique<TextAnalyzer>();
+    if (agent_id == "feedback_agent") return std::make_unique<FeedbackAgent>(model_path);
+    if (agent_id == "interface_generator") return std::make_unique<InterfaceGenerator>(model_path);
+    return nullptr;
+}
+
+struct Series {
+    std::vector<double> recorded_ms;
+    std::vector<double> service_ms;
+    std::vector<double> response_ms;
+    size_t errors = 0;
+};
+
+void print_row(const std::string& label, const json& summary) {
+    if (summary.value("count", 0) == 0) return;
+    std::cout << "  " << std::left << std::setw(12) << label << std::right
+              << " p50 " << std::setw(9) << summary["p50_ms"].get<double>()
+              << "  p90 " << std::setw(9) << summary["p90_ms"].get<double>()
+              << "  p99 " << std::setw(9) << summary["p99_ms"].get<double>()
+              << "  max " << std::setw(9) << summary["max_ms"].get<double>() << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string capture_path;
+    std::string model_path = "models/Phi-3-mini-4k-instruct-q4.gguf";
+    std::string baseline_path;
+    std::string report_path;
+    double speed = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (argv[i][0] != '-') {
+            capture_path = argv[i];
+        }
+    }
+    if (capture_path.empty()) {
+        std::cerr << "Usage: empi_replay capture.bin [-m model] [--speed 1.0] [--baseline report.json] [-o report.json]\n";
+        return 1;
+    }
+
+    std::vector<CapturedRequest> requests;
+    try {
+        requests = TrafficCapture::read_log(capture_path);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::stable_sort(requests.begin(), requests.end(),
+                     [](const CapturedRequest& a, const CapturedRequest& b) { return a.arrival_ns < b.arrival_ns; });
+    std::cout << "Replaying " << requests.size() << " requests at "
+              << (speed > 0.0 ? std::to_string(speed) + "x" : std::string("max")) << " speed\n";
+
+    // Agents are created before the clock starts so that model loading is not replayed as latency
+    std::map<std::string, std::unique_ptr<UniversalAgent>> agents;
+    size_t skipped = 0;
+    for (const auto& request : requests) {
+        auto& agent = agents[request.agent_id];
+        if (!agent) {
+            agent = make_agent(request.agent_id, model_path);
+            // The replay must not capture itself
+            if (agent) agent->set_capture(nullptr);
+        }
+        if (!agent) skipped++;
+    }
+
+    struct Outcome {
+        bool ran = false;
+        bool error = false;
+        double service_ms = 0.0;
+        double response_ms = 0.0;
+    };
+    std::vector<Outcome> outcomes(requests.size());
+    std::atomic<size_t> done{0};
+
+    auto run = [&](size_t i, std::chrono::steady_clock::time_point scheduled) {
+        const CapturedRequest& request = requests[i];
+        auto begin = std::chrono::steady_clock::now();
+        json response = agents.at(request.agent_id)->process_raw(request.input, request.task_type);
+        auto end = std::chrono::steady_clock::now();
+
+        Outcome& outcome = outcomes[i];
+        outcome.ran = true;
+        outcome.error = response["payload"]["data"].value("status", "") == "error";
+        outcome.service_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        outcome.response_ms = std::chrono::duration<double, std::milli>(end - scheduled).count();
+        done++;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    int64_t first_arrival = requests.empty() ? 0 : requests.front().arrival_ns;
+    std::vector<std::thread> in_flight;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        const CapturedRequest& request = requests[i];
+        if (!agents[request.agent_id]) continue;
+
+        if (speed <= 0.0) {
+            run(i, std::chrono::steady_clock::now());
+            std::cout << "\r" << done << "/" << requests.size() << std::flush;
+            continue;
+        }
+        // Each request starts at its own arrival time, so a slow one does not delay the ones behind it
+        auto scheduled = start + std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(request.arrival_ns - first_arrival) / speed));
+        std::this_thread::sleep_until(scheduled);
+        in_flight.emplace_back(run, i, scheduled);
+        std::cout << "\r" << done << "/" << requests.size() << std::flush;
+    }
+    for (auto& thread : in_flight) {
+        thread.join();
+    }
+
+    std::map<std::string, Series> series;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!outcomes[i].ran) continue;
+        Series& s = series[requests[i].agent_id + "/" + requests[i].task_type];
+        s.recorded_ms.push_back(static_cast<double>(requests[i].latency_ns) / 1e6);
+        s.service_ms.push_back(outcomes[i].service_ms);
+        s.response_ms.push_back(outcomes[i].response_ms);
+        if (outcomes[i].error) s.errors++;
+    }
+    std::cout << "\r" << done << "/" << requests.size();
+    std::cout << "\n\n";
+
+    json baseline;
+    if (!baseline_path.empty()) {
+        std::ifstream in(baseline_path);
+        if (in.is_open()) in >> baseline;
+    }
+
+    json report = {
+        {"capture", capture_path},
+        {"speed", speed},
+        {"requests", requests.size()},
+        {"skipped", skipped},
+        {"series", json::object()}
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (auto& [key, s] : series) {
+        json entry = {
+            {"errors", s.errors},
+            {"recorded", latency_summary(s.recorded_ms)},
+            {"service", latency_summary(s.service_ms)},
+            {"response", latency_summary(s.response_ms)}
+        };
+
+        std::cout << key << " (" << s.service_ms.size() << " requests, " << s.errors << " errors)\n";
+        print_row("captured", entry["recorded"]);
+        if (baseline.contains("series") && baseline["series"].contains(key)) {
+            print_row("baseline", baseline["series"][key]["service"]);
+            double before = baseline["series"][key]["service"].value("p50_ms", 0.0);
+            double after = entry["service"].value("p50_ms", 0.0);
+            if (before > 0.0) entry["p50_change"] = after / before - 1.0;
+        }
+        print_row("service", entry["service"]);
+        print_row("response", entry["response"]);
+        if (entry.contains("p50_change")) {
+            std::cout << "  p50 vs baseline: " << std::showpos << entry["p50_change"].get<double>() * 100.0
+                      << std::noshowpos << "%\n";
+        }
+        report["series"][key] = entry;
+    }
+
+    if (!report_path.empty()) {
+        std::ofstream out(report_path);
+        out << report.dump(2) << "\n";
+        std::cout << "Report written to " << report_path << "\n";
+    }
+    return 0;
+}
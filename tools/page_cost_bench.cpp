@@ -0,0 +1,212 @@
+/**
+ * @file page_cost_bench.cpp
+ * @brief Cost-per-valid-page benchmark for InterfaceGenerator
+ *
+ * Runs a fixed set of (text, profile) pairs through InterfaceGenerator,
+ * validates each page in-process (see PageValidator) and retries invalid
+ * pages. Reports tokens, wall time and CPU-seconds per valid page plus the
+ * first-pass validity rate, so model, sampler and constraint changes can be
+ * compared on one number.
+ *
+ * Without a model the generator's fallback template is measured, which
+ * exercises the harness and the validator with zero tokens.
+ *
+ * Usage:
+ *   empi_page_cost_bench -m model.gguf [-n pairs] [-r retries]
+ *                        [--texts tests/texts.json] [--dialogs tests/dialogs.json]
+ *                        [--spec | --sections] [--mlock] [--huge-pages] [-o report.json]
+ *
+ * --spec generates pages in OutputMode::ContentSpec, to compare its tokens
+ * per valid page against full-HTML generation; --sections uses
+ * OutputMode::Sections (outline, then parallel section bodies).
+ * --mlock / --huge-pages apply InterfaceGenerator::configure_memory() before
+ * the run; the report's "memory" shows resident vs mapped bytes either way.
+ */
+
+#include "../src/agents/InterfaceGenerator.hpp"
+#include "../src/core/PageValidator.hpp"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+using namespace EMPI;
+using json = nlohmann::json;
+
+namespace {
+
+json load_json_file(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open file: " + filename);
+    }
+    json data;
+    file >> data;
+    return data;
+}
+
+struct Totals {
+    uint64_t prompt_tokens = 0;
+    uint64_t generated_tokens = 0;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+};
+
+double per(double value, size_t count) {
+    return count ? value / static_cast<double>(count) : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string model_path = "models/Phi-3-mini-4k-instruct-q4.gguf";
+    std::string texts_path = "../tests/texts.json";
+    std::string dialogs_path = "../tests/dialogs.json";
+    std::string report_path;
+    size_t num_pairs = 20;
+    int max_retries = 2;
+    OutputMode output_mode = OutputMode::Html;
+    ResidencyConfig residency;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_pairs = std::stoul(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            max_retries = std::stoi(argv[++i]);
+        } else if (strcmp(argv[i], "--texts") == 0 && i + 1 < argc) {
+            texts_path = argv[++i];
+        } else if (strcmp(argv[i], "--dialogs") == 0 && i + 1 < argc) {
+            dialogs_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (strcmp(argv[i], "--spec") == 0) {
+            output_mode = OutputMode::ContentSpec;
+        } else if (strcmp(argv[i], "--sections") == 0) {
+            output_mode = OutputMode::Sections;
+        } else if (strcmp(argv[i], "--mlock") == 0) {
+            residency.mlock = true;
+        } else if (strcmp(argv[i], "--huge-pages") == 0) {
+            residency.huge_pages = true;
+        }
+    }
+
+    json texts, dialogues;
+    try {
+        texts = load_json_file(texts_path)["texts"];
+        dialogues = load_json_file(dialogs_path)["dialogues"];
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading data files: " << e.what() << "\n";
+        return 1;
+    }
+    if (texts.empty() || dialogues.empty()) {
+        std::cerr << "Empty benchmark data\n";
+        return 1;
+    }
+
+    InterfaceGenerator generator(model_path);
+    // Every attempt must reach the model; cached pages would hide the cost
+    SemanticCacheConfig no_cache;
+    no_cache.enabled = false;
+    generator.configure_cache(no_cache);
+    generator.set_output_mode(output_mode);
+    json memory_setup = generator.configure_memory(residency);
+
+    std::cout << "InterfaceGenerator: " << (generator.is_available() ? "model" : "fallback template") << "\n";
+    std::cout << "Pairs: " << num_pairs << ", max retries: " << max_retries << "\n\n";
+
+    Totals totals;
+    size_t valid_pages = 0;
+    size_t first_pass_valid = 0;
+    size_t retries = 0;
+    std::map<std::string, size_t> errors_by_criterion;
+
+    for (size_t i = 0; i < num_pairs; ++i) {
+        // Fixed pairing: stride through dialogues so neighbouring texts get different profiles
+        const json& text = texts[i % texts.size()];
+        const json& dialogue = dialogues[(i * 7) % dialogues.size()];
+        ProfileFlags profile = derive_profile_flags(dialogue["history"], FeedbackAnalysisData{});
+
+        bool valid = false;
+        for (int attempt = 0; attempt <= max_retries && !valid; ++attempt) {
+            auto wall_start = std::chrono::steady_clock::now();
+            std::clock_t cpu_start = std::clock();
+
+            HTMLGenerationData page;
+            PageValidation validation;
+            try {
+                page = generator.generate(TextMetricsData{}, FeedbackAnalysisData{},
+                                          text.value("content", ""), profile);
+                validation = validate_page(page.html);
+            } catch (const std::exception& e) {
+                // e.g. a content spec cut off by the token budget
+                validation.valid = false;
+                validation.issues.push_back({"generation", "", IssueSeverity::Error, e.what()});
+            }
+
+            totals.cpu_seconds += static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+            totals.wall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+            if (page.extra.contains("tokens")) {
+                totals.prompt_tokens += page.extra["tokens"].value("prompt", 0ull);
+                totals.generated_tokens += page.extra["tokens"].value("generated", 0ull);
+            }
+
+            valid = validation.valid;
+            if (attempt > 0) retries++;
+            if (valid && attempt == 0) first_pass_valid++;
+            for (const auto& issue : validation.issues) {
+                if (issue.severity == IssueSeverity::Error) errors_by_criterion[issue.criterion]++;
+            }
+        }
+        if (valid) valid_pages++;
+
+        std::cout << "\r" << (i + 1) << "/" << num_pairs << " pages, " << valid_pages << " valid" << std::flush;
+    }
+    std::cout << "\n\n";
+
+    uint64_t total_tokens = totals.prompt_tokens + totals.generated_tokens;
+    json report = {
+        {"mode", generator.is_available() ? "model" : "fallback"},
+        {"output_mode", output_mode == OutputMode::ContentSpec ? "content_spec"
+                      : output_mode == OutputMode::Sections ? "sections" : "html"},
+        {"model", model_path},
+        {"pairs", num_pairs},
+        {"max_retries", max_retries},
+        {"memory", {{"setup", memory_setup}, {"after_run", generator.get_memory_report()}}},
+        {"valid_pages", valid_pages},
+        {"first_pass_valid_rate", per(static_cast<double>(first_pass_valid), num_pairs)},
+        {"retries", retries},
+        {"errors_by_criterion", errors_by_criterion},
+        {"totals", {
+            {"prompt_tokens", totals.prompt_tokens},
+            {"generated_tokens", totals.generated_tokens},
+            {"wall_seconds", totals.wall_seconds},
+            {"cpu_seconds", totals.cpu_seconds}
+        }},
+        {"per_valid_page", {
+            {"tokens", per(static_cast<double>(total_tokens), valid_pages)},
+            {"generated_tokens", per(static_cast<double>(totals.generated_tokens), valid_pages)},
+            {"wall_seconds", per(totals.wall_seconds, valid_pages)},
+            {"cpu_seconds", per(totals.cpu_seconds, valid_pages)}
+        }}
+    };
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Valid pages:             " << valid_pages << "/" << num_pairs << "\n";
+    std::cout << "First-pass validity:     " << report["first_pass_valid_rate"].get<double>() * 100.0 << "%\n";
+    std::cout << "Retries:                 " << retries << "\n";
+    std::cout << "CPU-seconds/valid page:  " << report["per_valid_page"]["cpu_seconds"].get<double>() << "\n";
+    std::cout << "Wall seconds/valid page: " << report["per_valid_page"]["wall_seconds"].get<double>() << "\n";
+    std::cout << "Tokens/valid page:       " << report["per_valid_page"]["tokens"].get<double>() << "\n";
+
+    if (!report_path.empty()) {
+        std::ofstream out(report_path);
+        out << report.dump(2) << "\n";
+        std::cout << "Report written to " << report_path << "\n";
+    }
+    return valid_pages == num_pairs ? 0 : 2;
+}